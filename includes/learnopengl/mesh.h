@@ -7,6 +7,9 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <learnopengl/shader.h>
+#include <solarsystem/drawstats.h>
+#include <solarsystem/glstate.h>
+#include <solarsystem/residency.h>
 
 #include <string>
 #include <fstream>
@@ -28,6 +31,13 @@ struct Vertex {
     glm::vec3 Bitangent;
 };
 
+// a level of detail: a range of the index buffer, over the same vertices
+struct LodLevel {
+    unsigned int first; // first index
+    unsigned int count; // indices
+    float error;        // largest deviation from the full mesh, in model units
+};
+
 struct Texture {
     unsigned int id;
     string type;
@@ -40,31 +50,66 @@ public:
     vector<Vertex> vertices;
     vector<unsigned int> indices;
     vector<Texture> textures;
+    vector<string> samplers; // uniform of each texture (texture_diffuse1, ...)
+    vector<LodLevel> lods;  // full detail first; indices holds every level
+    unsigned int lod;       // level drawn
+    glm::vec3 center;       // bounding sphere, in model units
+    float radius;
     unsigned int VAO;
+    GLenum indexType; // GL_UNSIGNED_SHORT when every index fits in 16 bits
 
     /*  Functions  */
     // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, vector<LodLevel> lods = vector<LodLevel>())
     {
         this->vertices = vertices;
         this->indices = indices;
         this->textures = textures;
+        this->samplers = samplerNames(textures);
+        this->lods = lods;
+        if(this->lods.empty())
+        {
+            LodLevel full = {0, (unsigned int) indices.size(), 0.0f};
+            this->lods.push_back(full);
+        }
+        lod = 0;
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
         setupMesh();
     }
 
-    // render the mesh
+    // render the mesh; binds that are already in place are skipped by GLState,
+    // so nothing is unbound afterwards
     void Draw(Shader shader) 
     {
         // bind appropriate textures
+        for(unsigned int i = 0; i < textures.size(); i++)
+        {
+            // set the sampler to the correct texture unit
+            GLState::uniform1i(GLState::uniformLocation(shader.ID, samplers[i]), i);
+            // and bind the texture there (the active unit only changes when it is not bound yet)
+            Residency::useTexture(textures[i].id);
+            GLState::bindTextureUnit(i, GL_TEXTURE_2D, textures[i].id);
+        }
+        
+        // draw mesh (buffers evicted by the residency manager are uploaded again first)
+        Residency::useMesh(VAO, &vertices[0], vertices.size() * sizeof(Vertex), indexData(), indexBytes());
+        const LodLevel &level = lods[lod];
+        GLState::bindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, level.count, indexType, (void*)(level.first * (unsigned long) indexSize()));
+        DrawStats::add(level.count / 3);
+    }
+
+    // sampler names as the shaders declare them: texture_diffuseN, texture_specularN, texture_normalN and texture_heightN
+    static vector<string> samplerNames(const vector<Texture> &textures)
+    {
         unsigned int diffuseNr  = 1;
         unsigned int specularNr = 1;
         unsigned int normalNr   = 1;
         unsigned int heightNr   = 1;
+        vector<string> names;
         for(unsigned int i = 0; i < textures.size(); i++)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
             // retrieve texture number (the N in diffuse_textureN)
             string number;
             string name = textures[i].type;
@@ -76,36 +121,65 @@ public:
 				number = std::to_string(normalNr++); // transfer unsigned int to stream
              else if(name == "texture_height")
 			    number = std::to_string(heightNr++); // transfer unsigned int to stream
-
-													 // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            names.push_back(name + number);
         }
-        
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        return names;
+    }
 
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
+    // picks the coarsest level whose error covers at most maxPixels on screen
+    void selectLod(float pixelsPerUnit, float maxPixels)
+    {
+        lod = 0;
+        while(lod + 1 < lods.size() && lods[lod + 1].error * pixelsPerUnit <= maxPixels)
+            lod++;
+    }
+
+    unsigned int indexSize() const
+    {
+        return indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+    }
+
+    // the index buffer as uploaded, 16 or 32 bits per index
+    const void *indexData() const
+    {
+        return indexType == GL_UNSIGNED_SHORT ? (const void *) &shortIndices[0] : (const void *) &indices[0];
+    }
+
+    unsigned long indexBytes() const
+    {
+        return indexType == GL_UNSIGNED_SHORT ? shortIndices.size() * sizeof(unsigned short) : indices.size() * sizeof(unsigned int);
     }
 
 private:
     /*  Render data  */
     unsigned int VBO, EBO;
+    vector<unsigned short> shortIndices;
 
     /*  Functions    */
     // initializes all the buffer objects/arrays
     void setupMesh()
     {
+        // half the index memory and bandwidth when the vertices can be addressed with 16 bits
+        indexType = vertices.size() <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        if(indexType == GL_UNSIGNED_SHORT)
+            shortIndices.assign(indices.begin(), indices.end());
+
+        // bounding sphere around the box, for the level of detail
+        glm::vec3 low(0.0f), high(0.0f);
+        for(unsigned int i = 0; i < vertices.size(); i++)
+        {
+            low = i ? glm::min(low, vertices[i].Position) : vertices[i].Position;
+            high = i ? glm::max(high, vertices[i].Position) : vertices[i].Position;
+        }
+        center = (low + high) * 0.5f;
+        radius = glm::length(high - low) * 0.5f;
+
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
-        glBindVertexArray(VAO);
+        GLState::bindVertexArray(VAO);
         // load data into vertex buffers
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
         // A great thing about structs is that their memory layout is sequential for all its items.
@@ -114,7 +188,7 @@ private:
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes(), indexData(), GL_STATIC_DRAW);
 
         // set the vertex attribute pointers
         // vertex Positions
@@ -133,7 +207,8 @@ private:
         glEnableVertexAttribArray(4);
         glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
 
-        glBindVertexArray(0);
+        GLState::bindVertexArray(0);
+        Residency::addMesh(VAO, VBO, EBO, vertices.size() * sizeof(Vertex) + indexBytes());
     }
 };
 #endif
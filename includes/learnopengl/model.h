@@ -12,6 +12,11 @@
 
 #include <learnopengl/mesh.h>
 #include <learnopengl/shader.h>
+#include <solarsystem/trace.h>
+#include <solarsystem/residency.h>
+#include <solarsystem/vfs.h>
+#include <solarsystem/meshcook.h>
+#include <solarsystem/simplify.h>
 
 #include <string>
 #include <fstream>
@@ -21,7 +26,32 @@
 #include <vector>
 using namespace std;
 
+// decoded image, kept in memory until it is uploaded
+struct ImageData {
+    string path;                  // as written in the material
+    int width, height, components; // of the full resolution image
+    int level;                    // mip level held in pixels (0 = full resolution)
+    vector<unsigned char> pixels; // empty when decoding failed
+};
+
+// mesh arrays and the textures it uses (indices into ModelData::images)
+struct MeshData {
+    vector<Vertex> vertices;
+    vector<unsigned int> indices;                 // every level of detail, full first
+    vector<LodLevel> lods;                        // empty: only the full mesh
+    vector<pair<string, unsigned int> > textures; // sampler type, image
+};
+
+// everything read from disk for a model, without any OpenGL call, so it can be built on another thread
+struct ModelData {
+    bool loaded;
+    string directory;
+    vector<MeshData> meshes;
+    vector<ImageData> images;
+};
+
 unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
+unsigned int TextureFromImage(const ImageData &image, const string &file = "");
 
 class Model 
 {
@@ -32,67 +62,83 @@ public:
     string directory;
     bool gammaCorrection;
 
+    // creates the IO handler assimp reads through (the importer takes ownership); NULL reads from disk
+    static Assimp::IOSystem *(*ioSystem)();
+
     /*  Functions   */
     // constructor, expects a filepath to a 3D model.
     Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
     {
-        loadModel(path);
+        ModelData data = import(path);
+        upload(data);
     }
 
-    // draws the model, and thus all its meshes
-    void Draw(Shader shader)
+    // constructor from data imported earlier (on any thread); creates the buffers and textures
+    Model(const ModelData &data, bool gamma = false) : gammaCorrection(gamma)
     {
-        for(unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
+        upload(data);
     }
-    
-private:
-    /*  Functions   */
-    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
-    void loadModel(string const &path)
+
+    // reads the model and decodes its textures; touches no OpenGL state
+    // (lods: also builds the simplified levels of each mesh, slow enough for a worker thread)
+    static ModelData import(string const &path, bool lods = false)
     {
+        TRACE_ZONE("Model::import");
+        ModelData data;
+        data.loaded = false;
+
         // read file via ASSIMP
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        // the model and its materials can be read through another file system, such as the asset pack
+        if(ioSystem)
+            importer.SetIOHandler(ioSystem());
+        const aiScene* scene;
+        {
+            // includes the post-processing steps (triangulation, tangent space)
+            TRACE_ZONE("Assimp::ReadFile");
+            scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        }
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
-            return;
+            return data;
         }
         // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
+        data.directory = path.substr(0, path.find_last_of('/'));
 
         // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+        processNode(scene->mRootNode, scene, data, lods);
+        data.loaded = true;
+        return data;
     }
 
-    // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode *node, const aiScene *scene)
+    // draws the model, and thus all its meshes
+    void Draw(Shader shader)
     {
-        // process each mesh located at the current node
-        for(unsigned int i = 0; i < node->mNumMeshes; i++)
-        {
-            // the node object only contains indices to index the actual objects in the scene. 
-            // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
-        }
-        // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
-        for(unsigned int i = 0; i < node->mNumChildren; i++)
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].Draw(shader);
+    }
+
+    // picks each mesh's level of detail by its size on screen
+    // (focal: pixels per unit at distance 1, maxPixels: deviation allowed on screen)
+    void selectLod(const glm::mat4 &model, const glm::vec3 &eye, float focal, float maxPixels)
+    {
+        float scale = glm::length(glm::vec3(model[0]));
+        for(unsigned int i = 0; i < meshes.size(); i++)
         {
-            processNode(node->mChildren[i], scene);
+            glm::vec3 center = glm::vec3(model * glm::vec4(meshes[i].center, 1.0f));
+            float distance = glm::length(center - eye) - meshes[i].radius * scale;
+            if(distance <= 0.0f)
+                meshes[i].lod = 0;
+            else
+                meshes[i].selectLod(scale * focal / distance, maxPixels);
         }
-
     }
 
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene)
+    // converts the assimp vertices (position, normal, uv, tangent space) and faces into the mesh arrays
+    static void processVertices(const aiMesh *mesh, vector<Vertex> &vertices, vector<unsigned int> &indices)
     {
-        // data to fill
-        vector<Vertex> vertices;
-        vector<unsigned int> indices;
-        vector<Texture> textures;
-
         // Walk through each of the mesh's vertices
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
         {
@@ -140,6 +186,73 @@ private:
             for(unsigned int j = 0; j < face.mNumIndices; j++)
                 indices.push_back(face.mIndices[j]);
         }
+    }
+    
+    // creates the textures and meshes of imported data
+    void upload(const ModelData &data)
+    {
+        TRACE_ZONE("Model::upload");
+        directory = data.directory;
+
+        // each image becomes a texture once, shared by the meshes that use it
+        for(unsigned int i = 0; i < data.images.size(); i++)
+        {
+            Texture texture;
+            texture.id = TextureFromImage(data.images[i], directory + '/' + data.images[i].path);
+            texture.path = data.images[i].path;
+            textures_loaded.push_back(texture);
+        }
+
+        for(unsigned int i = 0; i < data.meshes.size(); i++)
+        {
+            const MeshData &mesh = data.meshes[i];
+            vector<Texture> textures;
+            for(unsigned int j = 0; j < mesh.textures.size(); j++)
+            {
+                Texture texture = textures_loaded[mesh.textures[j].second];
+                texture.type = mesh.textures[j].first;
+                textures.push_back(texture);
+            }
+            meshes.push_back(Mesh(mesh.vertices, mesh.indices, textures, mesh.lods));
+        }
+    }
+
+private:
+    /*  Functions   */
+    // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
+    static void processNode(aiNode *node, const aiScene *scene, ModelData &data, bool lods)
+    {
+        // process each mesh located at the current node
+        for(unsigned int i = 0; i < node->mNumMeshes; i++)
+        {
+            // the node object only contains indices to index the actual objects in the scene. 
+            // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
+            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+            data.meshes.push_back(processMesh(mesh, scene, data, lods));
+        }
+        // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
+        for(unsigned int i = 0; i < node->mNumChildren; i++)
+        {
+            processNode(node->mChildren[i], scene, data, lods);
+        }
+
+    }
+
+    static MeshData processMesh(aiMesh *mesh, const aiScene *scene, ModelData &data, bool lods)
+    {
+        TRACE_ZONE("Model::processMesh");
+        // data to fill
+        MeshData x;
+
+        // vertex and index conversion, shared with the benchmarks
+        processVertices(mesh, x.vertices, x.indices);
+        // welds the vertices and reorders both arrays for the vertex cache, overdraw and fetch locality
+        if(MeshCook::enabled)
+            MeshCook::cook(x.vertices, x.indices);
+        // simplified levels over the same vertices, their indices after the full mesh's
+        if(lods)
+            Simplify::lods(x.vertices, x.indices, x.lods);
+
         // process materials
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];    
         // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
@@ -150,94 +263,126 @@ private:
         // normal: texture_normalN
 
         // 1. diffuse maps
-        vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+        loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", x, data);
         // 2. specular maps
-        vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+        loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular", x, data);
         // 3. normal maps
-        std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-        textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+        loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal", x, data);
         // 4. height maps
-        std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-        textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
+        loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height", x, data);
         
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        return x;
     }
 
-    // checks all material textures of a given type and loads the textures if they're not loaded yet.
-    // the required info is returned as a Texture struct.
-    vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
+    // checks all material textures of a given type and decodes the images if they're not decoded yet.
+    static void loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName, MeshData &mesh, ModelData &data)
     {
-        vector<Texture> textures;
         for(unsigned int i = 0; i < mat->GetTextureCount(type); i++)
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
+            // check if the image was decoded before and if so, reuse it (optimization)
+            unsigned int j = 0;
+            while(j < data.images.size() && data.images[j].path != str.C_Str())
+                j++;
+            if(j == data.images.size())
             {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
+                TRACE_ZONE("stbi_load");
+                ImageData image;
+                image.path = str.C_Str();
+                image.width = image.height = image.components = 0;
+                image.level = 0;
+                string filename = data.directory + '/' + image.path;
+                if(Residency::streaming)
                 {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
+                    // only the coarse mips, read from the mip chain file; the rest is streamed by the residency manager
+                    MipInfo info;
+                    vector<vector<unsigned char> > levels;
+                    if(MipChain::info(filename, info) && MipChain::read(filename, MipChain::levelFor(info, Residency::initialSize), info, levels))
+                    {
+                        image.width = info.width;
+                        image.height = info.height;
+                        image.components = info.components;
+                        image.level = info.levels - (int) levels.size();
+                        image.pixels.swap(levels[0]);
+                    }
                 }
+                else
+                {
+                    unsigned char *pixels = Vfs::loadImage(filename, image.width, image.height, image.components, 0);
+                    if(pixels)
+                        image.pixels.assign(pixels, pixels + image.width * image.height * image.components);
+                    stbi_image_free(pixels);
+                }
+                if(image.pixels.empty())
+                    std::cout << "Texture failed to load at path: " << image.path << std::endl;
+                data.images.push_back(image);
             }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-            }
+            mesh.textures.push_back(make_pair(typeName, j));
         }
-        return textures;
     }
 };
 
+Assimp::IOSystem *(*Model::ioSystem)() = NULL;
 
 unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
 {
+    TRACE_ZONE("TextureFromFile");
     string filename = string(path);
     filename = directory + '/' + filename;
 
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
+    ImageData image;
+    image.path = path;
+    image.width = image.height = image.components = 0;
+    image.level = 0;
+    unsigned char *data;
     {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
+        TRACE_ZONE("stbi_load");
+        data = Vfs::loadImage(filename, image.width, image.height, image.components, 0);
     }
+    if (data)
+        image.pixels.assign(data, data + image.width * image.height * image.components);
     else
-    {
         std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
+    stbi_image_free(data);
+
+    return TextureFromImage(image, filename);
+}
+
+// uploads a decoded image with mipmaps; an image that failed to decode gives an empty texture.
+// an image holding only a coarse mip defines that level and the smaller ones, with GL_TEXTURE_BASE_LEVEL
+// pointing at it. with the source file, the texture is handed to the residency manager, which streams
+// the finer levels in and drops them again later
+unsigned int TextureFromImage(const ImageData &image, const string &file)
+{
+    TRACE_ZONE("TextureFromFile::upload");
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    if (image.pixels.empty())
+        return textureID;
+
+    GLenum format;
+    if (image.components == 1)
+        format = GL_RED;
+    else if (image.components == 3)
+        format = GL_RGB;
+    else
+        format = GL_RGBA;
+
+    GLState::bindTexture(GL_TEXTURE_2D, textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, image.level, format, max(1, image.width >> image.level), max(1, image.height >> image.level), 0, format, GL_UNSIGNED_BYTE, &image.pixels[0]);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, image.level);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, MipChain::levelCount(image.width, image.height) - 1);
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
+    Residency::addTexture(textureID, file, image.width, image.height, image.components, image.level);
     return textureID;
 }
 #endif
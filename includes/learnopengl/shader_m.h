@@ -4,8 +4,11 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <solarsystem/glstate.h>
+#include <solarsystem/trace.h>
+#include <solarsystem/vfs.h>
+
 #include <string>
-#include <fstream>
 #include <sstream>
 #include <iostream>
 
@@ -17,37 +20,19 @@ public:
     // ------------------------------------------------------------------------
     Shader(const char* vertexPath, const char* fragmentPath)
     {
+        TRACE_ZONE("Shader::Shader");
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
         std::string fragmentCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        try 
-        {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();		
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();			
-        }
-        catch (std::ifstream::failure e)
+        // read through the virtual file layer: from the pack when one is mounted, otherwise from disk
+        if(!Vfs::readText(vertexPath, vertexCode) || !Vfs::readText(fragmentPath, fragmentCode))
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
         }
         const char* vShaderCode = vertexCode.c_str();
         const char * fShaderCode = fragmentCode.c_str();
         // 2. compile shaders
+        TRACE_ZONE("Shader::compile");
         unsigned int vertex, fragment;
         int success;
         char infoLog[512];
@@ -76,18 +61,18 @@ public:
     // ------------------------------------------------------------------------
     void use() const
     { 
-        glUseProgram(ID); 
+        GLState::useProgram(ID); // skipped when it is already in use
     }
     // utility uniform functions
     // ------------------------------------------------------------------------
     void setBool(const std::string &name, bool value) const
     {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+        GLState::uniform1i(GLState::uniformLocation(ID, name), (int)value); 
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string &name, int value) const
     { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        GLState::uniform1i(GLState::uniformLocation(ID, name), value); 
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string &name, float value) const
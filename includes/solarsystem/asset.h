@@ -0,0 +1,119 @@
+#ifndef ASSET_H
+#define ASSET_H
+
+#include <learnopengl/model.h>
+#include "trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+// Estado de um modelo carregado sob demanda
+enum AssetState {
+	ASSET_UNLOADED, // registrado, nada foi lido
+	ASSET_LOADING,  // a thread está lendo o arquivo e decodificando as texturas
+	ASSET_READY,    // na GPU, pronto para desenhar
+	ASSET_FAILED    // a leitura falhou; quem desenha continua com o substituto
+};
+
+// Modelo registrado sem ser carregado. O primeiro request() lê o arquivo e
+// decodifica as texturas numa thread (Model::import não chama OpenGL); o
+// poll() da thread principal envia tudo para a GPU quando a leitura termina.
+// Enquanto isso get() devolve NULL e quem desenha usa um substituto.
+class LazyModel {
+	protected:
+		string path;
+		atomic<int> state;
+		atomic<bool> imported;  // a thread terminou, data pode ser enviado
+		thread worker;
+		ModelData data;
+		Model *model;
+		chrono::steady_clock::time_point requested;
+
+	public:
+		double importMs;  // leitura e decodificação, na thread
+		double uploadMs;  // envio para a GPU, na thread principal
+		double totalMs;   // do pedido até ficar pronto
+
+		LazyModel(): state(ASSET_UNLOADED), imported(false){
+			model = NULL;
+			importMs = uploadMs = totalMs = 0.0;
+		}//LazyModel
+
+		~LazyModel(){
+			if(worker.joinable())
+				worker.join();
+			delete model;
+		}//~LazyModel
+
+		void setPath(const string &file){
+			path = file;
+		}//setPath
+
+		// Começa a leitura, se ainda não começou
+		void request(){
+			if(state != ASSET_UNLOADED)
+				return;
+
+			state = ASSET_LOADING;
+			requested = chrono::steady_clock::now();
+			worker = thread(&LazyModel::load, this);
+		}//request
+
+		/** Envia para a GPU o que a thread terminou de ler (thread principal)
+			* @return true no frame em que o modelo ficou pronto ou falhou
+			*/
+		bool poll(){
+			if(state != ASSET_LOADING or not imported)
+				return false;
+			// O wait() pode já ter esperado a thread
+			if(worker.joinable())
+				worker.join();
+
+			if(not data.loaded)
+				state = ASSET_FAILED;
+			else{
+				chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+				model = new Model(data);
+				uploadMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+				state = ASSET_READY;
+			}
+			totalMs = chrono::duration<double, milli>(chrono::steady_clock::now() - requested).count();
+
+			// Os pixels já estão na GPU
+			data = ModelData();
+			return true;
+		}//poll
+
+		// Pede e espera (modo sem janela, benchmark e replay: frames determinísticos)
+		void wait(){
+			request();
+			if(worker.joinable())
+				worker.join();
+			poll();
+		}//wait
+
+		// O modelo, ou NULL enquanto não estiver pronto
+		Model *get(){
+			return state == ASSET_READY ? model : NULL;
+		}//get
+
+		AssetState getState(){
+			return (AssetState) state.load();
+		}//getState
+
+	protected:
+		void load(){
+			TRACE_THREAD("asset");
+			chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+			// Os níveis de detalhe saem aqui, fora da thread principal
+			data = Model::import(path, true);
+			importMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+			imported = true;
+		}//load
+};
+
+#endif
@@ -0,0 +1,232 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <glad/glad.h>
+
+#include "camerapath.h"
+#include "drawstats.h"
+#include "glcaps.h"
+#include "glstate.h"
+#include "profiler.h"
+
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// GL_NVX_gpu_memory_info e GL_ATI_meminfo (não estão no glad)
+#define BENCHMARK_GPU_MEMORY_TOTAL_NVX     0x9048
+#define BENCHMARK_GPU_MEMORY_AVAILABLE_NVX 0x9049
+#define BENCHMARK_TEXTURE_FREE_MEMORY_ATI  0x87FC
+
+// Benchmark com roteiro de câmera: aquece, mede um número fixo de frames e
+// grava um relatório JSON com os percentis do tempo de frame, o tempo de CPU
+// e GPU de cada passo (do Profiler), draw calls, triângulos e memória.
+// O roteiro é percorrido inteiro tanto no aquecimento quanto na medição,
+// qualquer que seja o número de frames.
+class Benchmark {
+	protected:
+		string scenario;
+		CameraPath path;
+		unsigned int warmup, frames;
+		unsigned int frame;           // frame atual, contando o aquecimento
+		deque<float> frameTimes;      // ms
+		deque<float> drawCalls;
+		deque<float> triangles;
+		deque<float> stateCalls;      // trocas de estado enviadas ao driver
+		deque<float> stateElided;     // e evitadas por serem repetidas
+
+	public:
+		/** Carrega o roteiro
+			* @param name - Cenário embutido (tour, overview, planets, ship) ou arquivo de caminho
+			* @param warm - Frames de aquecimento
+			* @param count - Frames medidos
+			*/
+		bool load(const string &name, unsigned int warm, unsigned int count){
+			scenario = name;
+			warmup = max(warm, 1u); // o reset do perfil acontece no fim do aquecimento
+			frames = count;
+			frame = 0;
+
+			if(name == "tour")
+				path.builtin();
+			else if(name == "overview")
+				path.parse("0 mode 1\n");
+			else if(name == "planets")
+				path.parse("0 mode 2 0 -1\n1 mode 2 1 -1\n2 mode 2 2 -1\n3 mode 2 2 0\n4 mode 2 3 -1\n"
+						   "5 mode 2 4 -1\n6 mode 2 4 0\n7 mode 2 5 -1\n8 mode 2 6 -1\n9 mode 2 7 -1\n");
+			else if(name == "ship")
+				path.parse("0 mode 3\n");
+			else if(not path.load(name)){
+				cout << "ERROR::BENCHMARK:: Cenário desconhecido: " << name << " (tour, overview, planets, ship ou arquivo)" << endl;
+				return false;
+			}
+			return true;
+		}//load
+
+		// Memória residente atual e de pico do processo (kB), só no Linux
+		static void residentMemory(long &rss, long &peak){
+			ifstream status("/proc/self/status");
+			string key;
+			while(status >> key){
+				if(key == "VmRSS:")
+					status >> rss;
+				else if(key == "VmHWM:")
+					status >> peak;
+			}
+		}//residentMemory
+
+		bool uses(int mode){
+			return path.uses(mode);
+		}//uses
+
+		// Começa um frame: zera os contadores e devolve a câmera do roteiro
+		CameraKey begin(){
+			DrawStats::reset();
+
+			unsigned int span = measuring() ? frames : warmup;
+			unsigned int i = measuring() ? frame - warmup : frame;
+			return path.at(path.duration() * i / max(span, 1u));
+		}//begin
+
+		/** Termina um frame
+			* @param ms - Tempo do frame
+			* @return true quando o benchmark acabou
+			*/
+		bool end(float ms, Profiler &profiler){
+			if(measuring()){
+				frameTimes.push_back(ms);
+				drawCalls.push_back(DrawStats::calls);
+				triangles.push_back(DrawStats::triangles);
+				stateCalls.push_back(GLState::issued);
+				stateElided.push_back(GLState::elided);
+			}
+
+			frame++;
+
+			// Fim do aquecimento: o perfil passa a guardar só os frames medidos
+			if(frame == warmup)
+				profiler.reset(frames);
+
+			return frame >= warmup + frames;
+		}//end
+
+		bool measuring(){
+			return frame >= warmup;
+		}//measuring
+
+		// Frames do benchmark, com o aquecimento
+		unsigned int total(){
+			return warmup + frames;
+		}//total
+
+		/** Grava o relatório
+			* @param file - Arquivo JSON
+			* @param profiler - Perfil dos passos dos frames medidos
+			* @param width - Largura da imagem
+			* @param height - Altura da imagem
+			* @param depth - Modo de profundidade
+			*/
+		void write(const string &file, Profiler &profiler, int width, int height, const string &depth){
+			Stats time = Profiler::stats(frameTimes);
+			Stats calls = Profiler::stats(drawCalls);
+			Stats tris = Profiler::stats(triangles);
+			Stats state = Profiler::stats(stateCalls);
+			Stats elided = Profiler::stats(stateElided);
+
+			ofstream out(file.c_str());
+			out << "{" << endl;
+			out << "  \"scenario\": " << quote(scenario) << "," << endl;
+#ifdef NDEBUG
+			out << "  \"build\": \"release\"," << endl;
+#else
+			out << "  \"build\": \"debug\"," << endl;
+#endif
+			out << "  \"renderer\": " << quote(glString(GL_RENDERER)) << "," << endl;
+			out << "  \"version\": " << quote(glString(GL_VERSION)) << "," << endl;
+			out << "  \"resolution\": [" << width << ", " << height << "]," << endl;
+			out << "  \"depth\": " << quote(depth) << "," << endl;
+			out << "  \"warmup\": " << warmup << "," << endl;
+			out << "  \"frames\": " << frameTimes.size() << "," << endl;
+			out << "  \"fps\": " << (time.avg > 0.0f ? 1000.0f / time.avg : 0.0f) << "," << endl;
+			out << "  \"frame_ms\": ";
+			writeStats(out, time);
+			out << "," << endl;
+
+			out << "  \"passes\": {" << endl;
+			vector<string> names = profiler.names();
+			for(unsigned int i = 0; i < names.size(); i++){
+				out << "    " << quote(names[i]) << ": {\"cpu_ms\": ";
+				writeStats(out, profiler.cpuStats(names[i]));
+				out << ", \"gpu_ms\": ";
+				writeStats(out, profiler.gpuStats(names[i]));
+				out << "}" << (i + 1 < names.size() ? "," : "") << endl;
+			}
+			out << "  }," << endl;
+			out << "  \"gpu_results_dropped\": " << profiler.getDropped() << "," << endl;
+
+			out << "  \"draw_calls\": {\"avg\": " << calls.avg << ", \"max\": " << calls.max << "}," << endl;
+			out << "  \"triangles\": {\"avg\": " << tris.avg << ", \"max\": " << tris.max << "}," << endl;
+			out << "  \"state_calls\": {\"avg\": " << state.avg << ", \"max\": " << state.max << "}," << endl;
+			out << "  \"state_calls_elided\": {\"avg\": " << elided.avg << ", \"max\": " << elided.max << "}," << endl;
+
+			long rss = 0, peak = 0;
+			residentMemory(rss, peak);
+			out << "  \"memory_kb\": {\"rss\": " << rss << ", \"peak_rss\": " << peak << ", " << gpuMemory() << "}" << endl;
+			out << "}" << endl;
+
+			cout << "Benchmark " << scenario << ": " << frameTimes.size() << " frames, "
+				 << time.avg << " ms médio, p95 " << time.p95 << ", p99 " << time.p99 << ", máximo " << time.max
+				 << " (" << file << ")" << endl;
+		}//write
+
+	protected:
+		// String JSON entre aspas: o cenário pode ser um caminho e o driver escreve o que quiser
+		static string quote(const string &x){
+			string y = "\"";
+			for(unsigned int i = 0; i < x.size(); i++){
+				unsigned char c = x[i];
+				if(c == '"' or c == '\\')
+					y += string("\\") + (char) c;
+				else if(c < 0x20){
+					char code[8];
+					snprintf(code, sizeof(code), "\\u%04x", c);
+					y += code;
+				}
+				else
+					y += (char) c;
+			}
+			return y + "\"";
+		}//quote
+
+		static string glString(GLenum name){
+			const GLubyte *x = glGetString(name);
+			return x ? (const char *) x : "";
+		}//glString
+
+		void writeStats(ostream &out, Stats x){
+			out << "{\"avg\": " << x.avg << ", \"p50\": " << x.p50 << ", \"p95\": " << x.p95
+				<< ", \"p99\": " << x.p99 << ", \"max\": " << x.max << "}";
+		}//writeStats
+
+		// Memória de vídeo (kB): em uso na NVIDIA, livre na AMD, null nos outros
+		static string gpuMemory(){
+			if(GLCaps::hasExtension("GL_NVX_gpu_memory_info")){
+				GLint total = 0, available = 0;
+				glGetIntegerv(BENCHMARK_GPU_MEMORY_TOTAL_NVX, &total);
+				glGetIntegerv(BENCHMARK_GPU_MEMORY_AVAILABLE_NVX, &available);
+				return "\"gpu_used\": " + to_string(total - available);
+			}
+			if(GLCaps::hasExtension("GL_ATI_meminfo")){
+				GLint info[4] = {0, 0, 0, 0};
+				glGetIntegerv(BENCHMARK_TEXTURE_FREE_MEMORY_ATI, info);
+				return "\"gpu_free\": " + to_string(info[0]);
+			}
+			return "\"gpu_used\": null";
+		}//gpuMemory
+};
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef CAMERAPATH_H
+#define CAMERAPATH_H
+
+#include <glm/glm.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Chave do caminho da câmera
+struct CameraKey {
+	float time;        // segundos desde o início
+	int mode;          // 1, 2, 3 como no teclado; 0 = câmera livre (look)
+	int planet;        // modo 2
+	int moon;          // modo 2, -1 sem lua
+	glm::vec3 position; // câmera livre
+	glm::vec3 target;
+};
+
+// Caminho de câmera roteirizado, usado para gerar frames sem janela.
+// Formato (uma chave por linha, '#' comenta):
+//   <segundos> mode 1
+//   <segundos> mode 2 <planeta> <lua>
+//   <segundos> mode 3
+//   <segundos> look <px> <py> <pz> <tx> <ty> <tz>
+// Duas chaves "look" seguidas são interpoladas linearmente. Os tempos não
+// podem diminuir; chaves no mesmo tempo valem a partir dele, a última vence.
+class CameraPath {
+	protected:
+		vector<CameraKey> keys;
+
+	public:
+		// Lê o caminho de um arquivo
+		bool load(const string &path){
+			ifstream file(path.c_str());
+			if(not file){
+				cout << "ERROR::CAMERAPATH:: Não foi possível abrir " << path << endl;
+				return false;
+			}
+			stringstream text;
+			text << file.rdbuf();
+			return parse(text.str());
+		}//load
+
+		// Caminho padrão: visão global, todos os planetas e a nave
+		void builtin(){
+			parse("0 mode 1\n"
+				  "4 mode 2 0 -1\n5 mode 2 1 -1\n6 mode 2 2 -1\n7 mode 2 2 0\n"
+				  "8 mode 2 3 -1\n9 mode 2 4 -1\n10 mode 2 4 2\n11 mode 2 5 -1\n"
+				  "12 mode 2 6 -1\n13 mode 2 7 -1\n"
+				  "14 mode 3\n"
+				  "18 look 0 6 9 0 0 0\n22 look 9 2 0 0 0 0\n");
+		}//builtin
+
+		bool parse(const string &text){
+			keys.clear();
+			stringstream lines(text);
+			string line;
+			while(getline(lines, line)){
+				if(line.empty() or line[0] == '#')
+					continue;
+
+				stringstream in(line);
+				CameraKey key = {0.0f, 1, 0, -1, glm::vec3(0.0f), glm::vec3(0.0f)};
+				string command;
+				if(not (in >> key.time >> command))
+					continue;
+
+				if(command == "mode"){
+					in >> key.mode;
+					if(key.mode == 2)
+						in >> key.planet >> key.moon;
+				}
+				else if(command == "look"){
+					key.mode = 0;
+					in >> key.position.x >> key.position.y >> key.position.z
+					   >> key.target.x >> key.target.y >> key.target.z;
+				}
+				else{
+					cout << "ERROR::CAMERAPATH:: Comando desconhecido: " << command << endl;
+					return false;
+				}
+				if(not keys.empty() and key.time < keys.back().time){
+					cout << "ERROR::CAMERAPATH:: Chave fora de ordem: " << line << endl;
+					return false;
+				}
+				keys.push_back(key);
+			}
+			return not keys.empty();
+		}//parse
+
+		// Alguma chave usa o modo (ex: a nave do modo 3 pode ser carregada antes)
+		bool uses(int mode){
+			for(unsigned int i = 0; i < keys.size(); i++)
+				if(keys[i].mode == mode)
+					return true;
+			return false;
+		}//uses
+
+		// Duração do caminho (a última chave dura mais 4 segundos)
+		float duration(){
+			return keys.empty() ? 0.0f : keys.back().time + 4.0f;
+		}//duration
+
+		// Chave ativa no tempo t, com a câmera livre interpolada
+		CameraKey at(float t){
+			CameraKey key = keys[0];
+			unsigned int i = 0;
+			while(i + 1 < keys.size() and keys[i + 1].time <= t)
+				i++;
+			key = keys[i];
+
+			// duas chaves no mesmo tempo não têm trecho para interpolar
+			if(key.mode == 0 and i + 1 < keys.size() and keys[i + 1].mode == 0 and keys[i + 1].time > key.time){
+				CameraKey &next = keys[i + 1];
+				float x = glm::clamp((t - key.time) / (next.time - key.time), 0.0f, 1.0f);
+				key.position = glm::mix(key.position, next.position, x);
+				key.target = glm::mix(key.target, next.target, x);
+			}
+			return key;
+		}//at
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef CATALOGUE_H
+#define CATALOGUE_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Dados de um corpo do sistema solar, sem nada de OpenGL
+struct BodyInfo {
+	string name;
+	string model;        // modelo 3D (relativo à raiz do projeto)
+	float scale;         // usado para decidir a escala
+	float orbit;         // periodo orbital
+	float rotation;      // periodo de rotação
+	float distance;      // distância da origem
+	int parent;          // índice do planeta (luas), -1 nos planetas
+	float realDiameter;  // km
+	float realDistance;  // UA
+};
+
+// Catálogo do sistema solar, compartilhado pelo visualizador e pelo simulador
+BodyInfo sunCatalogue();
+vector<BodyInfo> planetCatalogue();
+vector<BodyInfo> moonCatalogue();
+
+#endif
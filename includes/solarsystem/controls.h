@@ -0,0 +1,222 @@
+#ifndef CONTROLS_H
+#define CONTROLS_H
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace std;
+
+// Ações do simulador, independentes da tecla
+enum Action {
+	ACTION_QUIT,
+	ACTION_DEPTH,          // troca o modo de profundidade
+	ACTION_PROFILER,       // mostra/esconde o perfil
+	ACTION_HELP,           // mostra/esconde os comandos na tela
+	ACTION_SAVE_PROFILE,
+	ACTION_RECORD,         // começa/termina a gravação de vídeo
+	ACTION_TRUE_SCALE,
+	ACTION_MODE_1,
+	ACTION_MODE_2,
+	ACTION_MODE_3,
+	ACTION_PAUSE,          // modos 1 e 2
+	ACTION_FASTER,
+	ACTION_SLOWER,
+	ACTION_FLAT_EARTH,     // modo 2
+	ACTION_PREVIOUS_PLANET,
+	ACTION_NEXT_PLANET,
+	ACTION_UP,             // próxima lua (modo 2), acelera a nave (modo 3)
+	ACTION_DOWN,           // lua anterior (modo 2), freia a nave (modo 3)
+	ACTION_YAW_LEFT,       // nave, enquanto segurada
+	ACTION_YAW_RIGHT,
+	ACTION_PITCH_UP,
+	ACTION_PITCH_DOWN,
+	ACTION_ROLL_LEFT,
+	ACTION_ROLL_RIGHT,
+	ACTION_COUNT
+};
+
+// Evento de tecla ou caractere, com o instante em que chegou
+struct ControlEvent {
+	int code;     // tecla GLFW, ou caractere quando text = true
+	int state;    // 1 apertou, 0 soltou
+	bool text;    // veio do callback de caractere (só apertos)
+	double time;  // segundos no relógio monotônico
+};
+
+// Fila sem trava de um produtor e um consumidor: os callbacks do GLFW
+// escrevem, o frame lê. O tamanho é potência de 2; cheia, descarta.
+class EventQueue {
+	protected:
+		static const unsigned int SIZE = 256;
+		ControlEvent ring[SIZE];
+		atomic<unsigned int> head;  // próxima leitura
+		atomic<unsigned int> tail;  // próxima escrita
+
+	public:
+		unsigned int dropped;
+
+		EventQueue(): head(0), tail(0){
+			dropped = 0;
+		}//EventQueue
+
+		bool push(const ControlEvent &e){
+			unsigned int t = tail.load(memory_order_relaxed);
+			if(t - head.load(memory_order_acquire) == SIZE){
+				dropped++;
+				return false;
+			}
+			ring[t % SIZE] = e;
+			tail.store(t + 1, memory_order_release);
+			return true;
+		}//push
+
+		bool pop(ControlEvent &e){
+			unsigned int h = head.load(memory_order_relaxed);
+			if(h == tail.load(memory_order_acquire))
+				return false;
+			e = ring[h % SIZE];
+			head.store(h + 1, memory_order_release);
+			return true;
+		}//pop
+
+		bool empty(){
+			return head.load(memory_order_acquire) == tail.load(memory_order_acquire);
+		}//empty
+};
+
+// Entrada por eventos: os callbacks enfileiram, e no começo do frame a fila
+// é esvaziada e traduzida em ações pelo mapa de teclas. Cada ação tem o
+// número de apertos desde o último frame (borda) e se está segurada, então
+// teclas simultâneas não se perdem e segurar uma tecla não repete o comando.
+// Também mede a latência do evento até o frame apresentado.
+class Controls {
+	protected:
+		EventQueue queue;
+		map<int, vector<int> > keys;           // tecla -> ações
+		map<int, vector<int> > chars;          // caractere -> ações
+		set<int> down;                         // teclas apertadas
+		int holding[ACTION_COUNT];             // teclas seguradas de cada ação
+		int presses[ACTION_COUNT];             // apertos no frame
+		double oldest;                         // evento mais antigo do frame (-1 nenhum)
+
+	public:
+		deque<float> latency;                  // evento até o frame apresentado (ms)
+
+		Controls(){
+			for(int i = 0; i < ACTION_COUNT; i++)
+				holding[i] = presses[i] = 0;
+			oldest = -1.0;
+		}//Controls
+
+		void bindKey(int key, Action action){
+			keys[key].push_back(action);
+		}//bindKey
+
+		// Caracteres seguem o layout do teclado ('+' e '-' em qualquer um)
+		void bindChar(unsigned int codepoint, Action action){
+			chars[codepoint].push_back(action);
+		}//bindChar
+
+		/** Callback de tecla: só enfileira
+			* @param key - Tecla GLFW
+			* @param state - 1 apertou, 0 soltou (repetições do sistema são ignoradas)
+			*/
+		void key(int key, int state, double time){
+			ControlEvent e = {key, state, false, time};
+			queue.push(e);
+		}//key
+
+		void character(unsigned int codepoint, double time){
+			ControlEvent e = {(int) codepoint, 1, true, time};
+			queue.push(e);
+		}//character
+
+		/** Esvazia a fila e atualiza as ações do frame
+			* @return os eventos consumidos (para o log de entrada)
+			*/
+		vector<ControlEvent> update(){
+			vector<ControlEvent> events;
+			for(int i = 0; i < ACTION_COUNT; i++)
+				presses[i] = 0;
+
+			ControlEvent e;
+			while(queue.pop(e)){
+				if(e.text){
+					apply(chars, e.code, 1, false);
+				}
+				else if(e.state and not down.count(e.code)){
+					down.insert(e.code);
+					apply(keys, e.code, 1, true);
+				}
+				else if(not e.state and down.count(e.code)){
+					down.erase(e.code);
+					apply(keys, e.code, -1, true);
+				}
+				else
+					continue;
+
+				if(oldest < 0.0 or e.time < oldest)
+					oldest = e.time;
+				events.push_back(e);
+			}
+			return events;
+		}//update
+
+		// Apertos da ação desde o último frame
+		int pressed(Action action){
+			return presses[action];
+		}//pressed
+
+		// A ação está segurada
+		bool held(Action action){
+			return holding[action] > 0;
+		}//held
+
+		// Nenhuma tecla segurada e nada na fila: o frame não tem entrada
+		bool idle(){
+			return down.empty() and queue.empty();
+		}//idle
+
+		/** O frame foi apresentado: guarda a latência do evento mais antigo dele
+			* @param time - Instante da troca de buffers (now())
+			* @param window - Amostras guardadas
+			*/
+		void presented(double time, unsigned int window = 600){
+			if(oldest < 0.0)
+				return;
+			latency.push_back(1000.0 * (time - oldest));
+			if(latency.size() > window)
+				latency.pop_front();
+			oldest = -1.0;
+		}//presented
+
+		unsigned int dropped(){
+			return queue.dropped;
+		}//dropped
+
+		// Relógio dos eventos
+		static double now(){
+			return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+		}//now
+
+	protected:
+		void apply(map<int, vector<int> > &bindings, int code, int change, bool hold){
+			map<int, vector<int> >::iterator it = bindings.find(code);
+			if(it == bindings.end())
+				return;
+
+			for(unsigned int i = 0; i < it->second.size(); i++){
+				int action = it->second[i];
+				if(change > 0)
+					presses[action]++;
+				if(hold)
+					holding[action] += change;
+			}
+		}//apply
+};
+
+#endif
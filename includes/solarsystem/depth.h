@@ -0,0 +1,192 @@
+#ifndef DEPTH_H
+#define DEPTH_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "glcaps.h"
+
+#include <cmath>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// Modos do buffer de profundidade
+enum DepthMode {
+	DEPTH_STANDARD,    // perspectiva padrão, profundidade de 24 bits
+	DEPTH_REVERSED,    // Z invertido com profundidade float (glClipControl)
+	DEPTH_LOGARITHMIC  // profundidade logarítmica escrita no fragment shader (GL 3.3)
+};
+
+// Controla o buffer de profundidade usado para desenhar o sistema solar.
+// No modo invertido a cena é desenhada num framebuffer com profundidade
+// GL_DEPTH_COMPONENT32F e far no infinito, e depois copiada para a janela.
+class Depth {
+	public:
+		static DepthMode mode;      // modo atual
+		static bool clipControl;    // o driver tem glClipControl
+		static unsigned int output; // framebuffer final: 0 é a janela, ou o do Offscreen
+
+		// Verifica o suporte do driver, deve ser chamado depois do glad
+		static void init(GLADloadproc load, int w, int h){
+			// GL 3.3 com a extensão: carrega o ponteiro na mão
+			clipControl = GLCaps::require(GLAD_GL_VERSION_4_5, "GL_ARB_clip_control", glad_glClipControl, load, "glClipControl");
+
+			resize(w, h);
+		}//init
+
+		// Troca o modo, caindo para o logarítmico se não houver glClipControl
+		static void setMode(DepthMode m){
+			if(m == DEPTH_REVERSED and not clipControl)
+				m = DEPTH_LOGARITHMIC;
+
+			mode = m;
+			apply();
+		}//setMode
+
+		// Passa para o próximo modo
+		static void next(){
+			switch(mode){
+				case DEPTH_STANDARD:    setMode(DEPTH_REVERSED);    break;
+				case DEPTH_REVERSED:    setMode(DEPTH_LOGARITHMIC); break;
+				case DEPTH_LOGARITHMIC: setMode(DEPTH_STANDARD);    break;
+			}
+		}//next
+
+		static string name(){
+			switch(mode){
+				case DEPTH_REVERSED:    return "Z INVERTIDO";
+				case DEPTH_LOGARITHMIC: return "LOGARITMICO";
+				default:                return "PADRAO";
+			}
+		}//name
+
+		// Redimensiona o framebuffer de profundidade float
+		static void resize(int w, int h){
+			if(w <= 0 or h <= 0)
+				return;
+
+			width = w;
+			height = h;
+
+			if(fbo == 0){
+				glGenFramebuffers(1, &fbo);
+				glGenRenderbuffers(1, &color);
+				glGenRenderbuffers(1, &depth);
+			}
+
+			glBindRenderbuffer(GL_RENDERBUFFER, color);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+			glBindRenderbuffer(GL_RENDERBUFFER, depth);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, width, height);
+
+			glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+			if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+				cout << "ERROR::DEPTH:: Framebuffer de profundidade incompleto" << endl;
+			glBindFramebuffer(GL_FRAMEBUFFER, output);
+		}//resize
+
+		/** Matriz de projeção para o modo atual
+			* @param fovy - Campo de visão vertical (radianos)
+			* @param aspect - Proporção da janela
+			* @param near - Plano próximo
+			* @param far - Plano distante (ignorado no Z invertido, que vai até o infinito)
+			*/
+		static glm::mat4 perspective(float fovy, float aspect, float near, float far){
+			if(mode != DEPTH_REVERSED)
+				return glm::perspective(fovy, aspect, near, far);
+
+			// Z invertido com far infinito: profundidade = near / -z
+			float f = 1.0f / tan(fovy / 2.0f);
+			glm::mat4 matrix(0.0f);
+			matrix[0][0] = f / aspect;
+			matrix[1][1] = f;
+			matrix[2][3] = -1.0f;
+			matrix[3][2] = near;
+			return matrix;
+		}//perspective
+
+		// Coeficiente da profundidade logarítmica (0 quando desligada)
+		static float logarithmic(float far){
+			if(mode != DEPTH_LOGARITHMIC)
+				return 0.0f;
+			return 2.0f / log2(far + 1.0f);
+		}//logarithmic
+
+		// Começa o frame: escolhe o framebuffer e o teste de profundidade
+		static void begin(){
+			glBindFramebuffer(GL_FRAMEBUFFER, target());
+			apply();
+		}//begin
+
+		// Termina o frame: copia a cor para a saída no modo invertido
+		static void end(){
+			if(mode != DEPTH_REVERSED)
+				return;
+
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, output);
+			glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+			glBindFramebuffer(GL_FRAMEBUFFER, output);
+		}//end
+
+		// Volta para a profundidade padrão (passes fora da janela, ex: cubemap)
+		static void suspend(){
+			if(mode == DEPTH_REVERSED)
+				glClipControl(GL_LOWER_LEFT, GL_NEGATIVE_ONE_TO_ONE);
+			glClearDepth(1.0);
+			glDepthFunc(GL_LESS);
+		}//suspend
+
+		// Restaura o modo atual depois de um suspend()
+		static void resume(){
+			apply();
+		}//resume
+
+		// Framebuffer onde a cena está sendo desenhada
+		static unsigned int target(){
+			return mode == DEPTH_REVERSED ? fbo : output;
+		}//target
+
+		// Profundidade (NDC) do plano distante, usada pelo skybox
+		static float farPlane(){
+			return mode == DEPTH_REVERSED ? 0.0f : 1.0f;
+		}//farPlane
+
+		// Teste usado por quem desenha exatamente no plano distante
+		static GLenum farFunc(){
+			return mode == DEPTH_REVERSED ? GL_GEQUAL : GL_LEQUAL;
+		}//farFunc
+
+		// Teste de profundidade do modo atual
+		static GLenum func(){
+			return mode == DEPTH_REVERSED ? GL_GREATER : GL_LESS;
+		}//func
+
+	private:
+		static unsigned int fbo, color, depth;
+		static int width, height;
+
+		static void apply(){
+			if(clipControl)
+				glClipControl(GL_LOWER_LEFT, mode == DEPTH_REVERSED ? GL_ZERO_TO_ONE : GL_NEGATIVE_ONE_TO_ONE);
+			glClearDepth(mode == DEPTH_REVERSED ? 0.0 : 1.0);
+			glDepthFunc(func());
+		}//apply
+};
+
+DepthMode    Depth::mode        = DEPTH_STANDARD;
+bool         Depth::clipControl = false;
+unsigned int Depth::output      = 0;
+unsigned int Depth::fbo         = 0;
+unsigned int Depth::color       = 0;
+unsigned int Depth::depth       = 0;
+int          Depth::width       = 0;
+int          Depth::height      = 0;
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef DRAWSTATS_H
+#define DRAWSTATS_H
+
+// Contadores de desenho: chamadas de draw e triângulos enviados desde o
+// último reset(). O benchmark zera no começo de cada frame.
+class DrawStats {
+	public:
+		static unsigned long calls;
+		static unsigned long triangles;
+
+		static void add(unsigned long count){
+			calls++;
+			triangles += count;
+		}//add
+
+		static void reset(){
+			calls = 0;
+			triangles = 0;
+		}//reset
+};
+
+unsigned long DrawStats::calls     = 0;
+unsigned long DrawStats::triangles = 0;
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef GLCAPS_H
+#define GLCAPS_H
+
+#include <glad/glad.h>
+
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+// Recursos opcionais do driver, consultados depois do glad
+class GLCaps {
+	public:
+		// O contexto tem a extensão
+		static bool hasExtension(const char *extension){
+			GLint count = 0;
+			glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+			for(GLint i = 0; i < count; i++)
+				if(strcmp((const char*) glGetStringi(GL_EXTENSIONS, i), extension) == 0)
+					return true;
+			return false;
+		}//hasExtension
+
+		/** Garante um ponteiro de função que o glad só carrega numa versão maior
+			* @param version - Flag do glad da versão em que a função é core
+			* @param extension - Extensão que também oferece a função
+			* @param pointer - Ponteiro global do glad
+			* @param load - Função de carregamento (glfwGetProcAddress, eglGetProcAddress)
+			* @param name - Nome da função
+			*/
+		template <typename T>
+		static bool require(int version, const char *extension, T &pointer, GLADloadproc load, const char *name){
+			if(version)
+				return pointer != NULL;
+
+			if(not hasExtension(extension))
+				return false;
+
+			pointer = (T) load(name);
+			return pointer != NULL;
+		}//require
+};
+
+#endif
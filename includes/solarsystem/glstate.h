@@ -0,0 +1,208 @@
+#ifndef GLSTATE_H
+#define GLSTATE_H
+
+#include <glad/glad.h>
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+// Unidades de textura acompanhadas; as de cima passam direto
+#define GLSTATE_UNITS 32
+
+// Cópia na CPU do estado que o desenho muda a cada malha: programa, VAO,
+// unidade ativa, textura de cada unidade e os uniforms inteiros (samplers).
+// Uma chamada que não muda nada não chega ao driver. Só funciona se todo o
+// código trocar esse estado por aqui; quem apaga texturas e VAOs também
+// avisa, porque o OpenGL desliga os nomes apagados.
+class GLState {
+	protected:
+		static GLuint program;
+		static GLuint vertexArray;
+		static GLenum unit;                                   // GL_TEXTURE0 + i
+		static GLuint textures[GLSTATE_UNITS];                // GL_TEXTURE_2D de cada unidade
+		static GLuint cubemaps[GLSTATE_UNITS];                // GL_TEXTURE_CUBE_MAP de cada unidade
+		static map<pair<GLuint, GLint>, GLint> integers;     // valor de cada uniform inteiro (programa, posição)
+		static map<pair<GLuint, string>, GLint> locations;   // posição de cada uniform (programa, nome)
+
+	public:
+		static unsigned long issued;       // chamadas enviadas desde o último frame()
+		static unsigned long elided;       // chamadas evitadas desde o último frame()
+		static unsigned long lastIssued;   // do frame anterior
+		static unsigned long lastElided;
+		static unsigned long totalIssued;  // desde o início
+		static unsigned long totalElided;
+
+		static void useProgram(GLuint id){
+			if(count(id == program))
+				return;
+			program = id;
+			glUseProgram(id);
+		}//useProgram
+
+		static void bindVertexArray(GLuint id){
+			if(count(id == vertexArray))
+				return;
+			vertexArray = id;
+			glBindVertexArray(id);
+		}//bindVertexArray
+
+		static void activeTexture(GLenum texture){
+			if(count(texture == unit))
+				return;
+			unit = texture;
+			glActiveTexture(texture);
+		}//activeTexture
+
+		/** Liga a textura na unidade ativa
+			* @param target - GL_TEXTURE_2D e GL_TEXTURE_CUBE_MAP são acompanhados, os outros passam direto
+			*/
+		static void bindTexture(GLenum target, GLuint id){
+			GLuint *bound = slot(unit - GL_TEXTURE0, target);
+			if(count(bound and *bound == id))
+				return;
+			if(bound)
+				*bound = id;
+			glBindTexture(target, id);
+		}//bindTexture
+
+		/** Liga a textura numa unidade; se ela já está lá, nem a unidade ativa muda
+			* @param index - Unidade (0, 1, ...)
+			*/
+		static void bindTextureUnit(unsigned int index, GLenum target, GLuint id){
+			GLuint *bound = slot(index, target);
+			if(bound and *bound == id){
+				count(true); // glActiveTexture
+				count(true); // glBindTexture
+				return;
+			}
+			activeTexture(GL_TEXTURE0 + index);
+			bindTexture(target, id);
+		}//bindTextureUnit
+
+		/** Posição do uniform, guardada por programa
+			* @return -1 se o programa não tem o uniform
+			*/
+		static GLint uniformLocation(GLuint id, const string &name){
+			pair<GLuint, string> key(id, name);
+			map<pair<GLuint, string>, GLint>::iterator it = locations.find(key);
+			if(count(it != locations.end()))
+				return it->second;
+			GLint location = glGetUniformLocation(id, name.c_str());
+			locations[key] = location;
+			return location;
+		}//uniformLocation
+
+		// glUniform1i no programa em uso, só se o valor mudou
+		static void uniform1i(GLint location, GLint value){
+			if(location < 0)
+				return;
+			pair<GLuint, GLint> key(program, location);
+			map<pair<GLuint, GLint>, GLint>::iterator it = integers.find(key);
+			if(count(it != integers.end() and it->second == value))
+				return;
+			integers[key] = value;
+			glUniform1i(location, value);
+		}//uniform1i
+
+		// O OpenGL desliga uma textura apagada de todas as unidades
+		static void deleteTexture(GLuint id){
+			for(int i = 0; i < GLSTATE_UNITS; i++){
+				if(textures[i] == id)
+					textures[i] = 0;
+				if(cubemaps[i] == id)
+					cubemaps[i] = 0;
+			}
+			glDeleteTextures(1, &id);
+		}//deleteTexture
+
+		static void deleteVertexArray(GLuint id){
+			if(vertexArray == id)
+				vertexArray = 0;
+			glDeleteVertexArrays(1, &id);
+		}//deleteVertexArray
+
+		// Esquece os uniforms de um programa apagado (o nome pode voltar num novo)
+		static void deleteProgram(GLuint id){
+			for(map<pair<GLuint, GLint>, GLint>::iterator it = integers.begin(); it != integers.end();)
+				if(it->first.first == id)
+					integers.erase(it++);
+				else
+					++it;
+			for(map<pair<GLuint, string>, GLint>::iterator it = locations.begin(); it != locations.end();)
+				if(it->first.first == id)
+					locations.erase(it++);
+				else
+					++it;
+			if(program == id)
+				program = 0;
+			glDeleteProgram(id);
+		}//deleteProgram
+
+		// Começa um frame: guarda os contadores do anterior
+		static void frame(){
+			lastIssued = issued;
+			lastElided = elided;
+			issued = elided = 0;
+		}//frame
+
+		// Chamadas do último frame (HUD)
+		static string status(){
+			char line[96];
+			snprintf(line, sizeof(line), "Estado GL: %lu chamadas, %lu evitadas", lastIssued, lastElided);
+			return line;
+		}//status
+
+		// Totais desde o início, para o relatório final
+		static string summary(){
+			unsigned long all = totalIssued + totalElided;
+			char line[128];
+			snprintf(line, sizeof(line), "Estado GL: %lu chamadas enviadas, %lu evitadas (%.0f%%)", totalIssued, totalElided,
+					 all ? 100.0 * totalElided / all : 0.0);
+			return line;
+		}//summary
+
+	protected:
+		// Onde fica a textura ligada de uma unidade, ou NULL se ela não é acompanhada
+		static GLuint *slot(unsigned int index, GLenum target){
+			if(index >= GLSTATE_UNITS)
+				return NULL;
+			if(target == GL_TEXTURE_2D)
+				return &textures[index];
+			if(target == GL_TEXTURE_CUBE_MAP)
+				return &cubemaps[index];
+			return NULL;
+		}//slot
+
+		// Conta a chamada; devolve se ela pode ser evitada
+		static bool count(bool redundant){
+			if(redundant){
+				elided++;
+				totalElided++;
+			}
+			else{
+				issued++;
+				totalIssued++;
+			}
+			return redundant;
+		}//count
+};
+
+GLuint GLState::program = 0;
+GLuint GLState::vertexArray = 0;
+GLenum GLState::unit = GL_TEXTURE0;
+GLuint GLState::textures[GLSTATE_UNITS] = {0};
+GLuint GLState::cubemaps[GLSTATE_UNITS] = {0};
+map<pair<GLuint, GLint>, GLint> GLState::integers;
+map<pair<GLuint, string>, GLint> GLState::locations;
+unsigned long GLState::issued = 0;
+unsigned long GLState::elided = 0;
+unsigned long GLState::lastIssued = 0;
+unsigned long GLState::lastElided = 0;
+unsigned long GLState::totalIssued = 0;
+unsigned long GLState::totalElided = 0;
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef HUD_H
+#define HUD_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader_m.h>
+
+#include "glstate.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Fonte 5x7 dos caracteres 32..126, uma coluna por byte (bit 0 em cima)
+static const unsigned char HUD_FONT[95][5] = {
+	{0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7F,0x14,0x7F,0x14},
+	{0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00},
+	{0x00,0x1C,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1C,0x00}, {0x08,0x2A,0x1C,0x2A,0x08}, {0x08,0x08,0x3E,0x08,0x08},
+	{0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x60,0x60,0x00,0x00}, {0x20,0x10,0x08,0x04,0x02},
+	{0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4B,0x31},
+	{0x18,0x14,0x12,0x7F,0x10}, {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03},
+	{0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1E}, {0x00,0x36,0x36,0x00,0x00}, {0x00,0x56,0x36,0x00,0x00},
+	{0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14}, {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06},
+	{0x32,0x49,0x79,0x41,0x3E}, {0x7E,0x11,0x11,0x11,0x7E}, {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22},
+	{0x7F,0x41,0x41,0x22,0x1C}, {0x7F,0x49,0x49,0x49,0x41}, {0x7F,0x09,0x09,0x09,0x01}, {0x3E,0x41,0x49,0x49,0x7A},
+	{0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41},
+	{0x7F,0x40,0x40,0x40,0x40}, {0x7F,0x02,0x0C,0x02,0x7F}, {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E},
+	{0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, {0x7F,0x09,0x19,0x29,0x46}, {0x46,0x49,0x49,0x49,0x31},
+	{0x01,0x01,0x7F,0x01,0x01}, {0x3F,0x40,0x40,0x40,0x3F}, {0x1F,0x20,0x40,0x20,0x1F}, {0x3F,0x40,0x38,0x40,0x3F},
+	{0x63,0x14,0x08,0x14,0x63}, {0x07,0x08,0x70,0x08,0x07}, {0x61,0x51,0x49,0x45,0x43}, {0x00,0x7F,0x41,0x41,0x00},
+	{0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x7F,0x00}, {0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40},
+	{0x00,0x01,0x02,0x04,0x00}, {0x20,0x54,0x54,0x54,0x78}, {0x7F,0x48,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x20},
+	{0x38,0x44,0x44,0x48,0x7F}, {0x38,0x54,0x54,0x54,0x18}, {0x08,0x7E,0x09,0x01,0x02}, {0x0C,0x52,0x52,0x52,0x3E},
+	{0x7F,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7D,0x40,0x00}, {0x20,0x40,0x44,0x3D,0x00}, {0x7F,0x10,0x28,0x44,0x00},
+	{0x00,0x41,0x7F,0x40,0x00}, {0x7C,0x04,0x18,0x04,0x78}, {0x7C,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38},
+	{0x7C,0x14,0x14,0x14,0x08}, {0x08,0x14,0x14,0x18,0x7C}, {0x7C,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x20},
+	{0x04,0x3F,0x44,0x40,0x20}, {0x3C,0x40,0x40,0x20,0x7C}, {0x1C,0x20,0x40,0x20,0x1C}, {0x3C,0x40,0x30,0x40,0x3C},
+	{0x44,0x28,0x10,0x28,0x44}, {0x0C,0x50,0x50,0x50,0x3C}, {0x44,0x64,0x54,0x4C,0x44}, {0x00,0x08,0x36,0x41,0x00},
+	{0x00,0x00,0x7F,0x00,0x00}, {0x00,0x41,0x36,0x08,0x00}, {0x08,0x04,0x08,0x10,0x08}
+};
+
+// Células do atlas: 16 colunas x 6 linhas de 6x8 pixels (glifo 5x7 e um de folga)
+#define HUD_CELL_W 6
+#define HUD_CELL_H 8
+#define HUD_COLUMNS 16
+
+// Texto na tela. A fonte é gravada uma vez numa textura (atlas); cada
+// caractere vira dois triângulos num buffer só, e o texto inteiro é
+// desenhado com um glDrawArrays. O buffer só é reenviado quando o texto
+// muda (begin/text/end), não a cada frame.
+class Hud {
+	protected:
+		unsigned int atlas, VAO, VBO;
+		vector<float> vertices;   // x, y, u, v, r, g, b, a
+		vector<float> previous;   // último texto enviado
+		unsigned int count;       // vértices no buffer
+		int scale;                // pixels da tela por pixel da fonte
+
+	public:
+		bool visible;
+
+		Hud(){
+			atlas = VAO = VBO = 0;
+			count = 0;
+			scale = 2;
+			visible = true;
+		}//Hud
+
+		// Grava o atlas e cria o buffer (precisa do contexto OpenGL)
+		void create(){
+			int width = HUD_COLUMNS * HUD_CELL_W;
+			int height = 6 * HUD_CELL_H;
+			vector<unsigned char> pixels(width * height, 0);
+			for(int c = 0; c < 95; c++){
+				int x0 = (c % HUD_COLUMNS) * HUD_CELL_W;
+				int y0 = (c / HUD_COLUMNS) * HUD_CELL_H;
+				for(int x = 0; x < 5; x++)
+					for(int y = 0; y < 7; y++)
+						if(HUD_FONT[c][x] & (1 << y))
+							pixels[(y0 + y) * width + x0 + x] = 255;
+			}
+
+			glGenTextures(1, &atlas);
+			GLState::bindTexture(GL_TEXTURE_2D, atlas);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, &pixels[0]);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+			glGenVertexArrays(1, &VAO);
+			glGenBuffers(1, &VBO);
+			GLState::bindVertexArray(VAO);
+			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) 0);
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) (4 * sizeof(float)));
+			GLState::bindVertexArray(0);
+		}//create
+
+		// Começa um texto novo
+		void begin(){
+			vertices.clear();
+		}//begin
+
+		/** Acrescenta uma linha
+			* @param column - Coluna (em caracteres, negativa conta da direita)
+			* @param row - Linha (em caracteres, negativa conta de baixo)
+			* @param text - UTF-8; acentos viram a letra sem acento
+			* @param width - Largura da tela
+			* @param height - Altura da tela
+			*/
+		void text(int column, int row, const string &text, glm::vec4 color, int width, int height){
+			string ascii = fold(text);
+			int w = HUD_CELL_W * scale;
+			glm::vec4 first = box(column, row, 0, width, height);
+			float x = first.x, y = first.y;
+
+			for(unsigned int i = 0; i < ascii.size(); i++, x += w){
+				int c = (unsigned char) ascii[i] - 32;
+				if(c <= 0 or c >= 95)
+					continue;
+
+				float u = (c % HUD_COLUMNS) / (float) HUD_COLUMNS;
+				float v = (c / HUD_COLUMNS) / 6.0f;
+				float du = 5.0f / (HUD_COLUMNS * HUD_CELL_W);
+				float dv = 7.0f / (6 * HUD_CELL_H);
+				float x1 = x + 5 * scale, y1 = y + 7 * scale;
+
+				quad(x, y, u, v, color);
+				quad(x1, y, u + du, v, color);
+				quad(x, y1, u, v + dv, color);
+				quad(x1, y, u + du, v, color);
+				quad(x1, y1, u + du, v + dv, color);
+				quad(x, y1, u, v + dv, color);
+			}
+		}//text
+
+		/** Retângulo em pixels (esquerda, cima, direita, baixo; y para baixo) de
+			* alguns caracteres na mesma posição de text(), para desenhar junto do texto
+			* @param characters - Largura em caracteres
+			*/
+		glm::vec4 box(int column, int row, int characters, int width, int height){
+			int w = HUD_CELL_W * scale;
+			int h = (HUD_CELL_H + 2) * scale;
+			float x = column >= 0 ? 8 + column * w : width - 8 + column * w;
+			float y = row >= 0 ? 8 + row * h : height - 8 + row * h;
+			return glm::vec4(x, y, x + characters * w, y + 7 * scale);
+		}//box
+
+		// Termina o texto: só envia para a GPU se mudou
+		void end(){
+			if(vertices == previous)
+				return;
+
+			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+			glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.empty() ? NULL : &vertices[0], GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			count = vertices.size() / 8;
+			previous.swap(vertices);
+		}//end
+
+		/** Desenha todo o texto com um draw call
+			* @param shader - Shader do HUD
+			* @param width - Largura da tela
+			* @param height - Altura da tela
+			*/
+		void draw(Shader *shader, int width, int height){
+			if(not visible or count == 0)
+				return;
+
+			glDisable(GL_DEPTH_TEST);
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			shader->use();
+			shader->setVec2("screen", glm::vec2(width, height));
+			shader->setInt("atlas", 0);
+			GLState::bindTextureUnit(0, GL_TEXTURE_2D, atlas);
+			GLState::bindVertexArray(VAO);
+			glDrawArrays(GL_TRIANGLES, 0, count);
+			glDisable(GL_BLEND);
+			glEnable(GL_DEPTH_TEST);
+		}//draw
+
+	protected:
+		void quad(float x, float y, float u, float v, glm::vec4 color){
+			float vertex[8] = {x, y, u, v, color.r, color.g, color.b, color.a};
+			vertices.insert(vertices.end(), vertex, vertex + 8);
+		}//quad
+
+		// UTF-8 para ASCII: letras acentuadas do Latin-1 viram a letra base
+		static string fold(const string &text){
+			const char *latin = "AAAAAAACEEEEIIIIDNOOOOOxOUUUUYTsaaaaaaaceeeeiiiidnooooo/ouuuuyty";
+			string x;
+			for(unsigned int i = 0; i < text.size(); i++){
+				unsigned char c = text[i];
+				if(c < 0x80)
+					x += c;
+				else if((c == 0xC3) and i + 1 < text.size()){
+					unsigned char d = text[++i];
+					if(d >= 0x80 and d <= 0xBF)
+						x += latin[d - 0x80];
+				}
+				else if(c >= 0xC0){
+					// outros caracteres: pula a sequência e põe '?'
+					while(i + 1 < text.size() and ((unsigned char) text[i + 1] & 0xC0) == 0x80)
+						i++;
+					x += '?';
+				}
+			}
+			return x;
+		}//fold
+};
+
+#endif
@@ -0,0 +1,432 @@
+#ifndef INDIRECT_H
+#define INDIRECT_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/model.h>
+#include <learnopengl/shader_m.h>
+
+#include "drawstats.h"
+#include "glcaps.h"
+#include "glstate.h"
+#include "residency.h"
+#include "uniforms.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Primeiro atributo da matriz de cada desenho (mat4: quatro posições seguidas)
+#define ARENA_MODEL_ATTRIBUTE 5
+
+// Comando do glMultiDrawElementsIndirect, no layout que o OpenGL lê
+struct DrawCommand {
+	GLuint count;          // índices
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;   // posição da matriz do desenho no buffer de parâmetros
+};
+
+// Buffer de streaming dividido em regiões, uma por frame em andamento, como o
+// UniformRing: a CPU só reescreve uma região depois do fence da GPU. Com
+// glBufferStorage fica mapeado o tempo todo, sem ele cada escrita é um
+// glBufferSubData.
+class StreamRing {
+	protected:
+		GLenum target;
+		unsigned int buffer;
+		GLsizeiptr regionSize;
+		int frames;
+		int region;
+		GLintptr offset;
+		char *mapped;
+		vector<GLsync> fences;
+
+	public:
+		unsigned int stalls;  // vezes que a CPU esperou a GPU
+		unsigned int grows;   // vezes que o buffer precisou crescer
+
+		StreamRing(){
+			target = GL_ARRAY_BUFFER;
+			buffer = 0;
+			regionSize = 0;
+			frames = region = 0;
+			offset = 0;
+			mapped = NULL;
+			stalls = grows = 0;
+		}//StreamRing
+
+		/** Cria o buffer
+			* @param target - Onde o buffer é ligado para escrever (GL_ARRAY_BUFFER, GL_DRAW_INDIRECT_BUFFER)
+			* @param size - Bytes por frame
+			* @param count - Frames em andamento
+			*/
+		void create(GLenum target, GLsizeiptr size, int count = 3){
+			this->target = target;
+			frames = count;
+			region = 0;
+			offset = 0;
+			allocate(size);
+		}//create
+
+		void destroy(){
+			release();
+			buffer = 0;
+		}//destroy
+
+		/** Começa o uso da próxima região
+			* @param needed - Bytes que serão escritos nela; o buffer cresce se não couberem
+			*/
+		void begin(GLsizeiptr needed){
+			GLsync fence = fences[region];
+			if(fence){
+				if(glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED){
+					stalls++;
+					while(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+				}
+				glDeleteSync(fence);
+				fences[region] = 0;
+			}
+			// Os desenhos já enviados continuam lendo o buffer antigo até terminarem
+			if(needed > regionSize){
+				release();
+				allocate(max(needed, regionSize * 2));
+				region = 0;
+				grows++;
+			}
+			offset = 0;
+		}//begin
+
+		// Copia para a região atual; devolve a posição no buffer
+		GLintptr write(const void *data, GLsizeiptr size){
+			GLintptr position = region * regionSize + offset;
+			if(mapped)
+				memcpy(mapped + position, data, size);
+			else{
+				glBindBuffer(target, buffer);
+				glBufferSubData(target, position, size, data);
+			}
+			offset += size;
+			return position;
+		}//write
+
+		// Marca a região com um fence e passa para a próxima
+		void end(){
+			fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			region = (region + 1) % frames;
+		}//end
+
+		unsigned int id(){
+			return buffer;
+		}//id
+
+	protected:
+		void allocate(GLsizeiptr size){
+			regionSize = size;
+			fences.assign(frames, (GLsync) 0);
+			glGenBuffers(1, &buffer);
+			glBindBuffer(target, buffer);
+			if(UniformRing::persistent){
+				GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+				glBufferStorage(target, regionSize * frames, NULL, flags);
+				mapped = (char*) glMapBufferRange(target, 0, regionSize * frames, flags);
+			}
+			else
+				glBufferData(target, regionSize * frames, NULL, GL_STREAM_DRAW);
+			glBindBuffer(target, 0);
+		}//allocate
+
+		void release(){
+			for(unsigned int i = 0; i < fences.size(); i++)
+				if(fences[i])
+					glDeleteSync(fences[i]);
+			fences.assign(frames, (GLsync) 0);
+			if(not buffer)
+				return;
+			if(mapped){
+				glBindBuffer(target, buffer);
+				glUnmapBuffer(target);
+				glBindBuffer(target, 0);
+				mapped = NULL;
+			}
+			glDeleteBuffers(1, &buffer);
+		}//release
+};
+
+// Malha dentro da arena
+struct ArenaMesh {
+	GLint baseVertex;        // primeiro vértice no buffer da arena
+	vector<LodLevel> lods;   // first já no buffer de índices da arena
+	unsigned int material;   // classe de material (conjunto de texturas)
+};
+
+// Envio dirigido pela GPU. As malhas de todos os modelos registrados ficam num
+// buffer de vértices e num de índices compartilhados (índices de 16 bits,
+// relativos ao primeiro vértice de cada malha), e a matriz de cada desenho vai
+// num buffer de parâmetros, lida como atributo por instância (baseInstance
+// aponta a do desenho). Os desenhos de um frame são agrupados pelas texturas:
+// um glMultiDrawElementsIndirect por classe de material, com os comandos num
+// buffer persistente. Sem GL 4.3 (ou com indirect = false) o mesmo lote sai
+// em laço, um glDrawElementsBaseVertex por desenho com a matriz como atributo
+// constante. Usa o shader indirect.vs.
+class DrawArena {
+	protected:
+		unsigned int VAO, VBO, EBO;
+		vector<Vertex> vertices;
+		vector<unsigned short> indices;
+		bool dirty;                               // o que está na CPU ainda não foi enviado
+		vector<ArenaMesh> meshes;
+		vector<vector<unsigned int> > models;     // malhas de cada modelo
+		vector<vector<Texture> > materials;
+		vector<vector<string> > samplers;         // uniform de cada textura das classes
+		vector<vector<DrawCommand> > commands;    // fila de cada material
+		vector<vector<glm::mat4> > params;        // matriz de cada comando da fila
+		StreamRing commandRing, paramRing;
+
+	public:
+		static bool multiDraw;      // o driver tem glMultiDrawElementsIndirect com baseInstance
+		bool indirect;              // usa o multiDraw quando existe
+		unsigned long draws;        // desenhos do último flush
+		unsigned long batches;      // chamadas de desenho do último flush
+
+		DrawArena(){
+			VAO = VBO = EBO = 0;
+			dirty = false;
+			indirect = true;
+			draws = batches = 0;
+		}//DrawArena
+
+		// Verifica o suporte, depois do glad
+		static void init(GLADloadproc load){
+			multiDraw = GLCaps::require(GLAD_GL_VERSION_4_3, "GL_ARB_multi_draw_indirect", glad_glMultiDrawElementsIndirect, load,
+										"glMultiDrawElementsIndirect") and (GLAD_GL_VERSION_4_2 or GLCaps::hasExtension("GL_ARB_base_instance"));
+		}//init
+
+		// Cria os buffers e o VAO (mesmo layout do Mesh, mais a matriz)
+		void create(){
+			glGenVertexArrays(1, &VAO);
+			glGenBuffers(1, &VBO);
+			glGenBuffers(1, &EBO);
+
+			GLState::bindVertexArray(VAO);
+			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) 0);
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, Normal));
+			glEnableVertexAttribArray(2);
+			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, TexCoords));
+			glEnableVertexAttribArray(3);
+			glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, Tangent));
+			glEnableVertexAttribArray(4);
+			glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, Bitangent));
+			for(int i = 0; i < 4; i++)
+				glVertexAttribDivisor(ARENA_MODEL_ATTRIBUTE + i, 1);
+			GLState::bindVertexArray(0);
+
+			if(multiDraw){
+				commandRing.create(GL_DRAW_INDIRECT_BUFFER, 1024 * sizeof(DrawCommand));
+				paramRing.create(GL_ARRAY_BUFFER, 1024 * sizeof(glm::mat4));
+			}
+		}//create
+
+		void destroy(){
+			GLState::deleteVertexArray(VAO);
+			glDeleteBuffers(1, &VBO);
+			glDeleteBuffers(1, &EBO);
+			commandRing.destroy();
+			paramRing.destroy();
+			VAO = VBO = EBO = 0;
+		}//destroy
+
+		/** Copia as malhas de um modelo para a arena
+			* @return Identificador para draw(), ou -1 se alguma malha passa de 65536 vértices
+			*/
+		int add(const Model &model){
+			for(unsigned int i = 0; i < model.meshes.size(); i++)
+				if(model.meshes[i].vertices.size() > 65536)
+					return -1;
+
+			vector<unsigned int> ids;
+			for(unsigned int i = 0; i < model.meshes.size(); i++){
+				const Mesh &mesh = model.meshes[i];
+				ArenaMesh x;
+				x.baseVertex = vertices.size();
+				x.material = material(mesh.textures);
+				x.lods = mesh.lods;
+				for(unsigned int j = 0; j < x.lods.size(); j++)
+					x.lods[j].first += indices.size();
+				vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+				indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+				ids.push_back(meshes.size());
+				meshes.push_back(x);
+			}
+			models.push_back(ids);
+			dirty = true;
+			return models.size() - 1;
+		}//add
+
+		/** Põe um modelo na fila do frame
+			* @param model - Devolvido por add()
+			* @param lod - Nível de detalhe (o mais simples de cada malha, se ela tiver menos)
+			*/
+		void draw(int model, const glm::mat4 &matrix, unsigned int lod = 0){
+			const vector<unsigned int> &ids = models[model];
+			for(unsigned int i = 0; i < ids.size(); i++){
+				const ArenaMesh &mesh = meshes[ids[i]];
+				const LodLevel &level = mesh.lods[min(lod, (unsigned int) mesh.lods.size() - 1)];
+				DrawCommand command = {level.count, 1, level.first, mesh.baseVertex, 0};
+				commands[mesh.material].push_back(command);
+				params[mesh.material].push_back(matrix);
+			}
+		}//draw
+
+		/** Desenha a fila do frame com o shader (já em uso) e a esvazia
+			* @param shader - Programa com indirect.vs
+			*/
+		void flush(Shader &shader){
+			if(dirty)
+				upload();
+			draws = batches = 0;
+			for(unsigned int i = 0; i < commands.size(); i++)
+				draws += commands[i].size();
+			if(not draws)
+				return;
+
+			GLState::bindVertexArray(VAO);
+			if(multiDraw and indirect)
+				multiDrawIndirect(shader);
+			else
+				loop(shader);
+
+			for(unsigned int i = 0; i < commands.size(); i++){
+				commands[i].clear();
+				params[i].clear();
+			}
+		}//flush
+
+		// Caminho em uso e desenhos por chamada no último flush (HUD)
+		string status(){
+			char line[96];
+			snprintf(line, sizeof(line), "Envio %s: %lu desenhos em %lu chamadas", multiDraw and indirect ? "indireto" : "em laço",
+					 draws, batches);
+			return line;
+		}//status
+
+	protected:
+		// Índice da classe com essas texturas, criada se for nova
+		unsigned int material(const vector<Texture> &textures){
+			for(unsigned int i = 0; i < materials.size(); i++){
+				bool same = materials[i].size() == textures.size();
+				for(unsigned int j = 0; same and j < textures.size(); j++)
+					same = materials[i][j].id == textures[j].id and materials[i][j].type == textures[j].type;
+				if(same)
+					return i;
+			}
+			materials.push_back(textures);
+			samplers.push_back(Mesh::samplerNames(textures));
+			commands.push_back(vector<DrawCommand>());
+			params.push_back(vector<glm::mat4>());
+			return materials.size() - 1;
+		}//material
+
+		void upload(){
+			GLState::bindVertexArray(VAO);
+			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+			glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.empty() ? NULL : &vertices[0], GL_STATIC_DRAW);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.empty() ? NULL : &indices[0], GL_STATIC_DRAW);
+			dirty = false;
+		}//upload
+
+		// Liga as texturas de uma classe com os nomes que o Mesh usa (texture_diffuse1, ...)
+		void bind(Shader &shader, unsigned int material){
+			const vector<Texture> &textures = materials[material];
+			for(unsigned int i = 0; i < textures.size(); i++){
+				GLState::uniform1i(GLState::uniformLocation(shader.ID, samplers[material][i]), i);
+				Residency::useTexture(textures[i].id);
+				GLState::bindTextureUnit(i, GL_TEXTURE_2D, textures[i].id);
+			}
+		}//bind
+
+		// Todas as matrizes e todos os comandos do frame numa escrita cada; uma chamada por material
+		void multiDrawIndirect(Shader &shader){
+			commandRing.begin(draws * sizeof(DrawCommand));
+			paramRing.begin(draws * sizeof(glm::mat4));
+
+			// As filas ficam seguidas nas regiões: a posição das primeiras vale para todas
+			GLintptr paramOffset = -1, commandOffset = -1;
+			unsigned int instance = 0;
+			for(unsigned int i = 0; i < commands.size(); i++){
+				if(commands[i].empty())
+					continue;
+				for(unsigned int j = 0; j < commands[i].size(); j++)
+					commands[i][j].baseInstance = instance++;
+				GLintptr p = paramRing.write(&params[i][0], params[i].size() * sizeof(glm::mat4));
+				GLintptr c = commandRing.write(&commands[i][0], commands[i].size() * sizeof(DrawCommand));
+				if(paramOffset < 0){
+					paramOffset = p;
+					commandOffset = c;
+				}
+			}
+
+			// A matriz de cada desenho vem do buffer de parâmetros, indexada pelo baseInstance
+			glBindBuffer(GL_ARRAY_BUFFER, paramRing.id());
+			for(int k = 0; k < 4; k++){
+				glEnableVertexAttribArray(ARENA_MODEL_ATTRIBUTE + k);
+				glVertexAttribPointer(ARENA_MODEL_ATTRIBUTE + k, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+									  (void*) (paramOffset + k * sizeof(glm::vec4)));
+			}
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandRing.id());
+
+			GLintptr offset = commandOffset;
+			for(unsigned int i = 0; i < commands.size(); i++){
+				if(commands[i].empty())
+					continue;
+				bind(shader, i);
+				glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, (void*) offset, commands[i].size(), 0);
+				unsigned long triangles = 0;
+				for(unsigned int j = 0; j < commands[i].size(); j++)
+					triangles += commands[i][j].count / 3;
+				DrawStats::add(triangles);
+				batches++;
+				offset += commands[i].size() * sizeof(DrawCommand);
+			}
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+			commandRing.end();
+			paramRing.end();
+		}//multiDrawIndirect
+
+		// Um desenho por comando; a matriz vai como valor constante do atributo
+		void loop(Shader &shader){
+			for(int k = 0; k < 4; k++)
+				glDisableVertexAttribArray(ARENA_MODEL_ATTRIBUTE + k);
+			for(unsigned int i = 0; i < commands.size(); i++){
+				if(commands[i].empty())
+					continue;
+				bind(shader, i);
+				for(unsigned int j = 0; j < commands[i].size(); j++){
+					const DrawCommand &c = commands[i][j];
+					const glm::mat4 &m = params[i][j];
+					for(int k = 0; k < 4; k++)
+						glVertexAttrib4fv(ARENA_MODEL_ATTRIBUTE + k, &m[k][0]);
+					glDrawElementsBaseVertex(GL_TRIANGLES, c.count, GL_UNSIGNED_SHORT, (void*) (c.firstIndex * sizeof(unsigned short)),
+											 c.baseVertex);
+					DrawStats::add(c.count / 3);
+					batches++;
+				}
+			}
+		}//loop
+};
+
+bool DrawArena::multiDraw = false;
+
+#endif
@@ -0,0 +1,230 @@
+#ifndef INPUTLOG_H
+#define INPUTLOG_H
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Modo da entrada
+enum InputMode {
+	INPUT_LIVE,   // teclado de verdade, dt do relógio
+	INPUT_RECORD, // teclado de verdade gravado, dt fixo
+	INPUT_REPLAY  // eventos do arquivo, dt fixo
+};
+
+// Evento da entrada
+struct InputEvent {
+	unsigned long frame; // frame em que o evento é visto
+	float time;          // tempo da simulação no frame (conferido no replay)
+	char type;           // 'k' tecla, 'c' caractere, 's' scroll, 'r' resize, 'e' fim
+	int a, b;            // tecla e estado (1 apertada), caractere, ou largura e altura
+	float value;         // scroll
+};
+
+// Log de entrada para sessões repetíveis. Na gravação cada evento de tecla
+// e de caractere consumido pelos Controls, cada scroll e cada resize é
+// guardado com o número do frame; no replay os eventos voltam para a fila no
+// mesmo frame, antes do processInput, e o dt é fixo nos dois modos. Assim o
+// processInput vê exatamente a mesma sequência e a simulação chega no mesmo
+// estado.
+//
+// Formato (texto, um evento por linha):
+//   dt <segundos>
+//   <frame> <tempo> key <tecla GLFW> <0|1>
+//   <frame> <tempo> char <caractere>
+//   <frame> <tempo> scroll <y>
+//   <frame> <tempo> resize <largura> <altura>
+//   <frame> <tempo> end
+class InputLog {
+	protected:
+		string path;
+		vector<InputEvent> events;
+		unsigned int next;        // próximo evento do replay
+		map<int, int> keys;       // último estado gravado de cada tecla
+		bool ended;
+
+	public:
+		InputMode mode;
+		float dt;                 // passo fixo
+		unsigned long frame;      // frame atual
+		unsigned int mismatches;  // eventos em que o tempo da simulação divergiu
+
+		InputLog(){
+			mode = INPUT_LIVE;
+			dt = 1.0f / 60.0f;
+			frame = 0;
+			next = 0;
+			mismatches = 0;
+			ended = false;
+		}//InputLog
+
+		// Grava a entrada no arquivo (escrito no stop), com o dt atual
+		void record(const string &file){
+			path = file;
+			mode = INPUT_RECORD;
+		}//record
+
+		// Lê o arquivo para o replay
+		bool replay(const string &file){
+			ifstream in(file.c_str());
+			if(not in){
+				cout << "ERROR::INPUTLOG:: Não foi possível abrir " << file << endl;
+				return false;
+			}
+
+			string line;
+			while(getline(in, line)){
+				if(line.empty() or line[0] == '#')
+					continue;
+
+				stringstream text(line);
+				if(line.compare(0, 3, "dt ") == 0){
+					string word;
+					text >> word >> dt;
+					continue;
+				}
+
+				InputEvent e = {0, 0.0f, 0, 0, 0, 0.0f};
+				string type;
+				text >> e.frame >> e.time >> type;
+				if(type == "key")         { e.type = 'k'; text >> e.a >> e.b; }
+				else if(type == "char")   { e.type = 'c'; text >> e.a; }
+				else if(type == "scroll") { e.type = 's'; text >> e.value; }
+				else if(type == "resize") { e.type = 'r'; text >> e.a >> e.b; }
+				else if(type == "end")    { e.type = 'e'; }
+				else{
+					cout << "ERROR::INPUTLOG:: Evento desconhecido: " << line << endl;
+					return false;
+				}
+				events.push_back(e);
+			}
+
+			path = file;
+			mode = INPUT_REPLAY;
+			return true;
+		}//replay
+
+		// O replay aperta a tecla em algum momento (ex: 3, o modo da nave)
+		bool presses(int key){
+			for(unsigned int i = 0; i < events.size(); i++)
+				if(events[i].type == 'k' and events[i].a == key and events[i].b)
+					return true;
+			return false;
+		}//presses
+
+		// O dt do frame: fixo na gravação e no replay
+		float step(float measured){
+			return mode == INPUT_LIVE ? measured : dt;
+		}//step
+
+		/** Começa um frame do replay: devolve os eventos do frame, na ordem gravada
+			* @param time - Tempo da simulação
+			*/
+		vector<InputEvent> begin(float time){
+			vector<InputEvent> actions;
+			if(mode != INPUT_REPLAY)
+				return actions;
+
+			while(next < events.size() and events[next].frame == frame){
+				InputEvent &e = events[next++];
+				if(fabs(e.time - time) > 1e-4f * max(1.0f, fabs(time)))
+					mismatches++;
+
+				if(e.type == 'e')
+					ended = true;
+				else
+					actions.push_back(e);
+			}
+			return actions;
+		}//begin
+
+		// Termina o frame
+		void end(){
+			frame++;
+		}//end
+
+		// O replay chegou no fim
+		bool finished(){
+			return ended;
+		}//finished
+
+		/** Grava um evento de tecla (só as mudanças de estado)
+			* @param key - Tecla GLFW
+			* @param state - 1 apertada, 0 solta
+			* @param time - Tempo da simulação
+			*/
+		void key(int key, int state, float time){
+			if(mode != INPUT_RECORD)
+				return;
+
+			int last = keys.count(key) ? keys[key] : 0;
+			if(state != last){
+				InputEvent e = {frame, time, 'k', key, state, 0.0f};
+				events.push_back(e);
+			}
+			keys[key] = state;
+		}//key
+
+		// Grava um caractere
+		void character(int codepoint, float time){
+			if(mode != INPUT_RECORD)
+				return;
+			InputEvent e = {frame, time, 'c', codepoint, 0, 0.0f};
+			events.push_back(e);
+		}//character
+
+		// Grava um scroll. Os callbacks de scroll e de resize rodam no
+		// glfwPollEvents, depois do frame desenhado: o efeito só aparece no
+		// próximo, e é nele que o replay aplica o evento.
+		void scroll(float y, float time){
+			if(mode != INPUT_RECORD)
+				return;
+			InputEvent e = {frame + 1, time, 's', 0, 0, y};
+			events.push_back(e);
+		}//scroll
+
+		// Grava um resize (no frame seguinte, como o scroll)
+		void resize(int w, int h, float time){
+			if(mode != INPUT_RECORD)
+				return;
+			InputEvent e = {frame + 1, time, 'r', w, h, 0.0f};
+			events.push_back(e);
+		}//resize
+
+		// Fecha a gravação com o evento de fim
+		void stop(float time){
+			if(mode != INPUT_RECORD)
+				return;
+
+			InputEvent last = {frame, time, 'e', 0, 0, 0.0f};
+			events.push_back(last);
+
+			ofstream out(path.c_str());
+			out.precision(9);
+			out << "# log de entrada do Solar System Simulator" << endl;
+			out << "dt " << dt << endl;
+			for(unsigned int i = 0; i < events.size(); i++){
+				InputEvent &e = events[i];
+				out << e.frame << " " << e.time << " ";
+				switch(e.type){
+					case 'k': out << "key " << e.a << " " << e.b;         break;
+					case 'c': out << "char " << e.a;                      break;
+					case 's': out << "scroll " << e.value;                break;
+					case 'r': out << "resize " << e.a << " " << e.b;      break;
+					case 'e': out << "end";                               break;
+				}
+				out << endl;
+			}
+			cout << "Entrada gravada em " << path << ": " << events.size() << " eventos, " << frame << " frames" << endl;
+			mode = INPUT_LIVE;
+		}//stop
+};
+
+#endif
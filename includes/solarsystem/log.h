@@ -0,0 +1,150 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+// Log do terminal para mensagens de dentro do laço de frames. Quem chama só
+// enfileira; uma thread escreve na saída padrão, então um terminal lento não
+// segura o frame. Mensagens iguais seguidas viram uma linha "repetida N
+// vezes", escrita quando chega outra mensagem ou depois de repeatWindow
+// segundos (aí a próxima cópia volta a sair inteira). No máximo perSecond
+// linhas por segundo são aceitas (o excesso é contado e avisado no segundo
+// seguinte).
+class Log {
+	protected:
+		static mutex lock;
+		static condition_variable wake;
+		static deque<string> queue;
+		static thread *worker;
+		static bool running;
+
+		static string last;           // última mensagem aceita
+		static unsigned int repeats;  // repetições dela ainda não escritas
+		static chrono::steady_clock::time_point shown; // quando ela foi escrita
+		static chrono::steady_clock::time_point second; // início do segundo atual
+		static unsigned int lines;    // linhas aceitas no segundo atual
+		static unsigned int dropped;  // linhas recusadas no segundo atual
+
+	public:
+		static unsigned int perSecond;
+		static double repeatWindow;   // segundos em que as repetições ficam juntas
+
+		// Enfileira uma linha
+		static void print(const string &text){
+			unique_lock<mutex> guard(lock);
+			if(not worker){
+				running = true;
+				worker = new thread(write);
+				atexit(stop);
+			}
+
+			chrono::steady_clock::time_point now = chrono::steady_clock::now();
+			if(text == last and now - shown < window()){
+				repeats++;
+				return;
+			}
+			flushRepeats();
+
+			// Janela de um segundo
+			if(now - second >= chrono::seconds(1)){
+				if(dropped)
+					queue.push_back("(" + to_string(dropped) + " mensagens suprimidas)");
+				second = now;
+				lines = 0;
+				dropped = 0;
+			}
+			if(lines >= perSecond){
+				dropped++;
+				return;
+			}
+
+			lines++;
+			last = text;
+			shown = now;
+			queue.push_back(text);
+			wake.notify_one();
+		}//print
+
+		// Escreve o que falta e termina a thread (também chamado no atexit)
+		static void stop(){
+			thread *t;
+			{
+				unique_lock<mutex> guard(lock);
+				if(not worker)
+					return;
+				flushRepeats();
+				if(dropped)
+					queue.push_back("(" + to_string(dropped) + " mensagens suprimidas)");
+				dropped = 0;
+				running = false;
+				t = worker;
+				worker = NULL;
+			}
+			wake.notify_one();
+			t->join();
+			delete t;
+		}//stop
+
+	protected:
+		static void flushRepeats(){
+			if(repeats)
+				queue.push_back("  (repetida " + to_string(repeats) + " vezes)");
+			repeats = 0;
+		}//flushRepeats
+
+		static chrono::steady_clock::duration window(){
+			return chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(repeatWindow));
+		}//window
+
+		// Thread de escrita: pega tudo que estiver na fila de uma vez; sem
+		// mensagens novas, ainda escreve as repetições quando a janela acaba
+		static void write(){
+			unique_lock<mutex> guard(lock);
+			while(true){
+				wake.wait_for(guard, window(), []{ return not queue.empty() or not running; });
+				if(repeats and chrono::steady_clock::now() - shown >= window()){
+					flushRepeats();
+					last.clear();
+				}
+				if(queue.empty() and not running)
+					return;
+				if(queue.empty())
+					continue;
+
+				deque<string> batch;
+				batch.swap(queue);
+				guard.unlock();
+				for(unsigned int i = 0; i < batch.size(); i++){
+					fputs(batch[i].c_str(), stdout);
+					fputc('\n', stdout);
+				}
+				fflush(stdout);
+				guard.lock();
+			}
+		}//write
+};
+
+mutex Log::lock;
+condition_variable Log::wake;
+deque<string> Log::queue;
+thread *Log::worker = NULL;
+bool Log::running = false;
+string Log::last;
+unsigned int Log::repeats = 0;
+chrono::steady_clock::time_point Log::shown;
+chrono::steady_clock::time_point Log::second;
+unsigned int Log::lines = 0;
+unsigned int Log::dropped = 0;
+unsigned int Log::perSecond = 20;
+double Log::repeatWindow = 5.0;
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef LZ4BLOCK_H
+#define LZ4BLOCK_H
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+// Compressão no formato de bloco do LZ4: sequências de literais seguidas de
+// uma cópia (distância de até 64 kB, ao menos 4 bytes). Descomprimir é só
+// copiar bytes, bem mais rápido que ler o arquivo do disco, e o resultado é
+// compatível com LZ4_decompress_safe. O compressor é o guloso simples, com
+// uma tabela de 4096 posições; não chega à taxa do LZ4 HC.
+class LZ4Block {
+	public:
+		// Maior saída possível para size bytes de entrada
+		static size_t bound(size_t size){
+			return size + size / 255 + 16;
+		}//bound
+
+		/** Comprime um bloco
+			* @param src - Entrada
+			* @param size - Bytes da entrada
+			* @param dst - Saída, substituída
+			*/
+		static void compress(const unsigned char *src, size_t size, vector<unsigned char> &dst){
+			const size_t minMatch = 4, lastLiterals = 5, matchLimit = 12;
+			dst.clear();
+			dst.reserve(bound(size));
+
+			vector<long> table(1 << hashLog, -1);
+			size_t anchor = 0, i = 0;
+			while(size > matchLimit and i < size - matchLimit){
+				unsigned int sequence = read32(src + i);
+				unsigned int h = hash(sequence);
+				long ref = table[h];
+				table[h] = i;
+				if(ref < 0 or i - ref > 65535 or read32(src + ref) != sequence){
+					// Sem repetição: acelera nos trechos que não comprimem
+					i += 1 + ((i - anchor) >> 6);
+					continue;
+				}
+
+				size_t length = minMatch, longest = size - lastLiterals - i;
+				while(length < longest and src[ref + length] == src[i + length])
+					length++;
+				while(i > anchor and ref > 0 and src[i - 1] == src[ref - 1]){
+					i--;
+					ref--;
+					length++;
+				}
+
+				emit(src + anchor, i - anchor, i - ref, length - minMatch, dst);
+				i += length;
+				anchor = i;
+			}
+
+			// Os últimos bytes são sempre literais
+			size_t literals = size - anchor;
+			dst.push_back((unsigned char) (min(literals, (size_t) 15) << 4));
+			if(literals >= 15)
+				extend(literals - 15, dst);
+			dst.insert(dst.end(), src + anchor, src + size);
+		}//compress
+
+		/** Descomprime um bloco, conferindo cada limite (entrada corrompida não escreve fora de dst)
+			* @param src - Bloco comprimido
+			* @param size - Bytes do bloco
+			* @param dst - Saída, com o tamanho original
+			* @param rawSize - Tamanho original
+			* @return false se o bloco não é válido ou não tem rawSize bytes
+			*/
+		static bool decompress(const unsigned char *src, size_t size, unsigned char *dst, size_t rawSize){
+			size_t ip = 0, op = 0;
+			while(ip < size){
+				unsigned char token = src[ip++];
+
+				size_t literals = token >> 4;
+				if(literals == 15 and not readLength(src, size, ip, literals))
+					return false;
+				if(literals > size - ip or literals > rawSize - op)
+					return false;
+				memcpy(dst + op, src + ip, literals);
+				ip += literals;
+				op += literals;
+				if(ip == size)
+					break;
+
+				if(size - ip < 2)
+					return false;
+				size_t offset = src[ip] | (src[ip + 1] << 8);
+				ip += 2;
+				if(offset == 0 or offset > op)
+					return false;
+
+				size_t length = token & 15;
+				if(length == 15 and not readLength(src, size, ip, length))
+					return false;
+				length += 4;
+				if(length > rawSize - op)
+					return false;
+
+				// A cópia pode se sobrepor ao que está sendo escrito (repetições curtas)
+				unsigned char *from = dst + op - offset, *to = dst + op;
+				for(size_t k = 0; k < length; k++)
+					to[k] = from[k];
+				op += length;
+			}
+			return op == rawSize;
+		}//decompress
+
+	protected:
+		static const int hashLog = 12;
+
+		static unsigned int read32(const unsigned char *p){
+			unsigned int x;
+			memcpy(&x, p, 4);
+			return x;
+		}//read32
+
+		static unsigned int hash(unsigned int sequence){
+			return (sequence * 2654435761u) >> (32 - hashLog);
+		}//hash
+
+		// Comprimento acima de 15: bytes 255 enquanto couber, depois o resto
+		static void extend(size_t length, vector<unsigned char> &dst){
+			for(; length >= 255; length -= 255)
+				dst.push_back(255);
+			dst.push_back((unsigned char) length);
+		}//extend
+
+		static bool readLength(const unsigned char *src, size_t size, size_t &ip, size_t &length){
+			unsigned char b;
+			do{
+				if(ip >= size)
+					return false;
+				b = src[ip++];
+				length += b;
+			}while(b == 255);
+			return true;
+		}//readLength
+
+		static void emit(const unsigned char *literals, size_t count, size_t offset, size_t length, vector<unsigned char> &dst){
+			dst.push_back((unsigned char) ((min(count, (size_t) 15) << 4) | min(length, (size_t) 15)));
+			if(count >= 15)
+				extend(count - 15, dst);
+			dst.insert(dst.end(), literals, literals + count);
+			dst.push_back((unsigned char) (offset & 0xff));
+			dst.push_back((unsigned char) (offset >> 8));
+			if(length >= 15)
+				extend(length - 15, dst);
+		}//emit
+};
+
+#endif
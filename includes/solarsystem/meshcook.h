@@ -0,0 +1,419 @@
+#ifndef MESHCOOK_H
+#define MESHCOOK_H
+
+#include <learnopengl/mesh.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Eficiência do cache de vértices transformados, simulado como uma FIFO
+struct CacheStats {
+	double acmr;  // vértices transformados por triângulo (0.5 a 3)
+	double atvr;  // vértices transformados por vértice do buffer (1 é o ótimo)
+};
+
+// Cozimento das malhas na importação. O Assimp entrega os índices na ordem do
+// arquivo e, sem JoinIdenticalVertices, um vértice por canto de triângulo:
+// cada vértice é transformado de novo em todo triângulo. O cozimento
+//   1. solda os vértices iguais (posição, normal e coordenada exatas; tangentes
+//      quase paralelas, que o CalcTangentSpace calcula por face)
+//   2. ordena os triângulos para o cache de vértices (Forsyth, cache LRU de 32)
+//   3. reordena grupos desses triângulos de fora para dentro, para desenhar
+//      primeiro o que tende a cobrir o resto (menos overdraw), sem perder mais
+//      que 5% do ACMR
+//   4. renumera os vértices na ordem do primeiro uso (leitura sequencial)
+// Com até 65536 vértices o Mesh envia os índices com 16 bits.
+class MeshCook {
+	protected:
+		static mutex lock;
+		static unsigned long meshes, shortMeshes;
+		static unsigned long long verticesIn, verticesOut, triangles, missesIn, missesOut;
+		static double ms;
+
+	public:
+		static bool enabled;
+		static const int cacheSize = 32;     // do otimizador
+		static const int fifoSize = 16;      // das estatísticas
+		static float overdrawThreshold;     // ACMR de um grupo em relação ao da ordem do cache
+
+		/** Solda, reordena e renumera uma malha
+			* @param vertices, indices - Substituídos pelos cozidos
+			*/
+		static void cook(vector<Vertex> &vertices, vector<unsigned int> &indices){
+			if(indices.empty() or indices.size() % 3)
+				return;
+			chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+			unsigned long before = vertices.size();
+			unsigned long missBefore = misses(indices, vertices.size(), fifoSize);
+
+			weld(vertices, indices);
+			optimizeCache(indices, vertices.size());
+			optimizeOverdraw(indices, vertices, overdrawThreshold);
+			optimizeFetch(vertices, indices);
+
+			unsigned long missAfter = misses(indices, vertices.size(), fifoSize);
+			double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+			unique_lock<mutex> guard(lock);
+			meshes++;
+			shortMeshes += vertices.size() <= 65536;
+			verticesIn += before;
+			verticesOut += vertices.size();
+			triangles += indices.size() / 3;
+			missesIn += missBefore;
+			missesOut += missAfter;
+			ms += elapsed;
+		}//cook
+
+		// ACMR e ATVR de um buffer de índices
+		static CacheStats analyze(const vector<unsigned int> &indices, unsigned int vertexCount, int cache = fifoSize){
+			CacheStats x = {0.0, 0.0};
+			double m = misses(indices, vertexCount, cache);
+			if(not indices.empty())
+				x.acmr = 3.0 * m / indices.size();
+			if(vertexCount)
+				x.atvr = m / vertexCount;
+			return x;
+		}//analyze
+
+		// Totais das malhas cozidas até agora (início e saída)
+		static string summary(){
+			unique_lock<mutex> guard(lock);
+			char line[256];
+			if(not meshes)
+				return "Malhas: nenhuma cozida";
+			double t = max(triangles, 1ull);
+			snprintf(line, sizeof(line), "Malhas cozidas: %lu (%lu com índices de 16 bits) em %.0f ms, vértices %llu -> %llu, "
+					 "ACMR %.2f -> %.2f, ATVR %.2f -> %.2f", meshes, shortMeshes, ms, verticesIn, verticesOut,
+					 missesIn / t, missesOut / t, (double) missesIn / max(verticesIn, 1ull), (double) missesOut / max(verticesOut, 1ull));
+			return line;
+		}//summary
+
+		/** Vértices iguais viram um só
+			* @param vertices - Só os distintos, na ordem do primeiro uso
+			* @param indices - Renumerados
+			*/
+		static void weld(vector<Vertex> &vertices, vector<unsigned int> &indices){
+			const unsigned int none = 0xffffffffu;
+			vector<Vertex> distinct;
+			vector<unsigned int> next;  // lista dos vértices distintos com o mesmo hash
+			unordered_map<unsigned long long, unsigned int> head;
+			vector<unsigned int> remap(vertices.size(), none);
+			distinct.reserve(vertices.size());
+			head.reserve(vertices.size());
+
+			for(unsigned int i = 0; i < indices.size(); i++){
+				unsigned int v = indices[i];
+				if(remap[v] == none){
+					unsigned long long h = hash(vertices[v]);
+					unordered_map<unsigned long long, unsigned int>::iterator it = head.find(h);
+					unsigned int j = it == head.end() ? none : it->second;
+					while(j != none and not same(distinct[j], vertices[v]))
+						j = next[j];
+					if(j == none){
+						j = distinct.size();
+						distinct.push_back(vertices[v]);
+						next.push_back(it == head.end() ? none : it->second);
+						head[h] = j;
+					}
+					remap[v] = j;
+				}
+				indices[i] = remap[v];
+			}
+			vertices.swap(distinct);
+		}//weld
+
+		/** Ordem dos triângulos para o cache de vértices (Forsyth, "Linear-speed
+			* vertex cache optimisation"): cada vértice tem uma nota pela posição no
+			* cache e pelos triângulos que ainda faltam; sai o triângulo de maior nota
+			* entre os que tocam o cache
+			*/
+		static void optimizeCache(vector<unsigned int> &indices, unsigned int vertexCount){
+			unsigned int faces = indices.size() / 3;
+			if(faces == 0)
+				return;
+
+			// Triângulos de cada vértice; os ainda não emitidos ficam no começo da lista
+			vector<unsigned int> offsets(vertexCount + 1, 0), live(vertexCount, 0), adjacency(indices.size());
+			for(unsigned int i = 0; i < indices.size(); i++)
+				live[indices[i]]++;
+			for(unsigned int v = 0; v < vertexCount; v++)
+				offsets[v + 1] = offsets[v] + live[v];
+			vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+			for(unsigned int i = 0; i < indices.size(); i++)
+				adjacency[fill[indices[i]]++] = i / 3;
+
+			vector<int> position(vertexCount, -1);
+			vector<float> vertexScore(vertexCount), faceScore(faces, 0.0f);
+			vector<bool> emitted(faces, false);
+			for(unsigned int v = 0; v < vertexCount; v++)
+				vertexScore[v] = score(-1, live[v]);
+			for(unsigned int f = 0; f < faces; f++)
+				faceScore[f] = vertexScore[indices[3 * f]] + vertexScore[indices[3 * f + 1]] + vertexScore[indices[3 * f + 2]];
+
+			vector<unsigned int> output;
+			output.reserve(indices.size());
+			vector<unsigned int> cache, grown;
+			unsigned int cursor = 0;
+			int best = max_element(faceScore.begin(), faceScore.end()) - faceScore.begin();
+
+			while(output.size() < indices.size()){
+				// Nenhum triângulo toca o cache: o próximo ainda não emitido
+				if(best < 0){
+					while(emitted[cursor])
+						cursor++;
+					best = cursor;
+				}
+
+				const unsigned int *tri = &indices[3 * best];
+				output.insert(output.end(), tri, tri + 3);
+				emitted[best] = true;
+
+				// Tira o triângulo das listas dos seus vértices
+				for(int k = 0; k < 3; k++){
+					unsigned int v = tri[k];
+					unsigned int *list = &adjacency[offsets[v]];
+					for(unsigned int a = 0; a < live[v]; a++)
+						if(list[a] == (unsigned int) best){
+							swap(list[a], list[live[v] - 1]);
+							live[v]--;
+							break;
+						}
+				}
+
+				// Os vértices do triângulo vão para a frente do cache
+				grown.assign(tri, tri + 3);
+				for(unsigned int c = 0; c < cache.size(); c++)
+					if(cache[c] != tri[0] and cache[c] != tri[1] and cache[c] != tri[2])
+						grown.push_back(cache[c]);
+				for(unsigned int c = cacheSize; c < grown.size(); c++)
+					position[grown[c]] = -1;
+				for(unsigned int c = 0; c < grown.size(); c++){
+					if(c < (unsigned int) cacheSize)
+						position[grown[c]] = c;
+					vertexScore[grown[c]] = score(position[grown[c]], live[grown[c]]);
+				}
+
+				// Novas notas dos triângulos que tocam o cache
+				best = -1;
+				float bestScore = -1.0f;
+				for(unsigned int c = 0; c < grown.size(); c++){
+					unsigned int v = grown[c];
+					for(unsigned int a = 0; a < live[v]; a++){
+						unsigned int f = adjacency[offsets[v] + a];
+						faceScore[f] = vertexScore[indices[3 * f]] + vertexScore[indices[3 * f + 1]] + vertexScore[indices[3 * f + 2]];
+						if(faceScore[f] > bestScore){
+							bestScore = faceScore[f];
+							best = f;
+						}
+					}
+				}
+				if(grown.size() > (unsigned int) cacheSize)
+					grown.resize(cacheSize);
+				cache.swap(grown);
+			}
+			indices.swap(output);
+		}//optimizeCache
+
+		/** Ordem dos grupos de triângulos contra o overdraw (Sander, Nehab e Barczak,
+			* "Fast triangle reordering for vertex locality and reduced overdraw"): a
+			* ordem do cache é cortada em grupos que mantêm o ACMR dentro de threshold
+			* e os grupos são desenhados de fora para dentro, pela posição do centro em
+			* relação ao centro da malha na direção da normal média do grupo
+			*/
+		static void optimizeOverdraw(vector<unsigned int> &indices, const vector<Vertex> &vertices, float threshold){
+			unsigned int faces = indices.size() / 3;
+			if(faces < 2)
+				return;
+
+			// Cortes fortes: triângulos sem nenhum vértice no cache (a ordem recomeçou)
+			vector<unsigned int> stamp(vertices.size(), 0), hard;
+			unsigned int now = fifoSize + 1;
+			for(unsigned int f = 0; f < faces; f++)
+				if(triangleMisses(&indices[3 * f], stamp, now) == 3 or f == 0)
+					hard.push_back(f);
+			hard.push_back(faces);
+
+			// Cortes fracos: dentro de cada um, assim que o ACMR do pedaço chega a threshold vezes o do grupo
+			vector<unsigned int> clusters;
+			for(unsigned int c = 0; c + 1 < hard.size(); c++){
+				unsigned int start = hard[c], end = hard[c + 1];
+				now += fifoSize + 1;
+				unsigned int total = 0;
+				for(unsigned int f = start; f < end; f++)
+					total += triangleMisses(&indices[3 * f], stamp, now);
+				float limit = threshold * total / (end - start);
+
+				clusters.push_back(start);
+				now += fifoSize + 1;
+				unsigned int running = 0, count = 0;
+				for(unsigned int f = start; f < end; f++){
+					running += triangleMisses(&indices[3 * f], stamp, now);
+					count++;
+					if(f + 1 < end and running <= limit * count){
+						clusters.push_back(f + 1);
+						now += fifoSize + 1;
+						running = count = 0;
+					}
+				}
+			}
+			clusters.push_back(faces);
+
+			// Centro da malha, pela área
+			glm::dvec3 center(0.0);
+			double area = 0.0;
+			for(unsigned int f = 0; f < faces; f++){
+				glm::dvec3 a(vertices[indices[3 * f]].Position), b(vertices[indices[3 * f + 1]].Position), c(vertices[indices[3 * f + 2]].Position);
+				double w = glm::length(glm::cross(b - a, c - a));
+				center += w * (a + b + c) / 3.0;
+				area += w;
+			}
+			if(area > 0.0)
+				center /= area;
+
+			// Nota de cada grupo: os de fora (centro à frente da normal) primeiro
+			vector<pair<double, unsigned int> > order;
+			for(unsigned int c = 0; c + 1 < clusters.size(); c++){
+				glm::dvec3 centroid(0.0), normal(0.0);
+				double w = 0.0;
+				for(unsigned int f = clusters[c]; f < clusters[c + 1]; f++){
+					glm::dvec3 a(vertices[indices[3 * f]].Position), b(vertices[indices[3 * f + 1]].Position), d(vertices[indices[3 * f + 2]].Position);
+					glm::dvec3 n = glm::cross(b - a, d - a);
+					double s = glm::length(n);
+					centroid += s * (a + b + d) / 3.0;
+					normal += n;
+					w += s;
+				}
+				double key = 0.0;
+				if(w > 0.0 and glm::length(normal) > 0.0)
+					key = glm::dot(centroid / w - center, glm::normalize(normal));
+				order.push_back(make_pair(-key, c));
+			}
+			stable_sort(order.begin(), order.end());
+
+			vector<unsigned int> output;
+			output.reserve(indices.size());
+			for(unsigned int i = 0; i < order.size(); i++){
+				unsigned int c = order[i].second;
+				output.insert(output.end(), indices.begin() + 3 * clusters[c], indices.begin() + 3 * clusters[c + 1]);
+			}
+			indices.swap(output);
+		}//optimizeOverdraw
+
+		// Vértices na ordem do primeiro uso; os que nenhum triângulo usa saem
+		static void optimizeFetch(vector<Vertex> &vertices, vector<unsigned int> &indices){
+			const unsigned int none = 0xffffffffu;
+			vector<unsigned int> remap(vertices.size(), none);
+			vector<Vertex> ordered;
+			ordered.reserve(vertices.size());
+			for(unsigned int i = 0; i < indices.size(); i++){
+				unsigned int v = indices[i];
+				if(remap[v] == none){
+					remap[v] = ordered.size();
+					ordered.push_back(vertices[v]);
+				}
+				indices[i] = remap[v];
+			}
+			vertices.swap(ordered);
+		}//optimizeFetch
+
+	protected:
+		struct ScoreTable {
+			float cached[cacheSize + 1];  // fora do cache, depois cada posição
+			float valence[32];            // triângulos que faltam
+
+			ScoreTable(){
+				cached[0] = 0.0f;
+				for(int p = 0; p < cacheSize; p++)
+					cached[p + 1] = p < 3 ? 0.75f : pow(1.0f - (p - 3) / (float) (cacheSize - 3), 1.5f);
+				valence[0] = 0.0f;
+				for(int r = 1; r < 32; r++)
+					valence[r] = 2.0f / sqrt((float) r);
+			}//ScoreTable
+		};
+
+		// Nota de um vértice: recém-usados ganham mais (os três do último triângulo
+		// um valor fixo, para não repetir o mesmo triângulo), e os com poucos
+		// triângulos faltando também, para não deixar vértices isolados para trás
+		static float score(int position, unsigned int remaining){
+			// As duas partes tabeladas: a nota é recalculada para o cache inteiro a cada triângulo
+			static const ScoreTable table;
+			if(remaining == 0)
+				return -1.0f;
+			return table.cached[position + 1] + (remaining < 32 ? table.valence[remaining] : 2.0f / sqrt((float) remaining));
+		}//score
+
+		// Vértices transformados numa FIFO de cache posições
+		static unsigned long misses(const vector<unsigned int> &indices, unsigned int vertexCount, int cache){
+			vector<unsigned int> stamp(vertexCount, 0);
+			unsigned int now = cache + 1;
+			unsigned long x = 0;
+			for(unsigned int i = 0; i < indices.size(); i++)
+				if(now - stamp[indices[i]] > (unsigned int) cache){
+					stamp[indices[i]] = now++;
+					x++;
+				}
+			return x;
+		}//misses
+
+		// Faltas de um triângulo na FIFO de fifoSize (stamp: quando cada vértice entrou)
+		static unsigned int triangleMisses(const unsigned int *tri, vector<unsigned int> &stamp, unsigned int &now){
+			unsigned int x = 0;
+			for(int k = 0; k < 3; k++)
+				if(now - stamp[tri[k]] > (unsigned int) fifoSize){
+					stamp[tri[k]] = now++;
+					x++;
+				}
+			return x;
+		}//triangleMisses
+
+		static unsigned long long hash(const Vertex &v){
+			float key[8] = {v.Position.x, v.Position.y, v.Position.z, v.Normal.x, v.Normal.y, v.Normal.z, v.TexCoords.x, v.TexCoords.y};
+			unsigned char bytes[sizeof(key)];
+			memcpy(bytes, key, sizeof(key));
+			unsigned long long h = 14695981039346656037ull;
+			for(unsigned int i = 0; i < sizeof(bytes); i++){
+				h ^= bytes[i];
+				h *= 1099511628211ull;
+			}
+			return h;
+		}//hash
+
+		// Posição, normal e coordenada iguais; tangente e bitangente quase paralelas
+		static bool same(const Vertex &a, const Vertex &b){
+			return a.Position == b.Position and a.Normal == b.Normal and a.TexCoords == b.TexCoords
+				   and parallel(a.Tangent, b.Tangent) and parallel(a.Bitangent, b.Bitangent);
+		}//same
+
+		static bool parallel(const glm::vec3 &a, const glm::vec3 &b){
+			float la = glm::length(a), lb = glm::length(b);
+			if(la == 0.0f or lb == 0.0f)
+				return la == lb;
+			return glm::dot(a, b) >= 0.999f * la * lb;
+		}//parallel
+};
+
+mutex MeshCook::lock;
+unsigned long MeshCook::meshes = 0;
+unsigned long MeshCook::shortMeshes = 0;
+unsigned long long MeshCook::verticesIn = 0;
+unsigned long long MeshCook::verticesOut = 0;
+unsigned long long MeshCook::triangles = 0;
+unsigned long long MeshCook::missesIn = 0;
+unsigned long long MeshCook::missesOut = 0;
+double MeshCook::ms = 0.0;
+bool MeshCook::enabled = true;
+float MeshCook::overdrawThreshold = 1.05f;
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef MIPCHAIN_H
+#define MIPCHAIN_H
+
+#include <stb_image.h>
+#include "tempfile.h"
+#include "vfs.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Tamanho de uma imagem e da sua cadeia de mips
+struct MipInfo {
+	int width, height;   // nível 0
+	int components;
+	int levels;
+};
+
+// Cadeia de mips em arquivo: ao lado de cada imagem fica um "<imagem>.mips"
+// com todos os níveis já reduzidos e sem compressão, do maior ao menor:
+//   "MIP1", largura, altura, componentes, níveis (int32), níveis 0..n-1
+// Assim um nível é lido com um seek, sem decodificar a imagem inteira. O
+// arquivo é criado na primeira leitura (decodificando a imagem uma vez) e
+// refeito se o tamanho da imagem não bater; sem permissão de escrita a
+// imagem é decodificada a cada leitura. Imagem e cadeia podem vir do pacote
+// (Vfs): uma cadeia dentro dele é lida direto do mapeamento.
+class MipChain {
+	public:
+		// Tamanho da imagem, lido só do cabeçalho
+		static bool info(const string &file, MipInfo &x){
+			if(not Vfs::imageInfo(file, x.width, x.height, x.components))
+				return false;
+			x.levels = levelCount(x.width, x.height);
+			return true;
+		}//info
+
+		static int levelCount(int width, int height){
+			int levels = 1;
+			while(max(width, height) >> levels)
+				levels++;
+			return levels;
+		}//levelCount
+
+		static unsigned long levelBytes(const MipInfo &x, int level){
+			return (unsigned long) max(1, x.width >> level) * max(1, x.height >> level) * x.components;
+		}//levelBytes
+
+		// Primeiro nível com o lado maior de até size pixels
+		static int levelFor(const MipInfo &x, int size){
+			int level = 0;
+			while(level + 1 < x.levels and max(x.width >> level, x.height >> level) > size)
+				level++;
+			return level;
+		}//levelFor
+
+		/** Lê os níveis de first até o último
+			* @param file - Imagem original
+			* @param levels - levels[0] é o nível first
+			*/
+		static bool read(const string &file, int first, MipInfo &x, vector<vector<unsigned char> > &levels){
+			levels.clear();
+			if(not info(file, x))
+				return false;
+			first = min(max(first, 0), x.levels - 1);
+
+			if(readCache(file, first, x, levels))
+				return true;
+
+			// Sem cache: decodifica, reduz e grava para as próximas leituras
+			vector<vector<unsigned char> > chain;
+			if(not build(file, x, chain))
+				return false;
+			writeCache(file, x, chain);
+			for(int l = first; l < x.levels; l++){
+				levels.push_back(vector<unsigned char>());
+				levels.back().swap(chain[l]);
+			}
+			return true;
+		}//read
+
+		// Nível seguinte da cadeia: média de blocos 2x2 (a borda ímpar repete)
+		static vector<unsigned char> half(const vector<unsigned char> &src, int width, int height, int components){
+			return half(&src[0], width, height, components);
+		}//half
+
+		static vector<unsigned char> half(const unsigned char *src, int width, int height, int components){
+			int w = max(1, width >> 1), h = max(1, height >> 1);
+			vector<unsigned char> dst((size_t) w * h * components);
+			for(int y = 0; y < h; y++){
+				size_t y0 = min(2 * y, height - 1), y1 = min(2 * y + 1, height - 1);
+				for(int x = 0; x < w; x++){
+					size_t x0 = min(2 * x, width - 1), x1 = min(2 * x + 1, width - 1);
+					for(int c = 0; c < components; c++){
+						int sum = src[(y0 * width + x0) * components + c] + src[(y0 * width + x1) * components + c]
+								+ src[(y1 * width + x0) * components + c] + src[(y1 * width + x1) * components + c];
+						dst[((size_t) y * w + x) * components + c] = (unsigned char) ((sum + 2) / 4);
+					}
+				}
+			}
+			return dst;
+		}//half
+
+	protected:
+		// Decodifica a imagem e calcula todos os níveis
+		static bool build(const string &file, const MipInfo &x, vector<vector<unsigned char> > &chain){
+			int width, height, components;
+			unsigned char *data = Vfs::loadImage(file, width, height, components, x.components);
+			if(not data)
+				return false;
+
+			chain.resize(x.levels);
+			chain[0].assign(data, data + levelBytes(x, 0));
+			stbi_image_free(data);
+			for(int l = 1; l < x.levels; l++)
+				chain[l] = half(chain[l - 1], max(1, x.width >> (l - 1)), max(1, x.height >> (l - 1)), x.components);
+			return true;
+		}//build
+
+		static bool readCache(const string &file, int first, const MipInfo &x, vector<vector<unsigned char> > &levels){
+			size_t size;
+			const unsigned char *data = Vfs::map(file + ".mips", size);
+			if(data)
+				return readPacked(data, size, first, x, levels);
+
+			FILE *in = fopen((file + ".mips").c_str(), "rb");
+			if(not in)
+				return false;
+
+			char magic[4];
+			int header[4];
+			bool valid = fread(magic, 1, 4, in) == 4 and string(magic, 4) == "MIP1" and fread(header, sizeof(int), 4, in) == 4
+						 and header[0] == x.width and header[1] == x.height and header[2] == x.components and header[3] == x.levels;
+
+			unsigned long offset = 4 + 4 * sizeof(int);
+			for(int l = 0; l < first; l++)
+				offset += levelBytes(x, l);
+			valid = valid and fseek(in, offset, SEEK_SET) == 0;
+
+			for(int l = first; l < x.levels and valid; l++){
+				levels.push_back(vector<unsigned char>(levelBytes(x, l)));
+				valid = fread(&levels.back()[0], 1, levels.back().size(), in) == levels.back().size();
+			}
+			fclose(in);
+
+			if(not valid)
+				levels.clear();
+			return valid;
+		}//readCache
+
+		// A cadeia mapeada do pacote: mesmo formato, os níveis são copiados
+		static bool readPacked(const unsigned char *data, size_t size, int first, const MipInfo &x, vector<vector<unsigned char> > &levels){
+			int header[4];
+			if(size < 4 + sizeof(header) or memcmp(data, "MIP1", 4) != 0)
+				return false;
+			memcpy(header, data + 4, sizeof(header));
+			if(header[0] != x.width or header[1] != x.height or header[2] != x.components or header[3] != x.levels)
+				return false;
+
+			size_t offset = 4 + sizeof(header);
+			for(int l = 0; l < x.levels; l++){
+				size_t bytes = levelBytes(x, l);
+				if(bytes > size - offset){
+					levels.clear();
+					return false;
+				}
+				if(l >= first)
+					levels.push_back(vector<unsigned char>(data + offset, data + offset + bytes));
+				offset += bytes;
+			}
+			return true;
+		}//readPacked
+
+		static void writeCache(const string &file, const MipInfo &x, const vector<vector<unsigned char> > &chain){
+			// Grava num temporário e renomeia: uma leitura nunca vê o arquivo pela metade
+			string path = file + ".mips";
+			string temporary = TempFile::name(path);
+			FILE *out = fopen(temporary.c_str(), "wb");
+			if(not out)
+				return;
+
+			int header[4] = {x.width, x.height, x.components, x.levels};
+			bool ok = fwrite("MIP1", 1, 4, out) == 4 and fwrite(header, sizeof(int), 4, out) == 4;
+			for(int l = 0; l < x.levels and ok; l++)
+				ok = fwrite(&chain[l][0], 1, chain[l].size(), out) == chain[l].size();
+			fclose(out);
+
+			if(ok)
+				ok = TempFile::commit(temporary, path);
+			if(not ok)
+				remove(temporary.c_str());
+		}//writeCache
+};
+
+#endif
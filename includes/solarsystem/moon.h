@@ -39,7 +39,7 @@ class Moon: public Planet {
 			// rotaciona 
 			matrix = glm::rotate(matrix, glm::radians(360.0f)* x, glm::vec3(0.0f, 1.0f, 0.0f));
 			// se distancia do planeta
-			matrix = glm::translate(matrix, (distance * UA) * glm::vec3(1.0f, 0.0f, 0.0f));
+			matrix = glm::translate(matrix, (getDistance() * UA) * glm::vec3(1.0f, 0.0f, 0.0f));
 			// retorna olhando pra frente
 			matrix = glm::rotate(matrix, glm::radians(360.0f) * x, glm::vec3(0.0f, -1.0f, 0.0f));
 
@@ -52,7 +52,7 @@ class Moon: public Planet {
 			// faz o movimento de rotação
 			matrix = glm::rotate(matrix, glm::radians(360.0f) * x, glm::vec3(0.0f, 1.0f, 0.0f));
 			// faz o Scale correto da lua
-			matrix = glm::scale(matrix, (Scale * size) * glm::vec3(1.0f, 1.0f, 1.0f));
+			matrix = glm::scale(matrix, getSize() * glm::vec3(1.0f, 1.0f, 1.0f));
 			
 			// atualiza posição da lua
 			position.x = matrix[3][0];
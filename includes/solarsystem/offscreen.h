@@ -0,0 +1,187 @@
+#ifndef OFFSCREEN_H
+#define OFFSCREEN_H
+
+#include <glad/glad.h>
+
+#ifdef SOLAR_OFFSCREEN
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Contexto OpenGL sem janela. Usa EGL sem superfície (EGL_MESA_platform_surfaceless),
+// que funciona sem tela e sem GPU com o llvmpipe do Mesa, e desenha num
+// framebuffer próprio no lugar da janela.
+class Offscreen {
+	protected:
+		int width, height;
+		unsigned int fbo, color, depth;
+#ifdef SOLAR_OFFSCREEN
+		EGLDisplay display;
+		EGLContext context;
+#endif
+
+	public:
+		Offscreen(){
+			width = height = 0;
+			fbo = color = depth = 0;
+#ifdef SOLAR_OFFSCREEN
+			display = EGL_NO_DISPLAY;
+			context = EGL_NO_CONTEXT;
+#endif
+		}//Offscreen
+
+		/** Cria o contexto 3.3 core e o framebuffer
+			* @param w - Largura
+			* @param h - Altura
+			*/
+		bool create(int w, int h){
+			width = w;
+			height = h;
+
+#ifdef SOLAR_OFFSCREEN
+			// Plataforma sem superfície, se existir; senão o display padrão
+			PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+			if(getPlatformDisplay)
+				display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+			if(display == EGL_NO_DISPLAY)
+				display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+			EGLint major, minor;
+			if(not eglInitialize(display, &major, &minor)){
+				cout << "ERROR::OFFSCREEN:: eglInitialize falhou (0x" << hex << eglGetError() << dec << ")" << endl;
+				return false;
+			}
+			eglBindAPI(EGL_OPENGL_API);
+
+			// Sem superfície não há configs: usa EGL_KHR_no_config_context
+			EGLConfig config = (EGLConfig) 0;
+			EGLint count = 0;
+			const EGLint configAttribs[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+			eglChooseConfig(display, configAttribs, &config, 1, &count);
+
+			const EGLint contextAttribs[] = {
+				EGL_CONTEXT_MAJOR_VERSION, 3,
+				EGL_CONTEXT_MINOR_VERSION, 3,
+				EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+				EGL_NONE
+			};
+			context = eglCreateContext(display, count ? config : (EGLConfig) 0, EGL_NO_CONTEXT, contextAttribs);
+			if(context == EGL_NO_CONTEXT or not eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)){
+				cout << "ERROR::OFFSCREEN:: Contexto OpenGL 3.3 sem janela indisponível (0x" << hex << eglGetError() << dec << ")" << endl;
+				return false;
+			}
+
+			if(not gladLoadGLLoader((GLADloadproc) eglGetProcAddress)){
+				cout << "Failed to initialize GLAD" << endl;
+				return false;
+			}
+
+			cout << "Offscreen: EGL " << major << "." << minor << ", " << glGetString(GL_RENDERER)
+				 << ", " << glGetString(GL_VERSION) << endl;
+
+			// Framebuffer que faz o papel da janela
+			glGenFramebuffers(1, &fbo);
+			glGenRenderbuffers(1, &color);
+			glGenRenderbuffers(1, &depth);
+			glBindRenderbuffer(GL_RENDERBUFFER, color);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+			glBindRenderbuffer(GL_RENDERBUFFER, depth);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+			glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+			if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+				cout << "ERROR::OFFSCREEN:: Framebuffer incompleto" << endl;
+				return false;
+			}
+			glViewport(0, 0, width, height);
+			return true;
+#else
+			cout << "ERROR::OFFSCREEN:: Compilado sem EGL (SOLAR_OFFSCREEN)" << endl;
+			return false;
+#endif
+		}//create
+
+		// Loader do glad para quem precisa carregar extensões
+		static GLADloadproc loader(){
+#ifdef SOLAR_OFFSCREEN
+			return (GLADloadproc) eglGetProcAddress;
+#else
+			return NULL;
+#endif
+		}//loader
+
+		// Framebuffer que substitui a janela
+		unsigned int target(){
+			return fbo;
+		}//target
+
+		int getWidth(){
+			return width;
+		}//getWidth
+
+		int getHeight(){
+			return height;
+		}//getHeight
+
+		// Lê a imagem do framebuffer (RGB, linhas de cima para baixo)
+		void read(vector<unsigned char> &pixels){
+			pixels.resize(width * height * 3);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+			glPixelStorei(GL_PACK_ALIGNMENT, 1);
+			glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+			flip(pixels, width, height);
+		}//read
+
+		// Grava um frame como PPM binário
+		bool save(const string &path){
+			vector<unsigned char> pixels;
+			read(pixels);
+			return writePPM(path, &pixels[0], width, height);
+		}//save
+
+		static bool writePPM(const string &path, const unsigned char *rgb, int w, int h){
+			FILE *file = fopen(path.c_str(), "wb");
+			if(not file){
+				cout << "ERROR::OFFSCREEN:: Não foi possível gravar " << path << endl;
+				return false;
+			}
+			fprintf(file, "P6\n%d %d\n255\n", w, h);
+			fwrite(rgb, 1, w * h * 3, file);
+			fclose(file);
+			return true;
+		}//writePPM
+
+		// O OpenGL lê de baixo para cima
+		static void flip(vector<unsigned char> &pixels, int w, int h){
+			int row = w * 3;
+			vector<unsigned char> line(row);
+			for(int y = 0; y < h / 2; y++){
+				unsigned char *top = &pixels[y * row];
+				unsigned char *bottom = &pixels[(h - 1 - y) * row];
+				copy(top, top + row, line.begin());
+				copy(bottom, bottom + row, top);
+				copy(line.begin(), line.end(), bottom);
+			}
+		}//flip
+
+		void destroy(){
+#ifdef SOLAR_OFFSCREEN
+			if(display != EGL_NO_DISPLAY){
+				eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+				if(context != EGL_NO_CONTEXT)
+					eglDestroyContext(display, context);
+				eglTerminate(display);
+			}
+#endif
+		}//destroy
+};
+
+#endif
@@ -0,0 +1,313 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include "lz4block.h"
+#include "tempfile.h"
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Pacote de assets: um arquivo só com todos os modelos, texturas e shaders.
+//   cabeçalho  "SPK1", entradas, posições da tabela, alinhamento (uint32),
+//              início da tabela, início dos nomes (uint64)
+//   dados      cada entrada começa num múltiplo do alinhamento (padrão 4096,
+//              uma página: a entrada mapeada não divide páginas com outra)
+//   tabela     hash aberto com sondagem linear pelo hash do caminho
+//              (FNV-1a de 64 bits; 0 marca posição vazia)
+//   nomes      os caminhos, para conferir colisões e listar o pacote
+// O arquivo é mapeado inteiro na memória; uma entrada sem compressão é lida
+// direto do mapeamento, sem cópia, e uma comprimida (LZ4) é descomprimida.
+#define PACK_LZ4 1
+
+struct PackHeader {
+	char magic[4];
+	uint32_t count;      // entradas
+	uint32_t slots;      // posições da tabela (potência de 2)
+	uint32_t alignment;  // dos dados de cada entrada
+	uint64_t table;      // início da tabela
+	uint64_t names;      // início dos nomes
+};
+
+struct PackEntry {
+	uint64_t hash;     // 0 = posição vazia
+	uint64_t offset;   // início dos dados no arquivo
+	uint64_t size;     // bytes guardados
+	uint64_t rawSize;  // bytes do arquivo original
+	uint32_t name;     // início do caminho, a partir dos nomes
+	uint32_t flags;    // PACK_LZ4
+};
+
+class Pack {
+	protected:
+		const unsigned char *base;
+		size_t length;
+		vector<unsigned char> copy;  // sem mmap (Windows): o arquivo lido inteiro
+		const PackHeader *header;
+		const PackEntry *table;
+
+	public:
+		Pack(){
+			base = NULL;
+			length = 0;
+			header = NULL;
+			table = NULL;
+		}//Pack
+
+		~Pack(){
+			close();
+		}//~Pack
+
+		// Hash de um caminho, nunca 0
+		static uint64_t hash(const string &path){
+			uint64_t h = 14695981039346656037ull;
+			for(unsigned int i = 0; i < path.size(); i++){
+				h ^= (unsigned char) path[i];
+				h *= 1099511628211ull;
+			}
+			return h ? h : 1;
+		}//hash
+
+		/** Mapeia o pacote e confere o cabeçalho e a tabela
+			* @param file - Caminho do pacote
+			* @return false se não abriu ou não é um pacote válido
+			*/
+		bool open(const string &file){
+			close();
+#ifdef _WIN32
+			FILE *in = fopen(file.c_str(), "rb");
+			if(not in)
+				return false;
+			fseek(in, 0, SEEK_END);
+			long size = ftell(in);
+			fseek(in, 0, SEEK_SET);
+			copy.resize(max(size, 0l));
+			bool ok = size > 0 and fread(&copy[0], 1, size, in) == (size_t) size;
+			fclose(in);
+			if(not ok)
+				return false;
+			base = &copy[0];
+			length = size;
+#else
+			int fd = ::open(file.c_str(), O_RDONLY);
+			if(fd < 0)
+				return false;
+			struct stat st;
+			void *mapped = MAP_FAILED;
+			if(fstat(fd, &st) == 0 and st.st_size > 0)
+				mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd);
+			if(mapped == MAP_FAILED)
+				return false;
+			base = (const unsigned char *) mapped;
+			length = st.st_size;
+#endif
+
+			header = (const PackHeader *) base;
+			bool valid = length >= sizeof(PackHeader) and memcmp(header->magic, "SPK1", 4) == 0
+						 and header->slots and (header->slots & (header->slots - 1)) == 0
+						 and header->table <= length and header->slots <= (length - header->table) / sizeof(PackEntry)
+						 and header->names <= length;
+			if(valid){
+				table = (const PackEntry *) (base + header->table);
+				for(unsigned int i = 0; i < header->slots and valid; i++)
+					valid = table[i].hash == 0 or (table[i].offset <= length and table[i].size <= length - table[i].offset
+												   and table[i].name < length - header->names);
+			}
+			if(not valid)
+				close();
+			return valid;
+		}//open
+
+		void close(){
+#ifndef _WIN32
+			if(base)
+				munmap((void *) base, length);
+#endif
+			copy = vector<unsigned char>();
+			base = NULL;
+			length = 0;
+			header = NULL;
+			table = NULL;
+		}//close
+
+		bool isOpen() const{
+			return base != NULL;
+		}//isOpen
+
+		unsigned int count() const{
+			return header ? header->count : 0;
+		}//count
+
+		// Entrada de um caminho (já normalizado), ou NULL
+		const PackEntry *find(const string &path) const{
+			if(not table)
+				return NULL;
+			uint64_t h = hash(path);
+			for(uint32_t i = h & (header->slots - 1), probes = 0; probes < header->slots; i = (i + 1) & (header->slots - 1), probes++){
+				if(table[i].hash == 0)
+					return NULL;
+				if(table[i].hash == h and name(table[i]) == path)
+					return &table[i];
+			}
+			return NULL;
+		}//find
+
+		string name(const PackEntry &entry) const{
+			const char *first = (const char *) base + header->names + entry.name;
+			return string(first, strnlen(first, length - header->names - entry.name));
+		}//name
+
+		// Bytes guardados da entrada, dentro do mapeamento
+		const unsigned char *data(const PackEntry &entry) const{
+			return base + entry.offset;
+		}//data
+
+		/** Conteúdo original da entrada
+			* @param out - Substituído; descomprimido se a entrada tem PACK_LZ4
+			* @return false se a entrada comprimida está corrompida
+			*/
+		bool read(const PackEntry &entry, vector<unsigned char> &out) const{
+			if(not (entry.flags & PACK_LZ4)){
+				out.assign(data(entry), data(entry) + entry.size);
+				return true;
+			}
+			out.resize(entry.rawSize);
+			if(LZ4Block::decompress(data(entry), entry.size, out.empty() ? NULL : &out[0], entry.rawSize))
+				return true;
+			out.clear();
+			return false;
+		}//read
+
+		// Todas as entradas, na ordem da tabela
+		vector<const PackEntry*> entries() const{
+			vector<const PackEntry*> x;
+			for(uint32_t i = 0; table and i < header->slots; i++)
+				if(table[i].hash)
+					x.push_back(&table[i]);
+			return x;
+		}//entries
+};
+
+// Monta um pacote: add() guarda cada arquivo (comprimido ou não) e write()
+// grava dados, tabela e nomes
+class PackWriter {
+	protected:
+		struct Item {
+			string name;
+			vector<unsigned char> bytes;
+			uint64_t rawSize;
+			uint32_t flags;
+		};
+		vector<Item> items;
+
+	public:
+		uint32_t alignment;
+
+		PackWriter(){
+			alignment = 4096;
+		}//PackWriter
+
+		/** Acrescenta um arquivo
+			* @param name - Caminho normalizado, a chave da busca
+			* @param bytes - Conteúdo
+			* @param compress - Tenta LZ4; só fica comprimido se economizar ao menos 1/8
+			* @return true se a entrada ficou comprimida
+			*/
+		bool add(const string &name, const vector<unsigned char> &bytes, bool compress){
+			Item item;
+			item.name = name;
+			item.rawSize = bytes.size();
+			item.flags = 0;
+			if(compress and not bytes.empty()){
+				LZ4Block::compress(&bytes[0], bytes.size(), item.bytes);
+				if(item.bytes.size() <= bytes.size() - bytes.size() / 8)
+					item.flags = PACK_LZ4;
+			}
+			if(not item.flags)
+				item.bytes = bytes;
+			items.push_back(item);
+			return item.flags != 0;
+		}//add
+
+		// Bytes guardados até agora
+		uint64_t stored() const{
+			uint64_t x = 0;
+			for(unsigned int i = 0; i < items.size(); i++)
+				x += items[i].bytes.size();
+			return x;
+		}//stored
+
+		// Grava num temporário e renomeia: quem está lendo o pacote antigo não vê um pela metade
+		bool write(const string &file){
+			uint32_t slots = 1;
+			while(slots < 2 * items.size())
+				slots <<= 1;
+			vector<PackEntry> table(slots);
+			memset(&table[0], 0, slots * sizeof(PackEntry));
+
+			string temporary = TempFile::name(file);
+			FILE *out = fopen(temporary.c_str(), "wb");
+			if(not out)
+				return false;
+
+			PackHeader header;
+			memset(&header, 0, sizeof(header));
+			bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+
+			uint64_t offset = sizeof(header);
+			string names;
+			for(unsigned int i = 0; i < items.size() and ok; i++){
+				uint64_t start = (offset + alignment - 1) / alignment * alignment;
+				vector<char> padding(start - offset, 0);
+				ok = padding.empty() or fwrite(&padding[0], 1, padding.size(), out) == padding.size();
+				ok = ok and (items[i].bytes.empty() or fwrite(&items[i].bytes[0], 1, items[i].bytes.size(), out) == items[i].bytes.size());
+				offset = start + items[i].bytes.size();
+
+				uint64_t h = Pack::hash(items[i].name);
+				uint32_t slot = h & (slots - 1);
+				while(table[slot].hash)
+					slot = (slot + 1) & (slots - 1);
+				table[slot].hash = h;
+				table[slot].offset = start;
+				table[slot].size = items[i].bytes.size();
+				table[slot].rawSize = items[i].rawSize;
+				table[slot].name = names.size();
+				table[slot].flags = items[i].flags;
+				names += items[i].name;
+				names += '\0';
+			}
+
+			memcpy(header.magic, "SPK1", 4);
+			header.count = items.size();
+			header.slots = slots;
+			header.alignment = alignment;
+			header.table = (offset + 7) / 8 * 8;
+			header.names = header.table + slots * sizeof(PackEntry);
+			vector<char> padding(header.table - offset, 0);
+			ok = ok and (padding.empty() or fwrite(&padding[0], 1, padding.size(), out) == padding.size());
+			ok = ok and fwrite(&table[0], sizeof(PackEntry), slots, out) == slots;
+			ok = ok and (names.empty() or fwrite(names.data(), 1, names.size(), out) == names.size());
+			ok = ok and fseek(out, 0, SEEK_SET) == 0 and fwrite(&header, sizeof(header), 1, out) == 1;
+			ok = fclose(out) == 0 and ok;
+
+			if(ok)
+				ok = TempFile::commit(temporary, file);
+			if(not ok)
+				remove(temporary.c_str());
+			return ok;
+		}//write
+};
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef PACKIO_H
+#define PACKIO_H
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+#include "vfs.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Arquivo lido inteiro pelo Vfs, como stream do Assimp; um arquivo guardado
+// sem compressão no pacote é lido direto do mapeamento
+class PackIOStream : public Assimp::IOStream {
+	protected:
+		vector<unsigned char> buffer;
+		const unsigned char *data;
+		size_t size, position;
+
+	public:
+		PackIOStream(const string &path): data(NULL), size(0), position(0){
+			data = Vfs::map(path, size);
+			if(not data and Vfs::read(path, buffer)){
+				size = buffer.size();
+				data = buffer.empty() ? NULL : &buffer[0];
+			}
+		}//PackIOStream
+
+		size_t Read(void *pvBuffer, size_t pSize, size_t pCount){
+			if(pSize == 0)
+				return 0;
+			size_t count = min(pCount, (size - position) / pSize);
+			if(count)
+				memcpy(pvBuffer, data + position, count * pSize);
+			position += count * pSize;
+			return count;
+		}//Read
+
+		size_t Write(const void *, size_t, size_t){
+			return 0;
+		}//Write
+
+		aiReturn Seek(size_t pOffset, aiOrigin pOrigin){
+			size_t target = pOrigin == aiOrigin_SET ? pOffset : pOrigin == aiOrigin_CUR ? position + pOffset : size + pOffset;
+			if(target > size)
+				return aiReturn_FAILURE;
+			position = target;
+			return aiReturn_SUCCESS;
+		}//Seek
+
+		size_t Tell() const{
+			return position;
+		}//Tell
+
+		size_t FileSize() const{
+			return size;
+		}//FileSize
+
+		void Flush(){
+		}//Flush
+};
+
+// Sistema de arquivos do Assimp sobre o Vfs: o modelo e os arquivos que ele
+// cita (.mtl) vêm do pacote ou do disco. Só leitura.
+class PackIOSystem : public Assimp::IOSystem {
+	public:
+		// Para Model::ioSystem
+		static Assimp::IOSystem *create(){
+			return new PackIOSystem();
+		}//create
+
+		bool Exists(const char *pFile) const{
+			return Vfs::exists(pFile);
+		}//Exists
+
+		char getOsSeparator() const{
+			return '/';
+		}//getOsSeparator
+
+		Assimp::IOStream *Open(const char *pFile, const char *pMode = "rb"){
+			if(strchr(pMode, 'w') or strchr(pMode, 'a') or not Vfs::exists(pFile))
+				return NULL;
+			return new PackIOStream(pFile);
+		}//Open
+
+		void Close(Assimp::IOStream *pFile){
+			delete pFile;
+		}//Close
+};
+
+#endif
@@ -17,6 +17,7 @@ class Planet: public Sun {
 		float t_orbit;
 		float t_rotation;
 		float distance;
+		float realDistance; // distância real (UA)
 		float begin;
 		glm::vec3 position;
 		unsigned int qtMoons;
@@ -30,6 +31,7 @@ class Planet: public Sun {
 		static int worldSpeed; // Velocidade do mundo
 		static bool pause; // O mundo está pausado
 		static float time; // tempo para quando estiver pausado
+		static float KM; // quilômetros em uma unidade astronomica
 
 		/** Construtor de um Planeta
 			* @param name - Nome do Planeta
@@ -42,7 +44,8 @@ class Planet: public Sun {
 			t_orbit = orbit;
 			t_rotation = rotation;
 			this->distance = distance;
-			begin = glfwGetTime();
+			realDistance = distance;
+			begin = time; // relógio da simulação, não depende da janela
 			position = glm::vec3(0.0f, 0.0f, 0.0f);
 			qtMoons = 0;
 		}
@@ -64,7 +67,7 @@ class Planet: public Sun {
 			// rotaciona
 			matrix = glm::rotate(matrix, glm::radians(360.0f)* x, glm::vec3(0.0f, 1.0f, 0.0f));
 			// se distancia do sol
-			matrix = glm::translate(matrix, (distance * UA) * glm::vec3(1.0f, 0.0f, 0.0f));
+			matrix = glm::translate(matrix, (getDistance() * UA) * glm::vec3(1.0f, 0.0f, 0.0f));
 			// retorna olhando pra frente
 			matrix = glm::rotate(matrix, glm::radians(360.0f) * x, glm::vec3(0.0f, -1.0f, 0.0f));
 
@@ -77,7 +80,7 @@ class Planet: public Sun {
 			// faz o movimento de rotação
 			matrix = glm::rotate(matrix, glm::radians(360.0f) * x, glm::vec3(0.0f, 1.0f, 0.0f));
 			// faz o Scale correto do planeta
-			matrix = glm::scale(matrix, (Scale * size) * glm::vec3(1.0f, 1.0f, 1.0f));
+			matrix = glm::scale(matrix, getSize() * glm::vec3(1.0f, 1.0f, 1.0f));
 		
 			// atualiza posição do planeta (Para lua usar)
 			position.x = matrix[3][0];
@@ -95,6 +98,20 @@ class Planet: public Sun {
 			return Scale;
 		}
 
+		/** Valores reais, usados na escala real
+			* @param diameter - Diâmetro (km)
+			* @param distance - Distância da origem (UA)
+			*/
+		void setReal(float diameter, float distance){
+			Real = diameter;
+			realDistance = distance;
+		}
+
+		// Distância da origem na escala atual
+		float getDistance(){
+			return trueScale ? realDistance : distance;
+		}
+
 		glm::vec3 getPosition(){
 			return position;
 		}
@@ -108,12 +125,4 @@ class Planet: public Sun {
 		}
 };
 
-float Planet::UA    	 = 1;
-float Planet::days  	 = 5;
-float Planet::years 	 = 10;
-bool  Planet::plane 	 = false;
-int   Planet::worldSpeed = 5;
-bool  Planet::pause 	 = false;
-float Planet::time 		 = glfwGetTime();
-
 #endif
\ No newline at end of file
@@ -0,0 +1,349 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader_m.h>
+
+#include "glstate.h"
+#include "hud.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Colunas do HUD ocupadas pelo nome e tempos de cada passo e pela barra
+#define PROFILER_LABEL 35
+#define PROFILER_BAR   40
+
+// Estatísticas de uma janela de amostras (ms)
+struct Stats {
+	float min;
+	float avg;
+	float p50;
+	float p95;
+	float p99;
+	float max;
+	float last;
+};
+
+// Um passo do frame (estrelas, sol, planetas, ...)
+struct Pass {
+	string name;
+	unsigned int queries[2]; // GL_TIME_ELAPSED, um por frame par/ímpar
+	bool pending[2];         // a query foi emitida e ainda não foi lida
+	double cpuStart;
+	float cpu, gpu;          // última amostra (ms)
+	deque<float> cpuSamples;
+	deque<float> gpuSamples;
+};
+
+// Perfil do frame por passo: tempo de GPU com GL_TIME_ELAPSED (duas queries
+// por passo, alternadas entre frames para nunca esperar o resultado) e tempo
+// de CPU no mesmo intervalo. As últimas amostras ficam numa janela móvel,
+// mostrada na tela (uma linha do HUD por passo, com nome, tempos e barra)
+// e gravada em CSV/JSON.
+class Profiler {
+	protected:
+		vector<Pass> passes;
+		int current;             // passo aberto (-1 nenhum)
+		unsigned long frames;    // frames perfilados
+		unsigned int window;     // tamanho da janela de amostras
+		unsigned int dropped;    // resultados que não chegaram a tempo
+		unsigned int vao;        // overlay
+
+	public:
+		bool enabled;  // mede os passos
+		bool visible;  // mostra as barras na tela
+		int row;       // linha do HUD do primeiro passo
+		double gpuBusy; // soma do tempo de GPU de todos os passos já lidos (ms)
+
+		Profiler(unsigned int samples = 600){
+			current = -1;
+			frames = 0;
+			window = samples;
+			dropped = 0;
+			vao = 0;
+			enabled = true;
+			visible = false;
+			row = 7;
+			gpuBusy = 0.0;
+		}//Profiler
+
+		// Começa um frame
+		void frame(){
+			frames++;
+		}//frame
+
+		// Abre um passo, não podem ser aninhados (limitação do GL_TIME_ELAPSED)
+		void begin(const string &name){
+			if(not enabled)
+				return;
+
+			current = find(name);
+			Pass &pass = passes[current];
+			int set = frames % 2;
+
+			// Lê o resultado de dois frames atrás antes de reusar a query
+			collect(pass, set);
+
+			glBeginQuery(GL_TIME_ELAPSED, pass.queries[set]);
+			pass.cpuStart = now();
+		}//begin
+
+		// Fecha o passo aberto
+		void end(){
+			if(not enabled or current < 0)
+				return;
+
+			Pass &pass = passes[current];
+			glEndQuery(GL_TIME_ELAPSED);
+			pass.pending[frames % 2] = true;
+
+			pass.cpu = (float) (now() - pass.cpuStart);
+			push(pass.cpuSamples, pass.cpu);
+			current = -1;
+		}//end
+
+		// Estatísticas de um passo
+		Stats cpuStats(const string &name){
+			return stats(passes[find(name)].cpuSamples);
+		}//cpuStats
+
+		Stats gpuStats(const string &name){
+			return stats(passes[find(name)].gpuSamples);
+		}//gpuStats
+
+		vector<string> names(){
+			vector<string> x;
+			for(unsigned int i = 0; i < passes.size(); i++)
+				x.push_back(passes[i].name);
+			return x;
+		}//names
+
+		unsigned int getDropped(){
+			return dropped;
+		}//getDropped
+
+		/** Descarta as amostras (ex: depois do aquecimento de um benchmark)
+			* @param samples - Novo tamanho da janela
+			*/
+		void reset(unsigned int samples){
+			window = samples;
+			dropped = 0;
+			for(unsigned int i = 0; i < passes.size(); i++){
+				passes[i].cpuSamples.clear();
+				passes[i].gpuSamples.clear();
+			}
+		}//reset
+
+		// Estatísticas de uma janela de amostras
+		static Stats stats(const deque<float> &samples){
+			Stats x = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+			if(samples.empty())
+				return x;
+
+			vector<float> sorted(samples.begin(), samples.end());
+			sort(sorted.begin(), sorted.end());
+
+			double sum = 0.0;
+			for(unsigned int i = 0; i < sorted.size(); i++)
+				sum += sorted[i];
+
+			x.min = sorted.front();
+			x.avg = sum / sorted.size();
+			x.p50 = percentile(sorted, 0.50f);
+			x.p95 = percentile(sorted, 0.95f);
+			x.p99 = percentile(sorted, 0.99f);
+			x.max = sorted.back();
+			x.last = samples.back();
+			return x;
+		}//stats
+
+		// Grava a janela de amostras em CSV: frame relativo, passo, cpu, gpu
+		void writeCSV(const string &path){
+			ofstream file(path.c_str());
+			file << "sample,pass,cpu_ms,gpu_ms" << endl;
+			for(unsigned int i = 0; i < passes.size(); i++){
+				Pass &pass = passes[i];
+				unsigned int n = max(pass.cpuSamples.size(), pass.gpuSamples.size());
+				for(unsigned int j = 0; j < n; j++){
+					file << j << "," << pass.name << ",";
+					if(j < pass.cpuSamples.size())
+						file << pass.cpuSamples[j];
+					file << ",";
+					if(j < pass.gpuSamples.size())
+						file << pass.gpuSamples[j];
+					file << endl;
+				}
+			}
+		}//writeCSV
+
+		// Grava min/avg/p99 de cada passo em JSON
+		void writeJSON(const string &path){
+			ofstream file(path.c_str());
+			file << "{" << endl;
+			file << "  \"frames\": " << frames << "," << endl;
+			file << "  \"dropped\": " << dropped << "," << endl;
+			file << "  \"passes\": {" << endl;
+			for(unsigned int i = 0; i < passes.size(); i++){
+				Stats cpu = stats(passes[i].cpuSamples);
+				Stats gpu = stats(passes[i].gpuSamples);
+				file << "    \"" << passes[i].name << "\": {"
+					 << "\"cpu\": {\"min\": " << cpu.min << ", \"avg\": " << cpu.avg << ", \"p99\": " << cpu.p99 << "}, "
+					 << "\"gpu\": {\"min\": " << gpu.min << ", \"avg\": " << gpu.avg << ", \"p99\": " << gpu.p99 << "}}";
+				file << (i + 1 < passes.size() ? "," : "") << endl;
+			}
+			file << "  }" << endl;
+			file << "}" << endl;
+		}//writeJSON
+
+		/** Escreve no HUD o nome e as médias de GPU e CPU de cada passo, na cor
+			* da sua barra (entre o begin e o end do HUD)
+			* @param width - Largura da tela
+			* @param height - Altura da tela
+			*/
+		void labels(Hud &hud, int width, int height){
+			if(not visible or passes.empty())
+				return;
+
+			char line[64];
+			snprintf(line, sizeof(line), "%-18s %7s %7s", "passo", "GPU ms", "CPU ms");
+			hud.text(0, row - 1, line, glm::vec4(0.7f, 0.7f, 0.7f, 0.9f), width, height);
+			for(unsigned int i = 0; i < passes.size(); i++){
+				// limitado à largura da coluna, para não invadir a barra
+				snprintf(line, sizeof(line), "%-18.18s %7.2f %7.2f", passes[i].name.c_str(), min(stats(passes[i].gpuSamples).avg, 9999.99f),
+						 min(stats(passes[i].cpuSamples).avg, 9999.99f));
+				hud.text(0, row + i, line, palette(i), width, height);
+			}
+		}//labels
+
+		/** Desenha uma barra por passo (GPU em cima, CPU embaixo) ao lado da sua linha no HUD
+			* @param shader - Shader do overlay
+			* @param hud - Posição das linhas
+			* @param width - Largura da tela
+			* @param height - Altura da tela
+			* @param budget - Tempo que ocupa a largura inteira da barra (ms)
+			*/
+		void draw(Shader *shader, Hud &hud, int width, int height, float budget = 16.6f){
+			if(not visible or passes.empty())
+				return;
+
+			if(vao == 0)
+				glGenVertexArrays(1, &vao);
+
+			glDisable(GL_DEPTH_TEST);
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			shader->use();
+			GLState::bindVertexArray(vao);
+
+			for(unsigned int i = 0; i < passes.size(); i++){
+				Stats gpu = stats(passes[i].gpuSamples);
+				Stats cpu = stats(passes[i].cpuSamples);
+				glm::vec4 color = palette(i);
+				glm::vec4 area = hud.box(PROFILER_LABEL, row + i, PROFILER_BAR, width, height);
+
+				// fundo
+				bar(shader, area, width, height, 0.0f, 1.0f, 0.0f, 1.0f, glm::vec4(0.2f, 0.2f, 0.2f, 0.5f));
+				// média da GPU e da CPU
+				bar(shader, area, width, height, 0.0f, gpu.avg / budget, 0.0f, 0.5f, color);
+				bar(shader, area, width, height, 0.0f, cpu.avg / budget, 0.5f, 1.0f, color * 0.6f);
+				// p99 da GPU, como um traço
+				bar(shader, area, width, height, gpu.p99 / budget, 0.003f, 0.0f, 1.0f, glm::vec4(1.0f));
+			}
+
+			glDisable(GL_BLEND);
+			glEnable(GL_DEPTH_TEST);
+		}//draw
+
+	private:
+		int find(const string &name){
+			for(unsigned int i = 0; i < passes.size(); i++)
+				if(passes[i].name == name)
+					return i;
+
+			Pass pass;
+			pass.name = name;
+			glGenQueries(2, pass.queries);
+			pass.pending[0] = pass.pending[1] = false;
+			pass.cpuStart = 0;
+			pass.cpu = pass.gpu = 0;
+			passes.push_back(pass);
+			return passes.size() - 1;
+		}//find
+
+		// Lê a query se o resultado já chegou, sem travar a CPU
+		void collect(Pass &pass, int set){
+			if(not pass.pending[set])
+				return;
+
+			GLint available = 0;
+			glGetQueryObjectiv(pass.queries[set], GL_QUERY_RESULT_AVAILABLE, &available);
+			if(available){
+				GLuint64 elapsed = 0;
+				glGetQueryObjectui64v(pass.queries[set], GL_QUERY_RESULT, &elapsed);
+				pass.gpu = elapsed / 1000000.0f;
+				gpuBusy += elapsed / 1000000.0;
+				push(pass.gpuSamples, pass.gpu);
+			}
+			else
+				dropped++;
+
+			pass.pending[set] = false;
+		}//collect
+
+		void push(deque<float> &samples, float value){
+			samples.push_back(value);
+			if(samples.size() > window)
+				samples.pop_front();
+		}//push
+
+		// Amostra da posição p (0..1) de um vetor ordenado
+		static float percentile(const vector<float> &sorted, float p){
+			return sorted[(unsigned int) ((sorted.size() - 1) * p)];
+		}//percentile
+
+		// Milissegundos num relógio monotônico
+		double now(){
+			return chrono::duration<double, milli>(chrono::steady_clock::now().time_since_epoch()).count();
+		}//now
+
+		/** Retângulo dentro da área da barra (em pixels, y para baixo)
+			* @param start - Início, em fração da largura da área
+			* @param size - Largura, em fração da largura da área
+			* @param top - Cima, em fração da altura da área
+			* @param bottom - Baixo, em fração da altura da área
+			*/
+		void bar(Shader *shader, glm::vec4 area, int width, int height, float start, float size, float top, float bottom, glm::vec4 color){
+			start = min(start, 1.0f);
+			size = min(size, 1.0f);
+			float left = area.x + start * (area.z - area.x);
+			float right = left + size * (area.z - area.x);
+			float up = area.y + top * (area.w - area.y);
+			float down = area.y + bottom * (area.w - area.y);
+			shader->setVec4("rect", 2.0f * left / width - 1.0f, 1.0f - 2.0f * down / height, 2.0f * right / width - 1.0f, 1.0f - 2.0f * up / height);
+			shader->setVec4("color", color);
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		}//bar
+
+		glm::vec4 palette(unsigned int i){
+			const glm::vec4 colors[6] = {
+				glm::vec4(0.40f, 0.60f, 1.00f, 0.9f), glm::vec4(1.00f, 0.80f, 0.20f, 0.9f),
+				glm::vec4(0.30f, 0.90f, 0.40f, 0.9f), glm::vec4(0.80f, 0.80f, 0.80f, 0.9f),
+				glm::vec4(1.00f, 0.40f, 0.30f, 0.9f), glm::vec4(0.80f, 0.40f, 1.00f, 0.9f)
+			};
+			return colors[i % 6];
+		}//palette
+};
+
+#endif
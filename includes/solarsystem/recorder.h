@@ -0,0 +1,496 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <glad/glad.h>
+
+#include "glcaps.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+using namespace std;
+
+// Formatos de saída da gravação
+enum RecordFormat {
+	RECORD_PPM,  // sequência de imagens PPM, uma por frame
+	RECORD_Y4M,  // vídeo YUV 4:2:0 sem compressão num arquivo .y4m
+	RECORD_PIPE  // RGB cru enviado para o ffmpeg pela entrada padrão
+};
+
+// O que fazer quando não há slot livre (a gravação ficou para trás)
+enum RecordPolicy {
+	RECORD_BLOCK, // espera: nenhum frame é perdido (modo sem janela)
+	RECORD_DROP   // pula o frame: o frame rate interativo não cai
+};
+
+// Gravador assíncrono de frames. A leitura vai para um anel de pixel buffers
+// (GL_PIXEL_PACK_BUFFER) protegidos por fences, então o glReadPixels não
+// espera a GPU. Quando o fence de um slot sinaliza, o slot vai para a fila
+// de um grupo de threads, que converte e grava o frame sem o contexto GL.
+// Com glBufferStorage os buffers ficam mapeados o tempo todo e as threads
+// leem direto deles; sem ele o frame é copiado na thread principal.
+class Recorder {
+	protected:
+		enum SlotState { SLOT_FREE, SLOT_READING, SLOT_QUEUED };
+
+		struct Slot {
+			unsigned int PBO;
+			GLsync fence;
+			SlotState state;
+			unsigned long index;   // número do frame gravado
+			unsigned char *pixels; // RGBA de baixo para cima
+			vector<unsigned char> copy; // sem mapeamento persistente
+		};
+
+		RecordFormat format;
+		RecordPolicy policy;
+		string target;
+		int width, height, fps;
+		bool recording;
+
+		vector<Slot> slots;
+		int head;                  // próximo slot a ser lido
+		deque<int> reading;        // slots esperando a GPU, em ordem
+
+		// Fila das threads
+		vector<thread> workers;
+		deque<int> jobs;
+		mutex lock;
+		condition_variable jobReady, slotFreed, turn;
+		bool finishing;
+
+		// Saída em fluxo (y4m e pipe), escrita na ordem dos frames
+		FILE *stream;
+		unsigned long nextWrite;
+
+		unsigned long frames;
+
+	public:
+		static bool persistent; // o driver tem glBufferStorage
+
+		// Contadores da gravação
+		unsigned long written, dropped;
+		unsigned int gpuWaits;    // a GPU ainda não tinha terminado a leitura
+		unsigned int writerWaits; // todas as threads ocupadas, a CPU esperou
+		double waitMs;            // tempo total esperando na thread principal
+		unsigned int maxQueued;   // maior fila das threads
+
+		// Verifica o suporte a mapeamento persistente, depois do glad
+		static void init(GLADloadproc load){
+			persistent = GLCaps::require(GLAD_GL_VERSION_4_4, "GL_ARB_buffer_storage", glad_glBufferStorage, load, "glBufferStorage");
+		}//init
+
+		Recorder(){
+			recording = false;
+			stream = NULL;
+			width = height = 0;
+			fps = 60;
+		}//Recorder
+
+		bool active(){
+			return recording;
+		}//active
+
+		/** Lê a especificação da saída: "ppm:prefixo", "y4m:arquivo" ou "pipe:arquivo"
+			* @param spec - Especificação
+			* @param f - Formato lido
+			* @param path - Prefixo ou arquivo lido
+			*/
+		static bool parse(const string &spec, RecordFormat &f, string &path){
+			size_t colon = spec.find(':');
+			if(colon == string::npos)
+				return false;
+
+			string kind = spec.substr(0, colon);
+			path = spec.substr(colon + 1);
+			if(kind == "ppm")       f = RECORD_PPM;
+			else if(kind == "y4m")  f = RECORD_Y4M;
+			else if(kind == "pipe") f = RECORD_PIPE;
+			else                    return false;
+			return not path.empty();
+		}//parse
+
+		/** Começa a gravação
+			* @param spec - Saída, ver parse()
+			* @param w - Largura do framebuffer
+			* @param h - Altura do framebuffer
+			* @param rate - Frames por segundo do vídeo
+			* @param mode - Esperar ou pular quando a gravação fica para trás
+			* @param count - Slots no anel de pixel buffers
+			* @param threads - Threads de conversão e gravação
+			*/
+		bool start(const string &spec, int w, int h, int rate, RecordPolicy mode, int count = 4, int threads = 2){
+			if(recording)
+				stop();
+
+			if(not parse(spec, format, target)){
+				cout << "ERROR::RECORDER:: Saída inválida: " << spec << " (use ppm:prefixo, y4m:arquivo ou pipe:arquivo)" << endl;
+				return false;
+			}
+
+			// O 4:2:0 precisa de dimensões pares
+			width = format == RECORD_PPM ? w : w & ~1;
+			height = format == RECORD_PPM ? h : h & ~1;
+			fps = rate;
+			policy = mode;
+
+			if(not open())
+				return false;
+
+			allocate(count);
+
+			head = 0;
+			frames = 0;
+			nextWrite = 0;
+			written = dropped = 0;
+			gpuWaits = writerWaits = maxQueued = 0;
+			waitMs = 0.0;
+			finishing = false;
+			for(int i = 0; i < threads; i++)
+				workers.push_back(thread(&Recorder::work, this));
+
+			recording = true;
+			cout << "Gravando " << width << "x" << height << " em " << target << endl;
+			return true;
+		}//start
+
+		// Lê o frame atual do framebuffer (0 = janela) para o próximo slot
+		void capture(unsigned int framebuffer){
+			if(not recording)
+				return;
+
+			// Entrega os slots que a GPU já terminou
+			collect(false);
+
+			Slot &slot = slots[head];
+			if(not acquire(slot)){
+				dropped++;
+				return;
+			}
+
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+			glReadBuffer(framebuffer == 0 ? GL_BACK : GL_COLOR_ATTACHMENT0);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.PBO);
+			glPixelStorei(GL_PACK_ALIGNMENT, 4);
+			glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+			slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			slot.index = frames++;
+			slot.state = SLOT_READING;
+			reading.push_back(head);
+
+			head = (head + 1) % slots.size();
+		}//capture
+
+		// Termina a gravação: espera todos os frames serem gravados
+		void stop(){
+			if(not recording)
+				return;
+
+			collect(true);
+			{
+				lock_guard<mutex> guard(lock);
+				finishing = true;
+			}
+			jobReady.notify_all();
+			for(unsigned int i = 0; i < workers.size(); i++)
+				workers[i].join();
+			workers.clear();
+
+			close();
+			report();
+			release();
+			recording = false;
+		}//stop
+
+		// Resumo da gravação e da contrapressão
+		void report(){
+			cout << "Gravação: " << written << " frames gravados, " << dropped << " pulados; "
+				 << "esperas: " << gpuWaits << " GPU, " << writerWaits << " gravação ("
+				 << waitMs << " ms); maior fila " << maxQueued << " de " << slots.size() << endl;
+		}//report
+
+	protected:
+		// Abre a saída em fluxo
+		bool open(){
+			stream = NULL;
+			if(format == RECORD_Y4M){
+				stream = fopen(target.c_str(), "wb");
+				if(stream)
+					fprintf(stream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps);
+			}
+			else if(format == RECORD_PIPE){
+#ifndef _WIN32
+				// Se o ffmpeg não existir o pipe fecha; o erro aparece no fwrite
+				signal(SIGPIPE, SIG_IGN);
+#endif
+				char command[1024];
+				snprintf(command, sizeof(command),
+						 "ffmpeg -loglevel error -y -f rawvideo -pix_fmt rgb24 -s %dx%d -r %d -i - -pix_fmt yuv420p \"%s\"",
+						 width, height, fps, target.c_str());
+				stream = popen(command, "w");
+			}
+			else
+				return true;
+
+			if(stream == NULL){
+				cout << "ERROR::RECORDER:: Não foi possível abrir " << target << endl;
+				return false;
+			}
+			return true;
+		}//open
+
+		void close(){
+			if(stream == NULL)
+				return;
+			if(format == RECORD_PIPE)
+				pclose(stream);
+			else
+				fclose(stream);
+			stream = NULL;
+		}//close
+
+		// Cria o anel de pixel buffers
+		void allocate(int count){
+			GLsizeiptr size = (GLsizeiptr) width * height * 4;
+			slots.resize(count);
+			reading.clear();
+			jobs.clear();
+
+			for(int i = 0; i < count; i++){
+				Slot &slot = slots[i];
+				slot.fence = 0;
+				slot.state = SLOT_FREE;
+				slot.pixels = NULL;
+				glGenBuffers(1, &slot.PBO);
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.PBO);
+				if(persistent){
+					GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+					glBufferStorage(GL_PIXEL_PACK_BUFFER, size, NULL, flags);
+					slot.pixels = (unsigned char*) glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, flags);
+				}
+				else{
+					glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+					slot.copy.resize(size);
+					slot.pixels = &slot.copy[0];
+				}
+			}
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		}//allocate
+
+		void release(){
+			for(unsigned int i = 0; i < slots.size(); i++){
+				if(persistent){
+					glBindBuffer(GL_PIXEL_PACK_BUFFER, slots[i].PBO);
+					glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+				}
+				glDeleteBuffers(1, &slots[i].PBO);
+			}
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			slots.clear();
+		}//release
+
+		/** Libera um slot ocupado para a próxima leitura
+			* @return false se o frame deve ser pulado (RECORD_DROP)
+			*/
+		bool acquire(Slot &slot){
+			unique_lock<mutex> guard(lock);
+			SlotState state = slot.state;
+			guard.unlock();
+			if(state == SLOT_FREE)
+				return true;
+
+			chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+
+			// Ainda na GPU: só acontece com poucos slots para a latência do driver
+			if(state == SLOT_READING){
+				if(not signaled(slot)){
+					if(policy == RECORD_DROP)
+						return false;
+					gpuWaits++;
+				}
+				collect(true);
+			}
+
+			// Nas threads: a gravação está mais lenta que a renderização
+			guard.lock();
+			if(slot.state == SLOT_QUEUED){
+				if(policy == RECORD_DROP)
+					return false;
+				writerWaits++;
+				while(slot.state != SLOT_FREE)
+					slotFreed.wait(guard);
+			}
+
+			waitMs += chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+			return true;
+		}//acquire
+
+		bool signaled(Slot &slot){
+			GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+			return status == GL_ALREADY_SIGNALED or status == GL_CONDITION_SATISFIED;
+		}//signaled
+
+		// Passa para as threads os slots já lidos, na ordem (wait = espera a GPU)
+		void collect(bool wait){
+			while(not reading.empty()){
+				Slot &slot = slots[reading.front()];
+				if(wait)
+					glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+				else if(not signaled(slot))
+					return;
+
+				glDeleteSync(slot.fence);
+				slot.fence = 0;
+
+				// Sem mapeamento persistente a cópia é feita aqui, com o contexto GL
+				if(not persistent){
+					glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.PBO);
+					void *data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.copy.size(), GL_MAP_READ_BIT);
+					if(data)
+						memcpy(slot.pixels, data, slot.copy.size());
+					glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+					glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+				}
+
+				{
+					lock_guard<mutex> guard(lock);
+					slot.state = SLOT_QUEUED;
+					jobs.push_back(reading.front());
+					if(jobs.size() > maxQueued)
+						maxQueued = jobs.size();
+				}
+				jobReady.notify_one();
+				reading.pop_front();
+			}
+		}//collect
+
+		// Thread de conversão e gravação
+		void work(){
+			vector<unsigned char> frame;
+			while(true){
+				int i;
+				{
+					unique_lock<mutex> guard(lock);
+					while(jobs.empty() and not finishing)
+						jobReady.wait(guard);
+					if(jobs.empty())
+						return;
+					i = jobs.front();
+					jobs.pop_front();
+				}
+
+				// Converte e devolve o slot antes de tocar no disco
+				Slot &slot = slots[i];
+				unsigned long index = slot.index;
+				if(format == RECORD_Y4M)
+					toYUV(slot.pixels, frame);
+				else
+					toRGB(slot.pixels, frame);
+				{
+					lock_guard<mutex> guard(lock);
+					slot.state = SLOT_FREE;
+				}
+				slotFreed.notify_one();
+
+				write(index, frame);
+			}
+		}//work
+
+		// Grava o frame; no fluxo espera a vez dele para manter a ordem
+		void write(unsigned long index, const vector<unsigned char> &frame){
+			if(format == RECORD_PPM){
+				char name[32];
+				snprintf(name, sizeof(name), "%06lu.ppm", index);
+				FILE *file = fopen((target + name).c_str(), "wb");
+				if(file){
+					fprintf(file, "P6\n%d %d\n255\n", width, height);
+					fwrite(&frame[0], 1, frame.size(), file);
+					fclose(file);
+				}
+				lock_guard<mutex> guard(lock);
+				written++;
+				return;
+			}
+
+			unique_lock<mutex> guard(lock);
+			while(nextWrite != index)
+				turn.wait(guard);
+
+			if(format == RECORD_Y4M)
+				fputs("FRAME\n", stream);
+			fwrite(&frame[0], 1, frame.size(), stream);
+
+			nextWrite++;
+			written++;
+			guard.unlock();
+			turn.notify_all();
+		}//write
+
+		// RGBA de baixo para cima -> RGB de cima para baixo
+		void toRGB(const unsigned char *pixels, vector<unsigned char> &rgb){
+			rgb.resize(width * height * 3);
+			for(int y = 0; y < height; y++){
+				const unsigned char *src = pixels + (height - 1 - y) * width * 4;
+				unsigned char *dst = &rgb[y * width * 3];
+				for(int x = 0; x < width; x++){
+					dst[0] = src[0];
+					dst[1] = src[1];
+					dst[2] = src[2];
+					src += 4;
+					dst += 3;
+				}
+			}
+		}//toRGB
+
+		// RGBA de baixo para cima -> planos Y, U, V (BT.601 completo, croma 2x2)
+		void toYUV(const unsigned char *pixels, vector<unsigned char> &yuv){
+			int chroma = (width / 2) * (height / 2);
+			yuv.resize(width * height + 2 * chroma);
+			unsigned char *Y = &yuv[0];
+			unsigned char *U = Y + width * height;
+			unsigned char *V = U + chroma;
+
+			for(int y = 0; y < height; y++){
+				const unsigned char *src = pixels + (height - 1 - y) * width * 4;
+				for(int x = 0; x < width; x++, src += 4)
+					Y[y * width + x] = (77 * src[0] + 150 * src[1] + 29 * src[2] + 128) >> 8;
+			}
+
+			for(int y = 0; y < height / 2; y++){
+				const unsigned char *row0 = pixels + (height - 1 - 2 * y) * width * 4;
+				const unsigned char *row1 = row0 - width * 4;
+				for(int x = 0; x < width / 2; x++){
+					const unsigned char *a = row0 + 8 * x, *b = row1 + 8 * x;
+					int r = a[0] + a[4] + b[0] + b[4];
+					int g = a[1] + a[5] + b[1] + b[5];
+					int bl = a[2] + a[6] + b[2] + b[6];
+					U[y * (width / 2) + x] = clamp((-43 * r - 85 * g + 128 * bl + 4 * 32768 + 512) >> 10);
+					V[y * (width / 2) + x] = clamp((128 * r - 107 * g - 21 * bl + 4 * 32768 + 512) >> 10);
+				}
+			}
+		}//toYUV
+
+		static unsigned char clamp(int x){
+			return x < 0 ? 0 : (x > 255 ? 255 : x);
+		}//clamp
+};
+
+bool Recorder::persistent = false;
+
+#endif
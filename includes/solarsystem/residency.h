@@ -0,0 +1,461 @@
+#ifndef RESIDENCY_H
+#define RESIDENCY_H
+
+#include <glad/glad.h>
+
+#include "glstate.h"
+#include "mipchain.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Textura controlada pela residência. Os níveis de mip abaixo de base não
+// estão na GPU (GL_TEXTURE_BASE_LEVEL aponta para o primeiro presente).
+struct ResidentTexture {
+	string file;             // origem, para recarregar
+	int width, height;       // nível 0
+	int components;
+	int levels;              // níveis da cadeia completa
+	int base;                // primeiro nível na GPU (0 = resolução cheia)
+	bool loading;            // há uma carga pendente na thread
+	unsigned long lastUse;   // último frame em que foi desenhada
+	int wanted;              // nível mais fino pedido no frame
+	unsigned long keep;      // último frame em que o nível base foi necessário
+};
+
+// Malha controlada pela residência: a cópia na CPU fica no Mesh, despejar
+// só libera os buffers e o próximo desenho os envia de novo
+struct ResidentMesh {
+	unsigned int VBO, EBO;
+	unsigned long bytes;
+	bool resident;
+	unsigned long lastUse;
+};
+
+// Carga pedida para a thread
+struct MipJob {
+	unsigned int id;
+	string file;
+	int target;                        // nível mais fino a ler
+};
+
+// Níveis lidos na thread, esperando o envio
+struct MipUpload {
+	unsigned int id;
+	int first;                         // nível de levels[0]
+	vector<vector<unsigned char> > levels;
+};
+
+// Orçamento de memória de vídeo para as texturas e malhas dos modelos. Cada
+// desenho marca o frame de uso; no fim do frame, se o total passa do
+// orçamento, os recursos não usados no frame são reduzidos na ordem do uso
+// mais antigo (LRU): primeiro as texturas perdem os níveis de cima até o lado
+// maior ter minSize pixels, depois texturas e malhas são despejadas. Uma
+// textura reduzida que volta a ser desenhada é decodificada de novo numa
+// thread, com os mips calculados na CPU, e os níveis que faltam são enviados
+// na thread principal.
+// Com streaming, o nível necessário vem do tamanho projetado do corpo
+// (detail, em pixels, definido antes de desenhá-lo): as texturas começam só
+// com os níveis de até initialSize pixels, os mais finos são lidos do
+// arquivo de mips (MipChain) quando o corpo cresce na tela e retirados de
+// novo depois de linger frames sem precisar deles. A residência por nível
+// usa GL_TEXTURE_BASE_LEVEL e GL_TEXTURE_MAX_LEVEL.
+class Residency {
+	protected:
+		static map<unsigned int, ResidentTexture> textures;
+		static map<unsigned int, ResidentMesh> meshes;
+		static unsigned long frames;
+
+		// Cargas assíncronas
+		static mutex lock;
+		static condition_variable wake;
+		static deque<MipJob> jobs;
+		static deque<MipUpload> done;
+		static thread *worker;
+		static bool running;
+
+		// Despejos no último segundo
+		static chrono::steady_clock::time_point windowStart;
+		static unsigned int windowEvictions;
+
+	public:
+		static unsigned long budget;      // bytes, 0 = sem limite
+		static int minSize;               // menor lado maior de uma textura só reduzida
+		static unsigned long used;        // bytes na GPU
+		static unsigned long peak;
+		static unsigned long evictions;   // níveis retirados e recursos despejados
+		static unsigned long restores;    // cargas de volta
+		static float evictionRate;        // despejos por segundo (último segundo)
+
+		static bool streaming;            // nível pelo tamanho projetado
+		static bool synchronous;          // lê na hora, sem thread (frames determinísticos)
+		static int initialSize;           // lado maior dos níveis carregados no início
+		static unsigned long linger;      // frames até retirar um nível fino sem uso
+		static float detail;              // raio projetado do corpo desenhado (pixels, 0 = resolução cheia)
+		static unsigned long streamed;    // níveis lidos pelo streaming
+
+		/** Registra uma textura já enviada, do nível base até o último
+			* @param file - Arquivo de origem (vazio: não pode ser reduzida)
+			*/
+		static void addTexture(unsigned int id, const string &file, int width, int height, int components, int base = 0){
+			ResidentTexture t;
+			t.file = file;
+			t.width = width;
+			t.height = height;
+			t.components = components;
+			t.levels = MipChain::levelCount(width, height);
+			t.base = base;
+			t.loading = false;
+			t.lastUse = frames;
+			t.wanted = t.levels;
+			t.keep = frames;
+			textures[id] = t;
+			used += textureBytes(t, base);
+			peak = max(peak, used);
+		}//addTexture
+
+		// Apaga a textura e tira do controle
+		static void release(unsigned int id){
+			map<unsigned int, ResidentTexture>::iterator it = textures.find(id);
+			if(it != textures.end()){
+				used -= textureBytes(it->second, it->second.base);
+				textures.erase(it);
+			}
+			GLState::deleteTexture(id);
+		}//release
+
+		static void addMesh(unsigned int VAO, unsigned int VBO, unsigned int EBO, unsigned long bytes){
+			ResidentMesh m = {VBO, EBO, bytes, true, frames};
+			meshes[VAO] = m;
+			used += bytes;
+			peak = max(peak, used);
+		}//addMesh
+
+		// A textura vai ser desenhada neste frame; sem o nível necessário, pede a carga
+		static void useTexture(unsigned int id){
+			map<unsigned int, ResidentTexture>::iterator it = textures.find(id);
+			if(it == textures.end())
+				return;
+
+			ResidentTexture &t = it->second;
+			int level = levelFor(t);
+			t.lastUse = frames;
+			t.wanted = min(t.wanted, level);
+			if(level <= t.base)
+				t.keep = frames;
+			if(level < t.base and not t.loading and not t.file.empty())
+				request(id, t, level);
+		}//useTexture
+
+		/** A malha vai ser desenhada: se foi despejada, envia de novo da cópia da CPU
+			* @param vertices, indices - Dados do Mesh
+			*/
+		static void useMesh(unsigned int VAO, const void *vertices, unsigned long vertexBytes, const void *indices, unsigned long indexBytes){
+			map<unsigned int, ResidentMesh>::iterator it = meshes.find(VAO);
+			if(it == meshes.end())
+				return;
+
+			ResidentMesh &m = it->second;
+			m.lastUse = frames;
+			if(m.resident)
+				return;
+
+			glBindBuffer(GL_ARRAY_BUFFER, m.VBO);
+			glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertices, GL_STATIC_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m.EBO);
+			glBufferData(GL_COPY_WRITE_BUFFER, indexBytes, indices, GL_STATIC_DRAW);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			m.resident = true;
+			used += m.bytes;
+			peak = max(peak, used);
+			restores++;
+		}//useMesh
+
+		// Começa um frame
+		static void frame(){
+			frames++;
+		}//frame
+
+		// Fim do frame: envia as cargas prontas e aplica o orçamento
+		static void update(){
+			upload();
+			coarsen();
+			enforce();
+
+			// Taxa de despejos, em janelas de um segundo
+			chrono::steady_clock::time_point now = chrono::steady_clock::now();
+			double seconds = chrono::duration<double>(now - windowStart).count();
+			if(seconds >= 1.0){
+				evictionRate = windowEvictions / seconds;
+				windowStart = now;
+				windowEvictions = 0;
+			}
+		}//update
+
+		// Linha curta para o HUD
+		static string status(){
+			char line[96];
+			if(budget)
+				snprintf(line, sizeof(line), "VRAM %.0f/%.0f MB, %.1f despejos/s", used / 1048576.0, budget / 1048576.0, evictionRate);
+			else
+				snprintf(line, sizeof(line), "VRAM %.0f MB", used / 1048576.0);
+			return line;
+		}//status
+
+		// Resumo da sessão
+		static string summary(){
+			char line[192];
+			snprintf(line, sizeof(line), "Residência: %.1f MB em uso, pico %.1f MB, orçamento %s, %lu despejos, %lu cargas de volta, %lu níveis lidos pelo streaming",
+					 used / 1048576.0, peak / 1048576.0, budget ? (to_string(budget / 1048576) + " MB").c_str() : "sem limite", evictions, restores, streamed);
+			return line;
+		}//summary
+
+		// Termina a thread de carga (também chamado no atexit)
+		static void stop(){
+			thread *t;
+			{
+				unique_lock<mutex> guard(lock);
+				if(not worker)
+					return;
+				running = false;
+				t = worker;
+				worker = NULL;
+			}
+			wake.notify_one();
+			t->join();
+			delete t;
+		}//stop
+
+		// Bytes dos níveis de base até o fim (RGB ocupa 4 bytes por texel na maioria dos drivers)
+		static unsigned long textureBytes(const ResidentTexture &t, int base){
+			unsigned long bytes = 0;
+			int texel = t.components == 1 ? 1 : 4;
+			for(int l = base; l < t.levels; l++)
+				bytes += (unsigned long) max(1, t.width >> l) * max(1, t.height >> l) * texel;
+			return bytes;
+		}//textureBytes
+
+		/** Nível necessário para o corpo desenhado agora: a largura da textura
+			* cobre a volta do corpo, 2 pi vezes o raio projetado
+			*/
+		static int levelFor(const ResidentTexture &t){
+			if(not streaming or detail <= 0.0f)
+				return 0;
+			float texels = 6.2832f * detail;
+			int level = 0;
+			while(level + 1 < t.levels and (t.width >> (level + 1)) >= texels)
+				level++;
+			return level;
+		}//levelFor
+
+		static GLenum format(int components){
+			if(components == 1)
+				return GL_RED;
+			return components == 3 ? GL_RGB : GL_RGBA;
+		}//format
+
+	protected:
+		// Retira os níveis de cima até base (a memória deles é liberada)
+		static void drop(unsigned int id, ResidentTexture &t, int base){
+			used -= textureBytes(t, t.base) - textureBytes(t, base);
+			GLState::bindTexture(GL_TEXTURE_2D, id);
+			for(int l = t.base; l < base; l++)
+				glTexImage2D(GL_TEXTURE_2D, l, format(t.components), 0, 0, 0, format(t.components), GL_UNSIGNED_BYTE, NULL);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, base);
+			GLState::bindTexture(GL_TEXTURE_2D, 0);
+			t.base = base;
+			evictions++;
+			windowEvictions++;
+		}//drop
+
+		// Streaming: retira os níveis finos que ficaram linger frames sem uso
+		// (um nível a mais que o pedido fica, para não oscilar na borda)
+		static void coarsen(){
+			for(map<unsigned int, ResidentTexture>::iterator it = textures.begin(); it != textures.end(); it++){
+				ResidentTexture &t = it->second;
+				int wanted = t.wanted;
+				t.wanted = t.levels;
+				if(not streaming or t.file.empty() or t.loading or t.lastUse != frames)
+					continue;
+				if(wanted > t.base + 1 and frames - t.keep > linger)
+					drop(it->first, t, wanted - 1);
+			}
+		}//coarsen
+
+		static void enforce(){
+			if(budget == 0 or used <= budget)
+				return;
+
+			// Candidatos: tudo que não foi usado neste frame, do uso mais antigo ao mais novo
+			vector<pair<unsigned long, long> > cold; // frame, id (texturas positivas, malhas -VAO - 1)
+			for(map<unsigned int, ResidentTexture>::iterator it = textures.begin(); it != textures.end(); it++)
+				if(it->second.lastUse < frames and not it->second.file.empty())
+					cold.push_back(make_pair(it->second.lastUse, (long) it->first));
+			for(map<unsigned int, ResidentMesh>::iterator it = meshes.begin(); it != meshes.end(); it++)
+				if(it->second.lastUse < frames and it->second.resident)
+					cold.push_back(make_pair(it->second.lastUse, -(long) it->first - 1));
+			sort(cold.begin(), cold.end());
+
+			// Primeiro reduz as texturas até minSize
+			for(unsigned int i = 0; i < cold.size() and used > budget; i++){
+				if(cold[i].second < 0)
+					continue;
+				ResidentTexture &t = textures[cold[i].second];
+				int base = t.base;
+				while(base + 1 < t.levels and max(t.width >> base, t.height >> base) > minSize)
+					base++;
+				if(base > t.base)
+					drop(cold[i].second, t, base);
+			}
+
+			// Depois despeja: a textura fica só com o último nível (1x1)
+			for(unsigned int i = 0; i < cold.size() and used > budget; i++){
+				if(cold[i].second >= 0){
+					ResidentTexture &t = textures[cold[i].second];
+					if(t.base < t.levels - 1)
+						drop(cold[i].second, t, t.levels - 1);
+					continue;
+				}
+
+				ResidentMesh &m = meshes[-cold[i].second - 1];
+				glBindBuffer(GL_ARRAY_BUFFER, m.VBO);
+				glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
+				glBindBuffer(GL_ARRAY_BUFFER, m.EBO);
+				glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
+				glBindBuffer(GL_ARRAY_BUFFER, 0);
+				m.resident = false;
+				used -= m.bytes;
+				evictions++;
+				windowEvictions++;
+			}
+		}//enforce
+
+		static void request(unsigned int id, ResidentTexture &t, int target){
+			MipJob job = {id, t.file, target};
+			t.loading = true;
+			if(synchronous){
+				MipUpload u = read(job);
+				unique_lock<mutex> guard(lock);
+				done.push_back(u);
+				return;
+			}
+
+			unique_lock<mutex> guard(lock);
+			if(not worker){
+				running = true;
+				worker = new thread(load);
+				atexit(stop);
+			}
+			jobs.push_back(job);
+			wake.notify_one();
+		}//request
+
+		// Envia os níveis decodificados que ainda faltam na GPU
+		static void upload(){
+			deque<MipUpload> ready;
+			{
+				unique_lock<mutex> guard(lock);
+				ready.swap(done);
+			}
+
+			for(unsigned int i = 0; i < ready.size(); i++){
+				MipUpload &u = ready[i];
+				map<unsigned int, ResidentTexture>::iterator it = textures.find(u.id);
+				if(it == textures.end())
+					continue;  // apagada enquanto carregava
+
+				ResidentTexture &t = it->second;
+				t.loading = false;
+				if(u.levels.empty() or t.base <= u.first)
+					continue;
+
+				int base = t.base;
+				GLState::bindTexture(GL_TEXTURE_2D, u.id);
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+				for(int l = u.first; l < base; l++){
+					vector<unsigned char> &pixels = u.levels[l - u.first];
+					glTexImage2D(GL_TEXTURE_2D, l, format(t.components), max(1, t.width >> l), max(1, t.height >> l), 0,
+								 format(t.components), GL_UNSIGNED_BYTE, &pixels[0]);
+				}
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, u.first);
+				GLState::bindTexture(GL_TEXTURE_2D, 0);
+
+				used += textureBytes(t, u.first) - textureBytes(t, base);
+				peak = max(peak, used);
+				if(streaming)
+					streamed += base - u.first;
+				t.base = u.first;
+				restores++;
+			}
+		}//upload
+
+		// Lê os níveis do arquivo de mips (criado na primeira vez)
+		static MipUpload read(const MipJob &job){
+			MipUpload u;
+			u.id = job.id;
+			u.first = job.target;
+			MipInfo info;
+			if(not MipChain::read(job.file, job.target, info, u.levels))
+				u.levels.clear();
+			return u;
+		}//read
+
+		// Thread de carga
+		static void load(){
+			unique_lock<mutex> guard(lock);
+			while(true){
+				wake.wait(guard, []{ return not jobs.empty() or not running; });
+				if(not running)
+					return;
+
+				MipJob job = jobs.front();
+				jobs.pop_front();
+				guard.unlock();
+
+				MipUpload u = read(job);
+
+				guard.lock();
+				done.push_back(u);
+			}
+		}//load
+};
+
+map<unsigned int, ResidentTexture> Residency::textures;
+map<unsigned int, ResidentMesh> Residency::meshes;
+unsigned long Residency::frames = 0;
+mutex Residency::lock;
+condition_variable Residency::wake;
+deque<MipJob> Residency::jobs;
+deque<MipUpload> Residency::done;
+thread *Residency::worker = NULL;
+bool Residency::running = false;
+chrono::steady_clock::time_point Residency::windowStart;
+unsigned int Residency::windowEvictions = 0;
+unsigned long Residency::budget = 0;
+int Residency::minSize = 64;
+unsigned long Residency::used = 0;
+unsigned long Residency::peak = 0;
+unsigned long Residency::evictions = 0;
+unsigned long Residency::restores = 0;
+float Residency::evictionRate = 0.0f;
+bool Residency::streaming = true;
+bool Residency::synchronous = false;
+int Residency::initialSize = 256;
+unsigned long Residency::linger = 300;
+float Residency::detail = 0.0f;
+unsigned long Residency::streamed = 0;
+
+#endif
@@ -0,0 +1,604 @@
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+#include <learnopengl/mesh.h>
+#include "meshcook.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Quádrica de erro da posição (Garland-Heckbert): soma ponderada dos quadrados
+// das distâncias aos planos dos triângulos
+struct Quadric {
+	double a00, a11, a22, a01, a02, a12;
+	double b0, b1, b2, c;
+	double w;  // soma das áreas
+};
+
+// Quádrica de um atributo (um canal da normal ou da coordenada): o atributo
+// varia linearmente em cada triângulo (gradiente g, a(p) = g·p + d), e o erro é
+// a diferença entre o valor interpolado e o do vértice
+struct AttributeQuadric {
+	double a00, a11, a22, a01, a02, a12;
+	double b0, b1, b2, c;
+	double g0, g1, g2, d;
+};
+
+// Simplificação por colapso de arestas com a métrica de erro quádrica, para
+// gerar os níveis de detalhe dos modelos importados (a nave e o que vier
+// depois). Cada colapso leva um vértice até um vizinho (os vértices não mudam,
+// só os índices: todos os níveis usam o mesmo buffer de vértices). O custo
+// soma o erro da posição e o dos atributos (normal e coordenada de textura),
+// então regiões planas com a textura esticada linearmente somem primeiro e
+// quinas, dobras de normal e mudanças de textura ficam.
+// Os vértices são classificados uma vez:
+//   - interno: pode ir para qualquer vizinho
+//   - borda: só ao longo da borda, para outro vértice de borda
+//   - costura (a mesma posição com duas normais ou coordenadas, como a emenda
+//     de uma textura): só ao longo da costura, os dois lados juntos
+//   - travado: o resto (três ou mais lados, geometria não-variedade)
+// As bordas e as costuras ainda ganham planos perpendiculares aos triângulos,
+// para não se afastarem do lugar. Colapsos que viram algum triângulo são
+// descartados.
+class Simplify {
+	protected:
+		enum Kind { MANIFOLD, BORDER, SEAM, LOCKED };
+		static const int channels = 5;  // normal (3) e coordenada (2)
+
+		static mutex lock;
+		static unsigned long meshes;
+		static vector<unsigned long long> triangles;  // de cada nível, somados
+		static double ms;
+
+	public:
+		static bool enabled;
+		static unsigned int levels;   // com o nível cheio
+		static float ratio;           // triângulos de um nível em relação ao anterior
+		static float maxError;        // desvio máximo de um nível, relativo ao tamanho da malha
+		static float normalWeight;    // peso do erro da normal (unitária)
+		static float uvWeight;        // peso do erro da coordenada de textura
+		static float pixelError;      // desvio na tela aceito ao escolher o nível (pixels)
+
+		/** Gera os níveis de detalhe de uma malha
+			* @param indices - Recebe os índices de cada nível depois dos do nível cheio
+			* @param lods - Um intervalo de indices por nível, do cheio ao mais simples; o erro em unidades do modelo
+			*/
+		static void lods(const vector<Vertex> &vertices, vector<unsigned int> &indices, vector<LodLevel> &lods){
+			lods.clear();
+			LodLevel full = {0, (unsigned int) indices.size(), 0.0f};
+			lods.push_back(full);
+			if(not enabled or levels < 2 or indices.size() < 3 * 32 or indices.size() % 3)
+				return;
+			chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+
+			vector<unsigned int> targets;
+			unsigned int target = indices.size() / 3;
+			for(unsigned int i = 1; i < levels; i++){
+				target = (unsigned int) (target * ratio);
+				if(target < 8)
+					break;
+				targets.push_back(target);
+			}
+
+			vector<vector<unsigned int> > out;
+			vector<float> errors;
+			simplify(vertices, indices, targets, maxError, out, errors);
+			for(unsigned int i = 0; i < out.size(); i++){
+				// Cada nível é desenhado sozinho: ordem própria para o cache de vértices
+				MeshCook::optimizeCache(out[i], vertices.size());
+				LodLevel level = {(unsigned int) indices.size(), (unsigned int) out[i].size(), errors[i]};
+				indices.insert(indices.end(), out[i].begin(), out[i].end());
+				lods.push_back(level);
+			}
+			double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+			unique_lock<mutex> guard(lock);
+			meshes++;
+			ms += elapsed;
+			if(triangles.size() < levels)
+				triangles.resize(levels, 0);
+			for(unsigned int i = 0; i < lods.size(); i++)
+				triangles[i] += lods[i].count / 3;
+			for(unsigned int i = lods.size(); i < levels; i++)
+				triangles[i] += lods.back().count / 3;
+		}//lods
+
+		/** Simplifica uma malha até cada alvo, enquanto o erro não passar do limite
+			* @param targets - Triângulos de cada nível, decrescentes
+			* @param limit - Desvio máximo, relativo à maior dimensão da malha
+			* @param out - Índices de cada nível alcançado (e do último passo, se o limite parou antes)
+			* @param errors - Desvio de cada nível, em unidades do modelo
+			*/
+		static void simplify(const vector<Vertex> &vertices, const vector<unsigned int> &indices, const vector<unsigned int> &targets,
+							 float limit, vector<vector<unsigned int> > &out, vector<float> &errors){
+			out.clear();
+			errors.clear();
+			unsigned int n = vertices.size();
+			if(indices.empty() or indices.size() % 3 or targets.empty())
+				return;
+
+			// Posições numa caixa de tamanho 1: erros relativos ao tamanho da malha
+			glm::dvec3 low(vertices[indices[0]].Position), high = low;
+			for(unsigned int i = 0; i < indices.size(); i++){
+				low = glm::min(low, glm::dvec3(vertices[indices[i]].Position));
+				high = glm::max(high, glm::dvec3(vertices[indices[i]].Position));
+			}
+			double extent = max(high.x - low.x, max(high.y - low.y, high.z - low.z));
+			if(extent <= 0.0)
+				return;
+			vector<glm::dvec3> position(n);
+			for(unsigned int i = 0; i < n; i++)
+				position[i] = (glm::dvec3(vertices[i].Position) - low) / extent;
+
+			// Vértices com a mesma posição, normal e coordenada viram um só (as
+			// tangentes são por face); os de uma posição formam um anel (wedge)
+			vector<unsigned int> attr(n), pos(n), wedge(n);
+			group(vertices, attr, pos, wedge);
+			vector<unsigned int> x(indices.size());
+			for(unsigned int i = 0; i < indices.size(); i++)
+				x[i] = attr[indices[i]];
+
+			vector<unsigned int> offsets, edges;
+			adjacency(x, n, offsets, edges);
+			vector<unsigned char> kind;
+			classify(n, pos, wedge, offsets, edges, kind);
+
+			vector<Quadric> quadrics(n);
+			vector<AttributeQuadric> attributes(n * channels);
+			vector<double> weights(n, 0.0);
+			buildQuadrics(vertices, position, x, pos, offsets, edges, quadrics, attributes, weights);
+
+			vector<unsigned int> collapse(n), triangleOffsets, triangleList;
+			vector<unsigned char> locked(n);
+			double error = 0.0;
+			unsigned int level = 0;
+			while(level < targets.size()){
+				unsigned int count = x.size() / 3;
+				if(count <= targets[level]){
+					out.push_back(x);
+					errors.push_back((float) (error * extent));
+					level++;
+					continue;
+				}
+
+				adjacency(x, n, offsets, edges);
+				triangleLists(x, n, pos, triangleOffsets, triangleList);
+
+				// Arestas candidatas, na direção mais barata permitida
+				vector<Collapse> candidates;
+				for(unsigned int i = 0; i < x.size(); i += 3)
+					for(unsigned int e = 0; e < 3; e++){
+						unsigned int i0 = x[i + e], i1 = x[i + (e + 1) % 3];
+						unsigned int k0 = kind[i0], k1 = kind[i1];
+						if(pos[i0] == pos[i1] or (not canCollapse(k0, k1) and not canCollapse(k1, k0)))
+							continue;
+						// Arestas com os dois sentidos aparecem duas vezes: fica uma
+						if(hasOpposite(k0, k1) and pos[i1] > pos[i0])
+							continue;
+						// Duas bordas (ou costuras) ligadas por dentro da malha, não pela borda
+						if(k0 == k1 and (k0 == BORDER or k0 == SEAM) and hasEdge(offsets, edges, i1, i0))
+							continue;
+
+						Collapse c = {i0, i1, 1e30f};
+						if(canCollapse(k0, k1))
+							c.error = cost(i0, i1, kind, pos, wedge, position, vertices, quadrics, attributes, weights);
+						if(canCollapse(k1, k0)){
+							float reverse = cost(i1, i0, kind, pos, wedge, position, vertices, quadrics, attributes, weights);
+							if(reverse < c.error){
+								c.v = i1;
+								c.t = i0;
+								c.error = reverse;
+							}
+						}
+						candidates.push_back(c);
+					}
+				sort(candidates.begin(), candidates.end());
+
+				// Os mais baratos primeiro; um vértice mexido (ou vizinho de um) espera o próximo passo
+				iota(collapse.begin(), collapse.end(), 0);
+				fill(locked.begin(), locked.end(), 0);
+				unsigned int needed = count - targets[level], removed = 0, performed = 0;
+				// Um passo não vai muito além do custo das arestas que bastariam para o alvo
+				// (cada uma leva dois triângulos): os caros esperam os baratos dos próximos passos
+				float passLimit = limit;
+				if(needed / 2 < candidates.size())
+					passLimit = min(passLimit, candidates[needed / 2].error * 1.5f);
+				for(unsigned int i = 0; i < candidates.size() and removed < needed; i++){
+					const Collapse &c = candidates[i];
+					if(c.error > passLimit)
+						break;
+					unsigned int v = c.v, t = c.t, pv = pos[v], pt = pos[t];
+					if(locked[pv] or locked[pt])
+						continue;
+					if(kind[v] == SEAM and not hasEdge(offsets, edges, wedge[v], wedge[t]) and not hasEdge(offsets, edges, wedge[t], wedge[v]))
+						continue;
+					if(flips(pv, pt, position[t], x, pos, position, triangleOffsets, triangleList))
+						continue;
+
+					collapse[v] = t;
+					merge(quadrics[pt], quadrics[pv]);
+					merge(attributes, weights, t, v);
+					if(kind[v] == SEAM){
+						collapse[wedge[v]] = wedge[t];
+						merge(attributes, weights, wedge[t], wedge[v]);
+					}
+					for(unsigned int j = triangleOffsets[pv]; j < triangleOffsets[pv + 1]; j++)
+						for(unsigned int k = 0; k < 3; k++)
+							locked[pos[x[triangleList[j] * 3 + k]]] = 1;
+					locked[pt] = 1;
+					error = max(error, (double) c.error);
+					removed += kind[v] == BORDER ? 1 : 2;
+					performed++;
+				}
+				if(not performed)
+					break;
+
+				// Triângulos com dois cantos na mesma posição somem
+				unsigned int kept = 0;
+				for(unsigned int i = 0; i < x.size(); i += 3){
+					unsigned int a = collapse[x[i]], b = collapse[x[i + 1]], c = collapse[x[i + 2]];
+					if(pos[a] == pos[b] or pos[b] == pos[c] or pos[c] == pos[a])
+						continue;
+					x[kept++] = a;
+					x[kept++] = b;
+					x[kept++] = c;
+				}
+				x.resize(kept);
+			}
+
+			// O limite de erro parou antes do alvo: o que foi alcançado ainda serve se simplificou bastante
+			unsigned int previous = out.empty() ? indices.size() : out.back().size();
+			if(level < targets.size() and x.size() < previous * 0.9){
+				out.push_back(x);
+				errors.push_back((float) (error * extent));
+			}
+		}//simplify
+
+		// Malhas simplificadas até agora e os triângulos de cada nível (saída)
+		static string summary(){
+			unique_lock<mutex> guard(lock);
+			if(not meshes)
+				return "LODs: nenhuma malha simplificada";
+			string x = "LODs: " + to_string(meshes) + " malhas, triângulos ";
+			for(unsigned int i = 0; i < triangles.size(); i++)
+				x += (i ? " -> " : "") + to_string(triangles[i]);
+			char line[64];
+			snprintf(line, sizeof(line), " em %.0f ms", ms);
+			return x + line;
+		}//summary
+
+	protected:
+		struct Collapse {
+			unsigned int v, t;  // v vai até t
+			float error;
+
+			bool operator<(const Collapse &other) const {
+				return error < other.error;
+			}
+		};
+
+		// Quem pode ir para quem
+		static bool canCollapse(unsigned int from, unsigned int to){
+			static const bool table[4][4] = {
+				{true, true, true, true},     // interno
+				{false, true, false, false},  // borda
+				{false, false, true, false},  // costura
+				{false, false, false, false}  // travado
+			};
+			return table[from][to];
+		}//canCollapse
+
+		// A aresta aparece nos dois sentidos (dois triângulos, ou os dois lados da costura)
+		static bool hasOpposite(unsigned int k0, unsigned int k1){
+			return k0 == MANIFOLD or k1 == MANIFOLD or (k0 == SEAM and k1 == SEAM);
+		}//hasOpposite
+
+		// Agrupa os vértices iguais (attr) e os da mesma posição (pos, o primeiro do grupo)
+		static void group(const vector<Vertex> &vertices, vector<unsigned int> &attr, vector<unsigned int> &pos, vector<unsigned int> &wedge){
+			unsigned int n = vertices.size();
+			vector<unsigned int> order(n);
+			iota(order.begin(), order.end(), 0);
+			sort(order.begin(), order.end(), [&vertices](unsigned int a, unsigned int b){
+				const Vertex &p = vertices[a], &q = vertices[b];
+				if(p.Position != q.Position)
+					return lexical(&p.Position[0], &q.Position[0], 3);
+				if(p.Normal != q.Normal)
+					return lexical(&p.Normal[0], &q.Normal[0], 3);
+				if(p.TexCoords != q.TexCoords)
+					return lexical(&p.TexCoords[0], &q.TexCoords[0], 2);
+				return a < b;
+			});
+
+			iota(wedge.begin(), wedge.end(), 0);
+			unsigned int first = 0, last = 0;  // primeiro e último distinto da posição
+			for(unsigned int i = 0; i < n; i++){
+				unsigned int v = order[i];
+				const Vertex *previous = i ? &vertices[order[i - 1]] : NULL;
+				if(not previous or previous->Position != vertices[v].Position){
+					first = last = attr[v] = pos[v] = v;
+					continue;
+				}
+				pos[v] = first;
+				if(previous->Normal == vertices[v].Normal and previous->TexCoords == vertices[v].TexCoords)
+					attr[v] = attr[order[i - 1]];
+				else{
+					// Mais um lado da posição, no anel
+					attr[v] = v;
+					wedge[v] = first;
+					wedge[last] = v;
+					last = v;
+				}
+			}
+		}//group
+
+		static bool lexical(const float *a, const float *b, int size){
+			for(int i = 0; i < size; i++)
+				if(a[i] != b[i])
+					return a[i] < b[i];
+			return false;
+		}//lexical
+
+		// Arestas que saem de cada vértice, em listas contíguas
+		static void adjacency(const vector<unsigned int> &x, unsigned int n, vector<unsigned int> &offsets, vector<unsigned int> &edges){
+			offsets.assign(n + 1, 0);
+			for(unsigned int i = 0; i < x.size(); i++)
+				offsets[x[i] + 1]++;
+			partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+			edges.resize(x.size());
+			vector<unsigned int> fillAt(offsets.begin(), offsets.end() - 1);
+			for(unsigned int i = 0; i < x.size(); i += 3)
+				for(unsigned int e = 0; e < 3; e++)
+					edges[fillAt[x[i + e]]++] = x[i + (e + 1) % 3];
+		}//adjacency
+
+		static bool hasEdge(const vector<unsigned int> &offsets, const vector<unsigned int> &edges, unsigned int a, unsigned int b){
+			for(unsigned int i = offsets[a]; i < offsets[a + 1]; i++)
+				if(edges[i] == b)
+					return true;
+			return false;
+		}//hasEdge
+
+		// Triângulos em volta de cada posição
+		static void triangleLists(const vector<unsigned int> &x, unsigned int n, const vector<unsigned int> &pos,
+								  vector<unsigned int> &offsets, vector<unsigned int> &list){
+			offsets.assign(n + 1, 0);
+			for(unsigned int i = 0; i < x.size(); i++)
+				offsets[pos[x[i]] + 1]++;
+			partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+			list.resize(x.size());
+			vector<unsigned int> fillAt(offsets.begin(), offsets.end() - 1);
+			for(unsigned int i = 0; i < x.size(); i++)
+				list[fillAt[pos[x[i]]]++] = i / 3;
+		}//triangleLists
+
+		// Tipo de cada vértice pelas arestas abertas (sem a oposta) que saem e chegam nele
+		static void classify(unsigned int n, const vector<unsigned int> &pos, const vector<unsigned int> &wedge,
+							 const vector<unsigned int> &offsets, const vector<unsigned int> &edges, vector<unsigned char> &kind){
+			// none: nenhuma; o próprio vértice: mais de uma
+			const unsigned int none = 0xffffffffu;
+			vector<unsigned int> openOut(n, none), openIn(n, none);
+			for(unsigned int a = 0; a < n; a++)
+				for(unsigned int i = offsets[a]; i < offsets[a + 1]; i++){
+					unsigned int b = edges[i];
+					if(hasEdge(offsets, edges, b, a))
+						continue;
+					openOut[a] = openOut[a] == none ? b : a;
+					openIn[b] = openIn[b] == none ? a : b;
+				}
+
+			kind.assign(n, LOCKED);
+			for(unsigned int v = 0; v < n; v++){
+				if(pos[v] != v)
+					continue;
+				unsigned char k = LOCKED;
+				if(wedge[v] == v){
+					if(openOut[v] == none and openIn[v] == none)
+						k = MANIFOLD;
+					else if(single(openOut, v, none) and single(openIn, v, none))
+						k = BORDER;
+				}
+				else if(wedge[wedge[v]] == v){
+					// Dois lados: a aresta aberta que sai de um chega no outro
+					unsigned int w = wedge[v];
+					if(single(openOut, v, none) and single(openIn, v, none) and single(openOut, w, none) and single(openIn, w, none) and
+					   pos[openOut[v]] == pos[openIn[w]] and pos[openIn[v]] == pos[openOut[w]])
+						k = SEAM;
+				}
+				unsigned int w = v;
+				do{
+					kind[w] = k;
+					w = wedge[w];
+				}while(w != v);
+			}
+		}//classify
+
+		static bool single(const vector<unsigned int> &open, unsigned int v, unsigned int none){
+			return open[v] != none and open[v] != v;
+		}//single
+
+		// Planos dos triângulos, das bordas e das costuras, e os gradientes dos atributos
+		static void buildQuadrics(const vector<Vertex> &vertices, const vector<glm::dvec3> &position, const vector<unsigned int> &x,
+								  const vector<unsigned int> &pos, const vector<unsigned int> &offsets, const vector<unsigned int> &edges,
+								  vector<Quadric> &quadrics, vector<AttributeQuadric> &attributes, vector<double> &weights){
+			for(unsigned int i = 0; i < x.size(); i += 3){
+				const unsigned int *v = &x[i];
+				glm::dvec3 p0 = position[v[0]], p1 = position[v[1]], p2 = position[v[2]];
+				glm::dvec3 e1 = p1 - p0, e2 = p2 - p0;
+				glm::dvec3 normal = glm::cross(e1, e2);
+				double area = glm::length(normal);
+				if(area <= 0.0)
+					continue;
+				normal /= area;
+				area *= 0.5;
+
+				Quadric plane = fromPlane(normal, -glm::dot(normal, p0), area);
+				plane.w = area;
+				for(unsigned int k = 0; k < 3; k++){
+					merge(quadrics[pos[v[k]]], plane);
+					weights[v[k]] += area;
+				}
+
+				// Gradiente de cada canal no plano do triângulo
+				double d11 = glm::dot(e1, e1), d12 = glm::dot(e1, e2), d22 = glm::dot(e2, e2);
+				double det = d11 * d22 - d12 * d12;
+				if(det > 0.0)
+					for(int j = 0; j < channels; j++){
+						double s0 = channel(vertices[v[0]], j), s1 = channel(vertices[v[1]], j), s2 = channel(vertices[v[2]], j);
+						double u = (d22 * (s1 - s0) - d12 * (s2 - s0)) / det;
+						double w = (d11 * (s2 - s0) - d12 * (s1 - s0)) / det;
+						glm::dvec3 g = u * e1 + w * e2;
+						AttributeQuadric q = fromGradient(g, s0 - glm::dot(g, p0), area);
+						for(unsigned int k = 0; k < 3; k++)
+							merge(attributes[v[k] * channels + j], q);
+					}
+
+				// Arestas abertas (borda ou um lado da costura): plano perpendicular ao triângulo
+				for(unsigned int e = 0; e < 3; e++){
+					unsigned int a = v[e], b = v[(e + 1) % 3];
+					if(hasEdge(offsets, edges, b, a))
+						continue;
+					glm::dvec3 edge = position[b] - position[a];
+					double length = glm::length(edge);
+					if(length <= 0.0)
+						continue;
+					glm::dvec3 side = glm::normalize(glm::cross(edge, normal));
+					Quadric border = fromPlane(side, -glm::dot(side, position[a]), length * length * 10.0);
+					border.w = length * length * 10.0;
+					merge(quadrics[pos[a]], border);
+					merge(quadrics[pos[b]], border);
+				}
+			}
+		}//buildQuadrics
+
+		// Canal j dos atributos de um vértice, com o peso
+		static double channel(const Vertex &v, int j){
+			return j < 3 ? v.Normal[j] * normalWeight : v.TexCoords[j - 3] * uvWeight;
+		}//channel
+
+		static Quadric fromPlane(const glm::dvec3 &n, double d, double w){
+			Quadric q;
+			q.a00 = w * n.x * n.x; q.a11 = w * n.y * n.y; q.a22 = w * n.z * n.z;
+			q.a01 = w * n.x * n.y; q.a02 = w * n.x * n.z; q.a12 = w * n.y * n.z;
+			q.b0 = w * n.x * d; q.b1 = w * n.y * d; q.b2 = w * n.z * d;
+			q.c = w * d * d;
+			q.w = 0.0;
+			return q;
+		}//fromPlane
+
+		static AttributeQuadric fromGradient(const glm::dvec3 &g, double d, double w){
+			AttributeQuadric q;
+			q.a00 = w * g.x * g.x; q.a11 = w * g.y * g.y; q.a22 = w * g.z * g.z;
+			q.a01 = w * g.x * g.y; q.a02 = w * g.x * g.z; q.a12 = w * g.y * g.z;
+			q.b0 = w * g.x * d; q.b1 = w * g.y * d; q.b2 = w * g.z * d;
+			q.c = w * d * d;
+			q.g0 = w * g.x; q.g1 = w * g.y; q.g2 = w * g.z;
+			q.d = w * d;
+			return q;
+		}//fromGradient
+
+		static void merge(Quadric &q, const Quadric &r){
+			q.a00 += r.a00; q.a11 += r.a11; q.a22 += r.a22;
+			q.a01 += r.a01; q.a02 += r.a02; q.a12 += r.a12;
+			q.b0 += r.b0; q.b1 += r.b1; q.b2 += r.b2;
+			q.c += r.c;
+			q.w += r.w;
+		}//merge
+
+		static void merge(AttributeQuadric &q, const AttributeQuadric &r){
+			q.a00 += r.a00; q.a11 += r.a11; q.a22 += r.a22;
+			q.a01 += r.a01; q.a02 += r.a02; q.a12 += r.a12;
+			q.b0 += r.b0; q.b1 += r.b1; q.b2 += r.b2;
+			q.c += r.c;
+			q.g0 += r.g0; q.g1 += r.g1; q.g2 += r.g2;
+			q.d += r.d;
+		}//merge
+
+		// Os cantos de v passam a usar os atributos de t
+		static void merge(vector<AttributeQuadric> &attributes, vector<double> &weights, unsigned int t, unsigned int v){
+			for(int j = 0; j < channels; j++)
+				merge(attributes[t * channels + j], attributes[v * channels + j]);
+			weights[t] += weights[v];
+		}//merge
+
+		// pᵀAp + 2b·p + c
+		template <typename Q>
+		static double quadratic(const Q &q, const glm::dvec3 &p){
+			return p.x * (q.a00 * p.x + 2.0 * (q.a01 * p.y + q.a02 * p.z + q.b0)) +
+				   p.y * (q.a11 * p.y + 2.0 * (q.a12 * p.z + q.b1)) +
+				   p.z * (q.a22 * p.z + 2.0 * q.b2) + q.c;
+		}//quadratic
+
+		// Erro dos atributos do vértice v colocado em p com os atributos de t
+		static double attributeError(const vector<AttributeQuadric> &attributes, const vector<double> &weights, const vector<Vertex> &vertices,
+									 unsigned int v, unsigned int t, const glm::dvec3 &p){
+			if(weights[v] <= 0.0)
+				return 0.0;
+			double x = 0.0;
+			for(int j = 0; j < channels; j++){
+				const AttributeQuadric &q = attributes[v * channels + j];
+				double s = channel(vertices[t], j);
+				x += quadratic(q, p) - 2.0 * s * (q.g0 * p.x + q.g1 * p.y + q.g2 * p.z + q.d) + s * s * weights[v];
+			}
+			return x / weights[v];
+		}//attributeError
+
+		// Desvio (relativo ao tamanho da malha) de levar v até t
+		static float cost(unsigned int v, unsigned int t, const vector<unsigned char> &kind, const vector<unsigned int> &pos,
+						  const vector<unsigned int> &wedge, const vector<glm::dvec3> &position, const vector<Vertex> &vertices,
+						  const vector<Quadric> &quadrics, const vector<AttributeQuadric> &attributes, const vector<double> &weights){
+			const Quadric &q = quadrics[pos[v]];
+			const glm::dvec3 &p = position[t];
+			double x = q.w > 0.0 ? quadratic(q, p) / q.w : 0.0;
+			x += attributeError(attributes, weights, vertices, v, t, p);
+			if(kind[v] == SEAM)
+				x += attributeError(attributes, weights, vertices, wedge[v], wedge[t], p);
+			return (float) sqrt(max(x, 0.0));
+		}//cost
+
+		// Algum triângulo em volta de pv (que não some no colapso) vira ao levar pv até p
+		static bool flips(unsigned int pv, unsigned int pt, const glm::dvec3 &p, const vector<unsigned int> &x, const vector<unsigned int> &pos,
+						  const vector<glm::dvec3> &position, const vector<unsigned int> &offsets, const vector<unsigned int> &list){
+			for(unsigned int i = offsets[pv]; i < offsets[pv + 1]; i++){
+				const unsigned int *tri = &x[list[i] * 3];
+				glm::dvec3 corner[3], moved[3];
+				bool removed = false;
+				for(unsigned int k = 0; k < 3; k++){
+					removed = removed or pos[tri[k]] == pt;
+					corner[k] = moved[k] = position[tri[k]];
+					if(pos[tri[k]] == pv)
+						moved[k] = p;
+				}
+				if(removed)
+					continue;
+				glm::dvec3 before = glm::cross(corner[1] - corner[0], corner[2] - corner[0]);
+				glm::dvec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+				if(glm::dot(before, after) <= 0.0)
+					return true;
+			}
+			return false;
+		}//flips
+};
+
+mutex Simplify::lock;
+unsigned long Simplify::meshes = 0;
+vector<unsigned long long> Simplify::triangles;
+double Simplify::ms = 0.0;
+bool Simplify::enabled = true;
+unsigned int Simplify::levels = 4;
+float Simplify::ratio = 0.5f;
+float Simplify::maxError = 0.05f;
+float Simplify::normalWeight = 0.05f;
+float Simplify::uvWeight = 1.0f;
+float Simplify::pixelError = 1.0f;
+
+#endif
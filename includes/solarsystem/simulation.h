@@ -0,0 +1,90 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <glm/glm.hpp>
+
+#include "sun.h"
+#include "planet.h"
+#include "moon.h"
+#include "catalogue.h"
+
+#include <deque>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// Núcleo da simulação: corpos, relógio e integração, sem OpenGL nem GLFW.
+// O visualizador usa o mesmo relógio (tick) e o mesmo catálogo.
+class Simulation {
+	public:
+		Sun sun;
+		deque<Planet> planets; // deque: as luas guardam ponteiros para os planetas
+		deque<Moon> moons;
+		unsigned long steps;
+
+		// Monta o sistema solar a partir do catálogo
+		Simulation(): sun(sunCatalogue().name, sunCatalogue().scale){
+			BodyInfo info = sunCatalogue();
+			sun.setReal(info.realDiameter);
+			steps = 0;
+
+			vector<BodyInfo> planet = planetCatalogue();
+			vector<BodyInfo> moon = moonCatalogue();
+
+			for(unsigned int i = 0; i < planet.size(); i++){
+				Planet p(planet[i].name, planet[i].scale, planet[i].orbit, planet[i].rotation, planet[i].distance);
+				p.setReal(planet[i].realDiameter, planet[i].realDistance);
+				p.setMoons(countMoons(moon, i));
+				planets.push_back(p);
+			}
+
+			for(unsigned int i = 0; i < moon.size(); i++){
+				Moon m(moon[i].name, moon[i].scale, moon[i].orbit, moon[i].rotation, moon[i].distance, &planets[moon[i].parent]);
+				m.setReal(moon[i].realDiameter, moon[i].realDistance);
+				moons.push_back(m);
+			}
+		}//Simulation
+
+		// Avança o relógio do mundo (o mesmo que o passingTime do visualizador)
+		static void tick(float dt){
+			if (not Planet::pause)
+				Planet::time += dt * Planet::worldSpeed;
+		}//tick
+
+		// Um passo: avança o relógio e atualiza as posições (planetas antes das luas)
+		void step(float dt){
+			tick(dt);
+
+			for(unsigned int i = 0; i < planets.size(); i++)
+				planets[i].render();
+			for(unsigned int i = 0; i < moons.size(); i++)
+				moons[i].render();
+
+			steps++;
+		}//step
+
+		// Grava o estado em CSV: passo, tempo, corpo, x, y, z
+		void dump(ostream &out){
+			for(unsigned int i = 0; i < planets.size(); i++)
+				row(out, planets[i].getName(), planets[i].getPosition());
+			for(unsigned int i = 0; i < moons.size(); i++)
+				row(out, moons[i].getName(), moons[i].getPosition());
+		}//dump
+
+		static unsigned int countMoons(const vector<BodyInfo> &moon, int planet){
+			unsigned int x = 0;
+			for(unsigned int i = 0; i < moon.size(); i++)
+				if(moon[i].parent == planet)
+					x++;
+			return x;
+		}//countMoons
+
+	private:
+		void row(ostream &out, const string &name, glm::vec3 position){
+			out << steps << "," << Planet::time << "," << name << ","
+				<< position.x << "," << position.y << "," << position.z << "\n";
+		}//row
+};
+
+#endif
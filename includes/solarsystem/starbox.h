@@ -0,0 +1,249 @@
+#ifndef STARBOX_H
+#define STARBOX_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <learnopengl/shader_m.h>
+#include <learnopengl/model.h>
+
+#include "depth.h"
+#include "drawstats.h"
+#include "glstate.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// Faces do cubemap: potências de 2 entre esses limites. Com 4096 as 6 faces
+// ocupam ~400 MB; o zoom só refaz o cubemap quando troca de potência
+#define STARBOX_MIN_FACE 256
+#define STARBOX_MAX_FACE 4096
+
+// Fundo de estrelas guardado em um cubemap.
+// As estrelas são rasterizadas uma única vez nas 6 faces do cubemap e depois
+// desenhadas como skybox com um único triângulo de tela cheia. O cubemap só é
+// refeito quando o catálogo, o limite de magnitude ou a resolução mudam.
+class StarBox {
+	protected:
+		Model *Catalogue;    // modelo das estrelas
+		Shader *Capture;     // shader usado para rasterizar as faces
+		Shader *Sky;         // shader do skybox
+		float Magnitude;     // limite de magnitude visível
+		float Fov;           // campo de visão usado para casar a resolução
+		int width, height;   // tamanho da janela
+		int faceSize;        // tamanho de cada face do cubemap
+		bool dirty;          // precisa ser re-renderizado
+		unsigned int cubemap, fbo, depth, vao;
+
+	public:
+		static unsigned int captures; // quantas vezes o cubemap foi renderizado
+
+		/** Construtor do fundo de estrelas
+			* @param catalogue - Modelo com as estrelas
+			* @param capture - Shader que desenha as estrelas nas faces
+			* @param sky - Shader que desenha o skybox
+			*/
+		StarBox(Model *catalogue, Shader *capture, Shader *sky){
+			Catalogue = catalogue;
+			Capture = capture;
+			Sky = sky;
+			Magnitude = 6.5f;
+			Fov = 45.0f;
+			width = height = 0;
+			faceSize = 0;
+			dirty = true;
+			cubemap = depth = 0;
+
+			glGenFramebuffers(1, &fbo);
+			// o triângulo de tela cheia é gerado no vertex shader
+			glGenVertexArrays(1, &vao);
+		}//StarBox
+
+		// Troca o catálogo de estrelas
+		void setCatalogue(Model *catalogue){
+			if(catalogue == Catalogue)
+				return;
+			Catalogue = catalogue;
+			dirty = true;
+		}//setCatalogue
+
+		// Troca o limite de magnitude (estrelas mais fracas são descartadas)
+		void setMagnitude(float magnitude){
+			if(magnitude == Magnitude)
+				return;
+			Magnitude = magnitude;
+			dirty = true;
+		}//setMagnitude
+
+		float getMagnitude(){
+			return Magnitude;
+		}//getMagnitude
+
+		// Atualiza o tamanho da janela, recalculando o tamanho das faces
+		void setResolution(int w, int h, float fov){
+			if(w <= 0 or h <= 0)
+				return;
+
+			width = w;
+			height = h;
+			Fov = fov;
+
+			// Pixels por face para que um texel do cubemap cubra ~1 pixel da tela:
+			// a face cobre tan(45°) = 1 e a tela cobre tan(fov/2) na vertical
+			int needed = (int) ceil(h / tan(glm::radians(fov) / 2.0f));
+
+			int maxSize;
+			glGetIntegerv(GL_MAX_CUBE_MAP_TEXTURE_SIZE, &maxSize);
+			maxSize = min(maxSize, STARBOX_MAX_FACE);
+			int size = STARBOX_MIN_FACE;
+			while(size < needed and size * 2 <= maxSize)
+				size *= 2;
+
+			if(size != faceSize){
+				faceSize = size;
+				dirty = true;
+			}
+		}//setResolution
+
+		// Força uma nova renderização do cubemap
+		void invalidate(){
+			dirty = true;
+		}//invalidate
+
+		bool isDirty(){
+			return dirty;
+		}//isDirty
+
+		// O cubemap já pode ser desenhado
+		bool isReady(){
+			return cubemap != 0;
+		}//isReady
+
+		// Re-renderiza o cubemap, apenas se ele foi invalidado
+		void update(){
+			if(not dirty or faceSize == 0)
+				return;
+
+			capture();
+			dirty = false;
+		}//update
+
+		/** Desenha o skybox com um único triângulo de tela cheia
+			* @param projection - Projeção da câmera
+			* @param view - View da câmera
+			* @param orientation - Rotação aplicada nas estrelas
+			*/
+		void draw(glm::mat4 projection, glm::mat4 view, glm::mat4 orientation){
+			if(not isReady())
+				return;
+
+			// remove a translação da câmera, o fundo fica no infinito
+			glm::mat4 rotation = glm::mat4(glm::mat3(view));
+			glm::mat4 inverse = glm::inverse(projection * rotation);
+
+			Sky->use();
+			Sky->setMat4("inverseViewProjection", inverse);
+			Sky->setMat3("orientation", glm::transpose(glm::mat3(orientation)));
+			Sky->setInt("skybox", 0);
+			Sky->setFloat("farPlane", Depth::farPlane());
+
+			GLState::bindTextureUnit(0, GL_TEXTURE_CUBE_MAP, cubemap);
+
+			// fica no plano distante: só aparece onde nada foi desenhado (a nave)
+			glDepthFunc(Depth::farFunc());
+			glDepthMask(GL_FALSE);
+			GLState::bindVertexArray(vao);
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+			DrawStats::add(1);
+			glDepthMask(GL_TRUE);
+			glDepthFunc(Depth::func());
+		}//draw
+
+	private:
+		// Rasteriza as estrelas nas 6 faces do cubemap
+		void capture(){
+			// direções e up de cada face, na ordem de GL_TEXTURE_CUBE_MAP_POSITIVE_X
+			const glm::vec3 front[6] = {
+				glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(-1.0f,  0.0f,  0.0f),
+				glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3( 0.0f, -1.0f,  0.0f),
+				glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3( 0.0f,  0.0f, -1.0f)
+			};
+			const glm::vec3 up[6] = {
+				glm::vec3(0.0f, -1.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f),
+				glm::vec3(0.0f,  0.0f,  1.0f), glm::vec3(0.0f,  0.0f, -1.0f),
+				glm::vec3(0.0f, -1.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)
+			};
+
+			allocate();
+
+			GLint viewport[4];
+			glGetIntegerv(GL_VIEWPORT, viewport);
+
+			glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+			glViewport(0, 0, faceSize, faceSize);
+			Depth::suspend();
+
+			// Mesma matriz de modelo usada antes pelo render_stars
+			glm::mat4 model;
+			model = glm::scale(model, 30.0f * glm::vec3(1.0f, 1.0f, 1.0f));
+			glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.01f, 1000.0f);
+
+			Capture->use();
+			Capture->setMat4("model", model);
+			Capture->setMat4("projection", projection);
+			// Fluxo relativo de uma estrela de magnitude m: 10^(-0.4m)
+			Capture->setFloat("threshold", pow(10.0f, -0.4f * Magnitude));
+
+			for(int i = 0; i < 6; i++){
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, cubemap, 0);
+				glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+				Capture->setMat4("view", glm::lookAt(glm::vec3(0.0f), front[i], up[i]));
+				Catalogue->Draw(*Capture);
+			}
+
+			Depth::resume();
+			glBindFramebuffer(GL_FRAMEBUFFER, Depth::target());
+			glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+			captures++;
+		}//capture
+
+		// (Re)cria o cubemap com o tamanho atual das faces
+		void allocate(){
+			if(cubemap)
+				GLState::deleteTexture(cubemap);
+			if(depth)
+				glDeleteRenderbuffers(1, &depth);
+
+			glGenTextures(1, &cubemap);
+			GLState::bindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+			for(int i = 0; i < 6; i++)
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB8, faceSize, faceSize, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+			glGenRenderbuffers(1, &depth);
+			glBindRenderbuffer(GL_RENDERBUFFER, depth);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, faceSize, faceSize);
+
+			glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+			glBindFramebuffer(GL_FRAMEBUFFER, Depth::target());
+		}//allocate
+};
+
+unsigned int StarBox::captures = 0;
+
+#endif
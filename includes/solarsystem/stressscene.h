@@ -0,0 +1,228 @@
+#ifndef STRESSSCENE_H
+#define STRESSSCENE_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "sun.h"
+#include "planet.h"
+#include "moon.h"
+#include "catalogue.h"
+
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Raio do modelo da esfera, usado nas esferas envolventes do culling
+#define STRESS_SPHERE_RADIUS 2.606874f
+
+// Partícula do cinturão de asteroides: só a órbita, sem rotação própria
+struct Asteroid {
+	float distance; // distância da origem
+	float orbit;    // período orbital
+	float phase;    // ângulo inicial (graus)
+	float height;   // altura sobre o plano da órbita
+	float scale;    // usado para decidir a escala, como nos planetas
+};
+
+// Tempo de cada estágio do último passo (ms)
+struct StageTimes {
+	double transforms; // matrizes de todos os corpos
+	double cull;       // teste das esferas contra o frustum
+	double submit;     // fluxo de matrizes dos corpos visíveis
+};
+
+// Cena sintética para medir como cada estágio escala com o número de corpos:
+// N planetas com M luas cada e K asteroides. Planetas e luas repetem os
+// parâmetros de órbita do catálogo (planetas em cascas cada vez mais
+// distantes, com período de Kepler); os asteroides formam um cinturão entre
+// Marte e Júpiter. Os corpos ficam na ordem planetas, luas, asteroides.
+// Não usa OpenGL: o envio só monta o fluxo de matrizes no layout std140 do
+// bloco "Object", e o visualizador desenha a partir dele.
+class StressScene {
+	public:
+		deque<Planet> planets; // deque: as luas guardam ponteiros para os planetas
+		deque<Moon> moons;
+		vector<Asteroid> asteroids;
+		vector<glm::mat4> models;      // matriz de cada corpo
+		vector<float> radius;          // raio da esfera envolvente de cada corpo
+		vector<unsigned int> visible;  // corpos que passaram no culling
+		vector<glm::mat4> stream;      // matrizes dos visíveis, na ordem do envio
+		StageTimes times;
+
+		StressScene(){
+			times.transforms = times.cull = times.submit = 0.0;
+		}//StressScene
+
+		/** Gera a cena
+			* @param n - Planetas
+			* @param m - Luas por planeta
+			* @param k - Asteroides
+			* @param seed - Semente das fases e do cinturão
+			*/
+		void generate(unsigned int n, unsigned int m, unsigned int k, unsigned int seed = 1){
+			planets.clear();
+			moons.clear();
+			asteroids.clear();
+
+			vector<BodyInfo> planet = planetCatalogue();
+			vector<BodyInfo> moon = moonCatalogue();
+			mt19937 random(seed);
+			uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+			// O relógio no momento da construção define a fase da órbita:
+			// recuando um tempo aleatório os corpos não começam alinhados
+			float clock = Planet::time;
+
+			// Cada volta do catálogo fica numa casca mais distante
+			for(unsigned int i = 0; i < n; i++){
+				BodyInfo &b = planet[i % planet.size()];
+				unsigned int shell = i / planet.size();
+				float distance = b.distance + 8.0f * shell;
+				float orbit = b.orbit * pow(distance / b.distance, 1.5f);
+				Planet::time = clock - orbit * Planet::years * unit(random);
+				Planet p(b.name + "-" + to_string(i), b.scale, orbit, b.rotation, distance);
+				p.setReal(b.realDiameter, b.realDistance * distance / b.distance);
+				p.setMoons(m);
+				planets.push_back(p);
+			}
+
+			// A lua j usa a entrada j do catálogo (o visualizador usa o mesmo modelo)
+			for(unsigned int i = 0; i < n; i++)
+				for(unsigned int l = 0; l < m; l++){
+					BodyInfo &b = moon[(i * m + l) % moon.size()];
+					Planet::time = clock - b.orbit * Planet::years * unit(random);
+					Moon x(b.name + "-" + to_string(i * m + l), b.scale, b.orbit, b.rotation, b.distance, &planets[i]);
+					x.setReal(b.realDiameter, b.realDistance);
+					moons.push_back(x);
+				}
+			Planet::time = clock;
+
+			// Cinturão entre Marte e Júpiter, com o período de Kepler a partir de Marte
+			BodyInfo &mars = planet[3];
+			BodyInfo &jupiter = planet[4];
+			for(unsigned int i = 0; i < k; i++){
+				Asteroid a;
+				a.distance = mars.distance + (jupiter.distance - mars.distance) * (0.2f + 0.6f * unit(random));
+				a.orbit = mars.orbit * pow(a.distance / mars.distance, 1.5f);
+				a.phase = 360.0f * unit(random);
+				a.height = 0.04f * a.distance * (unit(random) - 0.5f);
+				a.scale = 200.0f + 800.0f * unit(random);
+				asteroids.push_back(a);
+			}
+
+			models.resize(bodies());
+			radius.resize(bodies());
+			visible.reserve(bodies());
+			stream.reserve(bodies());
+		}//generate
+
+		unsigned long bodies(){
+			return planets.size() + moons.size() + asteroids.size();
+		}//bodies
+
+		// Distância do corpo mais distante, na escala atual
+		float outer(){
+			float x = 0.0f;
+			for(unsigned int i = 0; i < planets.size(); i++)
+				x = max(x, planets[i].getDistance() * Planet::UA);
+			return x;
+		}//outer
+
+		// Matrizes de todos os corpos (planetas antes das luas)
+		void transforms(){
+			unsigned int b = 0;
+			for(unsigned int i = 0; i < planets.size(); i++, b++){
+				models[b] = planets[i].render();
+				radius[b] = STRESS_SPHERE_RADIUS * planets[i].getSize();
+			}
+			for(unsigned int i = 0; i < moons.size(); i++, b++){
+				models[b] = moons[i].render();
+				radius[b] = STRESS_SPHERE_RADIUS * moons[i].getSize();
+			}
+
+			// Os asteroides só transladam: a matriz é montada direto
+			for(unsigned int i = 0; i < asteroids.size(); i++, b++){
+				Asteroid &a = asteroids[i];
+				float angle = glm::radians(a.phase);
+				if(Planet::years * a.orbit != 0)
+					angle += glm::radians(360.0f) * Planet::time / (a.orbit * Planet::years);
+
+				float size = a.scale * Sun::size;
+				float d = a.distance * Planet::UA;
+				glm::mat4 &matrix = models[b];
+				matrix = glm::mat4(size);
+				matrix[3] = glm::vec4(d * cos(angle), a.height * Planet::UA, -d * sin(angle), 1.0f);
+				radius[b] = STRESS_SPHERE_RADIUS * size;
+			}
+		}//transforms
+
+		/** Guarda os corpos cuja esfera toca o frustum
+			* @param viewProj - Projeção vezes a visão da câmera
+			*/
+		void cull(const glm::mat4 &viewProj){
+			// Planos do frustum (Gribb e Hartmann), normalizados; com o far
+			// infinito do Z invertido o plano do fundo fica sem normal e passa tudo
+			glm::vec4 planes[6];
+			glm::mat4 m = glm::transpose(viewProj);
+			for(int i = 0; i < 3; i++){
+				planes[2 * i]     = m[3] + m[i];
+				planes[2 * i + 1] = m[3] - m[i];
+			}
+			for(int i = 0; i < 6; i++){
+				float length = glm::length(glm::vec3(planes[i]));
+				if(length > 0.0f)
+					planes[i] /= length;
+			}
+
+			visible.clear();
+			for(unsigned int b = 0; b < models.size(); b++){
+				glm::vec4 center = models[b][3];
+				bool inside = true;
+				for(int i = 0; i < 6 and inside; i++)
+					inside = glm::dot(glm::vec3(planes[i]), glm::vec3(center)) + planes[i].w > -radius[b];
+				if(inside)
+					visible.push_back(b);
+			}
+		}//cull
+
+		// Monta o fluxo de matrizes dos corpos visíveis
+		void submit(){
+			stream.resize(visible.size());
+			for(unsigned int i = 0; i < visible.size(); i++)
+				stream[i] = models[visible[i]];
+		}//submit
+
+		/** Um passo com os três estágios medidos
+			* @param viewProj - Câmera do culling
+			*/
+		StageTimes step(const glm::mat4 &viewProj){
+			chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+			transforms();
+			chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+			cull(viewProj);
+			chrono::steady_clock::time_point t2 = chrono::steady_clock::now();
+			submit();
+			chrono::steady_clock::time_point t3 = chrono::steady_clock::now();
+
+			times.transforms = chrono::duration<double, milli>(t1 - t0).count();
+			times.cull = chrono::duration<double, milli>(t2 - t1).count();
+			times.submit = chrono::duration<double, milli>(t3 - t2).count();
+			return times;
+		}//step
+
+		// Câmera de cima, sobre um lado da cena: só parte dos corpos aparece
+		glm::mat4 overview(float aspect){
+			float r = max(outer(), 1e-3f);
+			glm::mat4 view = glm::lookAt(glm::vec3(0.7f * r, 1.2f * r, 0.0f), glm::vec3(0.7f * r, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+			glm::mat4 projection = glm::perspective(glm::radians(45.0f), aspect, 0.001f * r, 4.0f * r);
+			return projection * view;
+		}//overview
+};
+
+#endif
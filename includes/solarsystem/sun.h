@@ -14,23 +14,43 @@ class Sun {
 	protected:
 		string Name; 
 		float Scale;
+		float Real; // diâmetro real (km)
 
       
   public:
   	static float size; // size, para a escala do planeta
+  	static bool trueScale; // usa os tamanhos e distâncias reais
 
     Sun(string name, float scale){
       Name = name;
       Scale = scale;
+      Real = scale;
     }//Sun
 
+    // Liga ou desliga a escala real (1 unidade = 1 UA)
+    static void setTrueScale(bool value){
+      trueScale = value;
+      // o modelo da esfera tem raio 2.606874: diâmetro em km -> UA
+      size = trueScale ? 1.0f / (2.0f * 2.606874f * 149597870.7f) : 0.000001f;
+    }//setTrueScale
+
     glm::mat4 render(){
      	glm::mat4 matrix;
      	matrix = glm::translate(matrix, glm::vec3(0.0f, 0.0f, 0.0f));
-     	matrix = glm::scale(matrix, (Scale * size) * glm::vec3(1.0f, 1.0f, 1.0f));
+     	matrix = glm::scale(matrix, getSize() * glm::vec3(1.0f, 1.0f, 1.0f));
      	return matrix;
     }
 
+    // Diâmetro real, em km
+    void setReal(float diameter){
+     	Real = diameter;
+    }
+
+    // Escala usada para desenhar, na escala atual
+    float getSize(){
+     	return (trueScale ? Real : Scale) * size;
+    }
+
     string getName(){
      	return Name;
     }
@@ -40,6 +60,4 @@ class Sun {
     }
 };
 
-float Sun::size = 0.000001;
-
 #endif
\ No newline at end of file
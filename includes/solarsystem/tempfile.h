@@ -0,0 +1,42 @@
+#ifndef TEMPFILE_H
+#define TEMPFILE_H
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Arquivo gravado num temporário e depois posto no lugar do final: quem lê
+// nunca vê um arquivo pela metade. O temporário leva o processo e um número
+// por gravação, então duas threads ou dois programas gerando o mesmo cache
+// não escrevem no mesmo temporário; o último a terminar fica com o arquivo.
+class TempFile {
+	public:
+		// Nome do temporário de uma gravação de path
+		static string name(const string &path){
+			static atomic<unsigned int> counter(0);
+			return path + "." + to_string(getpid()) + "." + to_string(counter++) + ".tmp";
+		}//name
+
+		/** Põe o temporário no lugar do arquivo
+			* @return false se não conseguiu (o temporário continua lá)
+			*/
+		static bool commit(const string &temporary, const string &path){
+#ifdef _WIN32
+			// no Windows o rename não substitui um arquivo existente; entre o
+			// remove e o rename uma leitura não acha o arquivo e o refaz
+			remove(path.c_str());
+#endif
+			return rename(temporary.c_str(), path.c_str()) == 0;
+		}//commit
+};
+
+#endif
@@ -0,0 +1,716 @@
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/shader_m.h>
+
+#include "mipchain.h"
+#include "residency.h"
+#include "drawstats.h"
+#include "glstate.h"
+#include "uniforms.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Vértices por lado de um bloco
+#define TERRAIN_GRID 33
+
+// Nó da quadtree: uma das 6 faces do cubo, nível e posição no nível
+struct TerrainNode {
+	int face, level, x, y;
+
+	unsigned long long key() const{
+		return ((unsigned long long) face << 60) | ((unsigned long long) level << 52) |
+			   ((unsigned long long) x << 26) | (unsigned long long) y;
+	}//key
+
+	TerrainNode child(int i) const{
+		TerrainNode c = {face, level + 1, 2 * x + (i & 1), 2 * y + (i >> 1)};
+		return c;
+	}//child
+};
+
+// Mapa de altura do corpo: o nível de até heightSize pixels do mapa de cor,
+// lido uma vez pela primeira thread que precisar dele
+struct TerrainSource {
+	string file;
+	unsigned int generation;
+	once_flag once;
+	bool loaded;
+	MipInfo info;
+	int width, height;
+	vector<unsigned char> pixels;
+};
+
+// Bloco montado na thread: vértices (posição relativa à origem do bloco,
+// normal e coordenada de textura) prontos para o glBufferData
+struct TerrainBuild {
+	TerrainNode node;
+	unsigned int generation;
+	glm::vec3 origin;
+	vector<float> vertices;
+};
+
+// Bloco na GPU
+struct TerrainChunk {
+	unsigned int VAO, VBO;
+	glm::vec3 origin;
+	unsigned long lastUse;
+};
+
+// Terreno de quadtree sobre o cubo projetado na esfera, para ver um corpo
+// de perto no modo 3. Cada face do cubo é a raiz de uma quadtree; um nó é
+// dividido quando o espaçamento dos seus vértices, projetado na tela, passa
+// de pixelError pixels. A altura vem do mapa de cor do corpo (a luminância
+// de um mip de até 1024 px) mais um ruído fractal abaixo da resolução do
+// mapa. As bordas dos blocos têm saias voltadas para o centro, que cobrem
+// as frestas entre níveis diferentes.
+//
+// Os blocos são montados por threads e enviados na thread principal, no
+// máximo uploadLimit por frame; enquanto os filhos não chegam o pai é
+// desenhado. A cache guarda até capacity blocos (os mais antigos saem
+// primeiro) e no máximo maxChunks são desenhados por frame, então o custo
+// do frame fica parecido em órbita e junto da superfície.
+//
+// O modelo da esfera tem raio STRESS_SPHERE_RADIUS e centro em center; o
+// terreno usa o mesmo espaço e o mesmo mapeamento das coordenadas de
+// textura, então troca com a esfera sem mudar a imagem.
+class Terrain {
+	protected:
+		// Threads e filas: pending é pilha (o pedido mais novo é o da câmera atual)
+		vector<thread> workers;
+		mutex lock;
+		condition_variable wake;
+		deque<pair<TerrainNode, shared_ptr<TerrainSource> > > pending;
+		deque<TerrainBuild> done;
+		bool running;
+
+		// Thread principal
+		shared_ptr<TerrainSource> source;
+		set<unsigned long long> queued;        // pedidos ainda sem resposta
+		map<unsigned long long, TerrainChunk> cache;
+		vector<TerrainChunk> spare;            // buffers de blocos despejados, reaproveitados
+		vector<pair<TerrainNode, TerrainChunk*> > selected;
+		unsigned int EBO;
+		unsigned int indexCount;
+		unsigned long frameNumber;
+		unsigned int generation;
+		int body;
+
+		static const glm::vec3 center;
+
+	public:
+		static float radius;         // raio do modelo da esfera
+		static float pixelError;     // erro na tela que divide um nó (pixels)
+		static int maxLevel;         // nível mais fino
+		static unsigned int maxChunks;   // blocos desenhados por frame
+		static unsigned int capacity;    // blocos na cache
+		static unsigned int uploadLimit; // envios por frame
+		static unsigned int maxPending;  // pedidos na fila
+		static float relief;         // altura do mapa, em fração do raio
+		static float roughness;      // altura do ruído, em fração do raio
+		static int heightSize;       // lado maior do mip usado como mapa de altura
+		static bool synchronous;     // monta na hora (frames determinísticos)
+
+		unsigned int uploads;        // blocos enviados no último frame
+		unsigned int built;          // blocos enviados desde o setBody
+
+		Terrain(): running(false){
+			EBO = 0;
+			indexCount = 0;
+			frameNumber = 0;
+			generation = 0;
+			body = -1;
+			uploads = built = 0;
+		}//Terrain
+
+		~Terrain(){
+			stop();
+		}//~Terrain
+
+		/** Troca o corpo; os blocos do anterior são descartados
+			* @param index - Identificador do corpo (-1 = nenhum)
+			* @param file - Mapa de cor do corpo, também usado como mapa de altura
+			*/
+		void setBody(int index, const string &file){
+			if(index == body)
+				return;
+			clear();
+			body = index;
+			if(index < 0)
+				return;
+
+			source = make_shared<TerrainSource>();
+			source->file = file;
+			{
+				unique_lock<mutex> guard(lock);
+				source->generation = ++generation;
+			}
+			source->loaded = false;
+			source->width = source->height = 0;
+			if(not synchronous)
+				start();
+		}//setBody
+
+		int getBody(){
+			return body;
+		}//getBody
+
+		/** Escolhe os blocos do frame e envia os que as threads terminaram
+			* @param model - Matriz do corpo (a mesma do modelo da esfera)
+			* @param viewProj - Câmera
+			* @param cameraPos - Posição da câmera
+			* @param pixelsPerRadian - Altura da tela / (2 tan(fov / 2))
+			* @return false se as raízes ainda não chegaram (desenhe a esfera)
+			*/
+		bool update(const glm::mat4 &model, const glm::mat4 &viewProj, const glm::vec3 &cameraPos, float pixelsPerRadian){
+			TRACE_ZONE("Terrain::update");
+			frameNumber++;
+			selected.clear();
+			if(body < 0)
+				return false;
+			if(not EBO)
+				createIndices();
+
+			collect();
+
+			// Câmera e planos do frustum no espaço do modelo
+			glm::vec3 camera = glm::vec3(glm::inverse(model) * glm::vec4(cameraPos, 1.0f));
+			glm::vec4 planes[6];
+			frustum(viewProj * model, planes);
+
+			// Sem as 6 raízes não há o que desenhar
+			bool roots = true;
+			vector<TerrainNode> level;
+			for(int f = 0; f < 6; f++){
+				TerrainNode n = {f, 0, 0, 0};
+				level.push_back(n);
+				roots = get(n) != NULL and roots;
+			}
+			if(not roots){
+				trim();
+				return false;
+			}
+
+			// Em largura, do nível mais grosso ao mais fino, os mais próximos
+			// primeiro: quando o orçamento acaba os blocos longe ficam grossos
+			unsigned int total = 0;
+			vector<pair<float, TerrainNode> > nodes;
+			for(unsigned int i = 0; i < level.size(); i++)
+				if(visible(level[i], camera, planes))
+					total++;
+
+			while(not level.empty()){
+				nodes.clear();
+				for(unsigned int i = 0; i < level.size(); i++){
+					glm::vec3 c;
+					float r;
+					bounds(level[i], c, r);
+					if(visible(camera, planes, c, r))
+						nodes.push_back(make_pair(glm::length(c - camera) - r, level[i]));
+				}
+				sort(nodes.begin(), nodes.end(), [](const pair<float, TerrainNode> &a, const pair<float, TerrainNode> &b){ return a.first < b.first; });
+
+				vector<TerrainNode> next;
+				for(unsigned int i = 0; i < nodes.size(); i++){
+					TerrainNode &n = nodes[i].second;
+					float error = spacing(n.level) / max(nodes[i].first, 1e-6f) * pixelsPerRadian;
+					bool refine = n.level < maxLevel and error > pixelError and total + 3 <= maxChunks;
+
+					// Os quatro filhos prontos substituem o pai; senão são pedidos e o pai fica
+					bool ready = refine;
+					for(int k = 0; k < 4 and refine; k++)
+						ready = get(n.child(k)) != NULL and ready;
+					if(ready){
+						for(int k = 0; k < 4; k++)
+							next.push_back(n.child(k));
+						total += 3;
+					}
+					else
+						selected.push_back(make_pair(n, get(n)));
+				}
+				level.swap(next);
+			}
+
+			trim();
+			return true;
+		}//update
+
+		/** Desenha os blocos escolhidos no update
+			* @param objects - Anel do bloco "Object"
+			* @param texture - Mapa de cor do corpo
+			*/
+		void draw(Shader *shader, UniformRing *objects, const glm::mat4 &model, unsigned int texture){
+			TRACE_ZONE("Terrain::draw");
+			GLState::uniform1i(GLState::uniformLocation(shader->ID, "texture_diffuse1"), 0);
+			Residency::detail = 0.0f;
+			Residency::useTexture(texture);
+			GLState::bindTextureUnit(0, GL_TEXTURE_2D, texture);
+
+			ObjectData object;
+			for(unsigned int i = 0; i < selected.size(); i++){
+				TerrainChunk *chunk = selected[i].second;
+				object.model = glm::translate(model, chunk->origin);
+				objects->push(OBJECT_BINDING, &object, sizeof(ObjectData));
+				GLState::bindVertexArray(chunk->VAO);
+				glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+				DrawStats::add(indexCount / 3);
+			}
+		}//draw
+
+		// Blocos desenhados, na cache e na fila, para a tela
+		string status(){
+			char line[96];
+			snprintf(line, sizeof(line), "Terreno: %u blocos, %u na cache, %u na fila",
+					 (unsigned int) selected.size(), (unsigned int) cache.size(), (unsigned int) queued.size());
+			return line;
+		}//status
+
+		// Ainda há blocos a caminho (a imagem vai mudar sem a câmera mexer)
+		unsigned int busy(){
+			return queued.size();
+		}//busy
+
+		// Termina as threads e libera os blocos (com o contexto ainda ativo)
+		void clear(){
+			stop();
+			for(map<unsigned long long, TerrainChunk>::iterator it = cache.begin(); it != cache.end(); it++)
+				spare.push_back(it->second);
+			for(unsigned int i = 0; i < spare.size(); i++){
+				GLState::deleteVertexArray(spare[i].VAO);
+				glDeleteBuffers(1, &spare[i].VBO);
+			}
+			cache.clear();
+			spare.clear();
+			queued.clear();
+			selected.clear();
+			done.clear();
+			source.reset();
+			body = -1;
+			built = 0;
+		}//clear
+
+		/** Monta um bloco (sem OpenGL, em qualquer thread)
+			* @param source - Mapa de altura do corpo
+			*/
+		static TerrainBuild build(const TerrainNode &n, TerrainSource &source){
+			TRACE_ZONE("Terrain::build");
+			call_once(source.once, [&source]{ loadHeights(source); });
+
+			TerrainBuild b;
+			b.node = n;
+			b.generation = source.generation;
+			float s0, t0, step;
+			extent(n, s0, t0, step);
+			b.origin = center + radius * direction(n.face, s0 + 0.5f * step * (TERRAIN_GRID - 1), t0 + 0.5f * step * (TERRAIN_GRID - 1));
+
+			// Grade com uma amostra a mais em cada borda, para as normais
+			const int G = TERRAIN_GRID + 2;
+			vector<glm::vec3> position(G * G), normal(G * G);
+			vector<glm::vec2> uv(G * G);
+			glm::vec3 mid = direction(n.face, s0 + 0.5f * step * (TERRAIN_GRID - 1), t0 + 0.5f * step * (TERRAIN_GRID - 1));
+			float u0 = texCoords(mid).x;
+			for(int j = 0; j < G; j++)
+				for(int i = 0; i < G; i++){
+					glm::vec3 d = direction(n.face, s0 + (i - 1) * step, t0 + (j - 1) * step);
+					glm::vec2 t = texCoords(d);
+					// O bloco que cruza a costura do mapa continua do mesmo lado (GL_REPEAT)
+					t.x = u0 + (t.x - u0) - floor(t.x - u0 + 0.5f);
+					uv[j * G + i] = t;
+					position[j * G + i] = center + d * radius * (1.0f + height(source, d, t)) - b.origin;
+				}
+			for(int j = 1; j < G - 1; j++)
+				for(int i = 1; i < G - 1; i++){
+					glm::vec3 ds = position[j * G + i + 1] - position[j * G + i - 1];
+					glm::vec3 dt = position[(j + 1) * G + i] - position[(j - 1) * G + i];
+					glm::vec3 up = position[j * G + i] + b.origin - center;
+					glm::vec3 x = glm::cross(ds, dt);
+					normal[j * G + i] = glm::normalize(glm::dot(x, up) < 0.0f ? -x : x);
+				}
+
+			// Grade e saias (as bordas de novo, afundadas)
+			const int N = TERRAIN_GRID;
+			float skirt = 4.0f * spacing(n.level) + relief * radius;
+			b.vertices.reserve((N * N + 4 * N) * 8);
+			for(int j = 0; j < N; j++)
+				for(int i = 0; i < N; i++)
+					vertex(b, position, normal, uv, (j + 1) * G + i + 1, 0.0f);
+			for(int e = 0; e < 4; e++)
+				for(int k = 0; k < N; k++){
+					int i = e == 2 ? 0 : (e == 3 ? N - 1 : k);
+					int j = e == 0 ? 0 : (e == 1 ? N - 1 : k);
+					vertex(b, position, normal, uv, (j + 1) * G + i + 1, skirt);
+				}
+			return b;
+		}//build
+
+		// Espaçamento dos vértices de um nível (unidades do modelo)
+		static float spacing(int level){
+			return radius * 1.5708f / (1 << level) / (TERRAIN_GRID - 1);
+		}//spacing
+
+		/** Ponto da esfera de um ponto da face do cubo (cubo "esferificado",
+			* com células de área mais parecida que a da normalização simples)
+			* @param s, t - Coordenadas na face, em [-1, 1]
+			*/
+		static glm::vec3 direction(int face, float s, float t){
+			static const glm::vec3 axes[6][3] = {
+				{glm::vec3( 1, 0, 0), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0)},
+				{glm::vec3(-1, 0, 0), glm::vec3(0, 0,  1), glm::vec3(0, 1, 0)},
+				{glm::vec3(0,  1, 0), glm::vec3(1, 0,  0), glm::vec3(0, 0, -1)},
+				{glm::vec3(0, -1, 0), glm::vec3(1, 0,  0), glm::vec3(0, 0,  1)},
+				{glm::vec3(0, 0,  1), glm::vec3(1, 0,  0), glm::vec3(0, 1, 0)},
+				{glm::vec3(0, 0, -1), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0)}
+			};
+			glm::vec3 p = axes[face][0] + s * axes[face][1] + t * axes[face][2];
+			glm::vec3 q = p * p;
+			return glm::vec3(p.x * sqrt(max(0.0f, 1.0f - q.y / 2.0f - q.z / 2.0f + q.y * q.z / 3.0f)),
+							 p.y * sqrt(max(0.0f, 1.0f - q.z / 2.0f - q.x / 2.0f + q.z * q.x / 3.0f)),
+							 p.z * sqrt(max(0.0f, 1.0f - q.x / 2.0f - q.y / 2.0f + q.x * q.y / 3.0f)));
+		}//direction
+
+		// Coordenada de textura do modelo da esfera: os polos ficam no eixo z
+		static glm::vec2 texCoords(const glm::vec3 &d){
+			float u = atan2(d.x, -d.y) / 6.2831853f;
+			return glm::vec2(u - floor(u), acos(glm::clamp(-d.z, -1.0f, 1.0f)) / 3.1415927f);
+		}//texCoords
+
+	protected:
+		void start(){
+			if(running)
+				return;
+			running = true;
+			unsigned int n = max(1u, min(2u, thread::hardware_concurrency() / 2));
+			for(unsigned int i = 0; i < n; i++)
+				workers.push_back(thread(&Terrain::work, this));
+		}//start
+
+		void stop(){
+			{
+				unique_lock<mutex> guard(lock);
+				running = false;
+				pending.clear();
+			}
+			wake.notify_all();
+			for(unsigned int i = 0; i < workers.size(); i++)
+				workers[i].join();
+			workers.clear();
+		}//stop
+
+		void work(){
+			TRACE_THREAD("terrain");
+			unique_lock<mutex> guard(lock);
+			while(true){
+				wake.wait(guard, [this]{ return not pending.empty() or not running; });
+				if(not running)
+					return;
+
+				pair<TerrainNode, shared_ptr<TerrainSource> > job = pending.back();
+				pending.pop_back();
+				guard.unlock();
+				TerrainBuild b = build(job.first, *job.second);
+				guard.lock();
+				// Blocos de um corpo anterior são descartados
+				if(b.generation == generation){
+					done.push_back(TerrainBuild());
+					done.back().vertices.swap(b.vertices);
+					done.back().node = b.node;
+					done.back().origin = b.origin;
+					done.back().generation = b.generation;
+				}
+			}
+		}//work
+
+		// O bloco, se estiver na GPU; senão pede (ou monta na hora, se síncrono)
+		TerrainChunk *get(const TerrainNode &n){
+			map<unsigned long long, TerrainChunk>::iterator it = cache.find(n.key());
+			if(it != cache.end()){
+				it->second.lastUse = frameNumber;
+				return &it->second;
+			}
+
+			if(synchronous){
+				TerrainBuild b = build(n, *source);
+				return upload(b);
+			}
+			if(queued.count(n.key()))
+				return NULL;
+
+			unique_lock<mutex> guard(lock);
+			// Fila cheia: os pedidos mais antigos provavelmente já saíram da tela
+			while(pending.size() >= maxPending){
+				queued.erase(pending.front().first.key());
+				pending.pop_front();
+			}
+			pending.push_back(make_pair(n, source));
+			queued.insert(n.key());
+			wake.notify_one();
+			return NULL;
+		}//get
+
+		// Envia até uploadLimit blocos prontos
+		void collect(){
+			uploads = 0;
+			while(uploads < uploadLimit){
+				TerrainBuild b;
+				{
+					unique_lock<mutex> guard(lock);
+					if(done.empty())
+						return;
+					b.vertices.swap(done.front().vertices);
+					b.node = done.front().node;
+					b.origin = done.front().origin;
+					done.pop_front();
+				}
+				queued.erase(b.node.key());
+				upload(b);
+			}
+		}//collect
+
+		TerrainChunk *upload(TerrainBuild &b){
+			TRACE_ZONE("Terrain::upload");
+			TerrainChunk chunk;
+			GLsizeiptr bytes = b.vertices.size() * sizeof(float);
+			if(not spare.empty()){
+				// Todos os blocos têm o mesmo tamanho: o buffer é reescrito
+				chunk = spare.back();
+				spare.pop_back();
+				glBindBuffer(GL_ARRAY_BUFFER, chunk.VBO);
+				glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, &b.vertices[0]);
+			}
+			else{
+				glGenVertexArrays(1, &chunk.VAO);
+				glGenBuffers(1, &chunk.VBO);
+				GLState::bindVertexArray(chunk.VAO);
+				glBindBuffer(GL_ARRAY_BUFFER, chunk.VBO);
+				glBufferData(GL_ARRAY_BUFFER, bytes, &b.vertices[0], GL_STATIC_DRAW);
+				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+				glEnableVertexAttribArray(0);
+				glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) 0);
+				glEnableVertexAttribArray(1);
+				glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) (3 * sizeof(float)));
+				glEnableVertexAttribArray(2);
+				glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*) (6 * sizeof(float)));
+				GLState::bindVertexArray(0);
+			}
+			chunk.origin = b.origin;
+			chunk.lastUse = frameNumber;
+			uploads++;
+			built++;
+			return &(cache[b.node.key()] = chunk);
+		}//upload
+
+		// Despeja da cache os blocos mais antigos que não foram usados neste frame
+		void trim(){
+			if(cache.size() <= capacity)
+				return;
+			vector<pair<unsigned long, unsigned long long> > old;
+			for(map<unsigned long long, TerrainChunk>::iterator it = cache.begin(); it != cache.end(); it++)
+				if(it->second.lastUse != frameNumber)
+					old.push_back(make_pair(it->second.lastUse, it->first));
+			sort(old.begin(), old.end());
+			for(unsigned int i = 0; i < old.size() and cache.size() > capacity; i++){
+				spare.push_back(cache[old[i].second]);
+				cache.erase(old[i].second);
+			}
+		}//trim
+
+		// Índices da grade e das saias, os mesmos para todos os blocos
+		void createIndices(){
+			const int N = TERRAIN_GRID;
+			vector<unsigned int> indices;
+			for(int j = 0; j + 1 < N; j++)
+				for(int i = 0; i + 1 < N; i++){
+					unsigned int a = j * N + i, b = a + 1, c = a + N, d = c + 1;
+					indices.push_back(a); indices.push_back(b); indices.push_back(d);
+					indices.push_back(a); indices.push_back(d); indices.push_back(c);
+				}
+			for(int e = 0; e < 4; e++)
+				for(int k = 0; k + 1 < N; k++){
+					int i0 = e == 2 ? 0 : (e == 3 ? N - 1 : k), j0 = e == 0 ? 0 : (e == 1 ? N - 1 : k);
+					int i1 = e == 2 ? 0 : (e == 3 ? N - 1 : k + 1), j1 = e == 0 ? 0 : (e == 1 ? N - 1 : k + 1);
+					unsigned int a = j0 * N + i0, b = j1 * N + i1;
+					unsigned int c = N * N + e * N + k, d = c + 1;
+					indices.push_back(a); indices.push_back(b); indices.push_back(d);
+					indices.push_back(a); indices.push_back(d); indices.push_back(c);
+				}
+			indexCount = indices.size();
+			// Sem VAO ligado: a ligação do GL_ELEMENT_ARRAY_BUFFER iria para o último desenhado
+			GLState::bindVertexArray(0);
+			glGenBuffers(1, &EBO);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+		}//createIndices
+
+		// Canto e passo de um nó nas coordenadas da face
+		static void extent(const TerrainNode &n, float &s0, float &t0, float &step){
+			float size = 2.0f / (1 << n.level);
+			s0 = -1.0f + n.x * size;
+			t0 = -1.0f + n.y * size;
+			step = size / (TERRAIN_GRID - 1);
+		}//extent
+
+		// Esfera envolvente de um nó: centro na superfície e os cantos com a altura máxima
+		static void bounds(const TerrainNode &n, glm::vec3 &c, float &r){
+			float s0, t0, step;
+			extent(n, s0, t0, step);
+			float size = step * (TERRAIN_GRID - 1);
+			c = center + radius * direction(n.face, s0 + 0.5f * size, t0 + 0.5f * size);
+			r = 0.0f;
+			for(int k = 0; k < 4; k++){
+				glm::vec3 corner = center + radius * direction(n.face, s0 + (k & 1) * size, t0 + (k >> 1) * size);
+				r = max(r, glm::length(corner - c));
+			}
+			r += (relief + roughness) * radius;
+		}//bounds
+
+		bool visible(const TerrainNode &n, const glm::vec3 &camera, const glm::vec4 *planes){
+			glm::vec3 c;
+			float r;
+			bounds(n, c, r);
+			return visible(camera, planes, c, r);
+		}//visible
+
+		// Esfera (c, r) dentro do frustum e na frente do horizonte
+		bool visible(const glm::vec3 &camera, const glm::vec4 *planes, const glm::vec3 &c, float r){
+			for(int i = 0; i < 6; i++)
+				if(glm::dot(glm::vec3(planes[i]), c) + planes[i].w < -r)
+					return false;
+
+			// Atrás do plano do horizonte visto da câmera
+			glm::vec3 toCamera = camera - center;
+			float distance = glm::length(toCamera);
+			if(distance <= radius)
+				return true;
+			return glm::dot(c - center, toCamera / distance) + r >= radius * radius / distance;
+		}//visible
+
+		// Planos do frustum (Gribb e Hartmann) no espaço do modelo, normalizados
+		static void frustum(const glm::mat4 &m, glm::vec4 *planes){
+			glm::mat4 t = glm::transpose(m);
+			for(int i = 0; i < 3; i++){
+				planes[2 * i]     = t[3] + t[i];
+				planes[2 * i + 1] = t[3] - t[i];
+			}
+			for(int i = 0; i < 6; i++){
+				float length = glm::length(glm::vec3(planes[i]));
+				if(length > 0.0f)
+					planes[i] /= length;
+			}
+		}//frustum
+
+		static void vertex(TerrainBuild &b, const vector<glm::vec3> &position, const vector<glm::vec3> &normal,
+						   const vector<glm::vec2> &uv, int k, float depth){
+			glm::vec3 p = position[k] - depth * glm::normalize(position[k] + b.origin - center);
+			b.vertices.push_back(p.x);
+			b.vertices.push_back(p.y);
+			b.vertices.push_back(p.z);
+			b.vertices.push_back(normal[k].x);
+			b.vertices.push_back(normal[k].y);
+			b.vertices.push_back(normal[k].z);
+			b.vertices.push_back(uv[k].x);
+			b.vertices.push_back(uv[k].y);
+		}//vertex
+
+		// Lê o mip do mapa usado como altura; sem ele só o ruído dá relevo
+		static void loadHeights(TerrainSource &source){
+			TRACE_ZONE("Terrain::loadHeights");
+			vector<vector<unsigned char> > levels;
+			MipInfo info;
+			if(not MipChain::info(source.file, info))
+				return;
+			int level = MipChain::levelFor(info, heightSize);
+			if(not MipChain::read(source.file, level, source.info, levels) or levels.empty())
+				return;
+			source.width = max(1, info.width >> level);
+			source.height = max(1, info.height >> level);
+			source.pixels.swap(levels[0]);
+			source.loaded = true;
+		}//loadHeights
+
+		// Altura em fração do raio: luminância do mapa (interpolada) e ruído
+		static float height(const TerrainSource &source, const glm::vec3 &d, const glm::vec2 &uv){
+			float h = roughness * fractal(d * 64.0f);
+			if(not source.loaded)
+				return h;
+
+			float x = (uv.x - floor(uv.x)) * source.width - 0.5f, y = glm::clamp(uv.y * source.height - 0.5f, 0.0f, source.height - 1.0f);
+			int x0 = (int) floor(x), y0 = (int) y;
+			float fx = x - x0, fy = y - y0;
+			int x1 = (x0 + 1 + source.width) % source.width, y1 = min(y0 + 1, source.height - 1);
+			x0 = (x0 + source.width) % source.width;
+			float a = luminance(source, x0, y0) + fx * (luminance(source, x1, y0) - luminance(source, x0, y0));
+			float b = luminance(source, x0, y1) + fx * (luminance(source, x1, y1) - luminance(source, x0, y1));
+			return h + relief * (a + fy * (b - a));
+		}//height
+
+		static float luminance(const TerrainSource &source, int x, int y){
+			const unsigned char *p = &source.pixels[(y * source.width + x) * source.info.components];
+			if(source.info.components < 3)
+				return p[0] / 255.0f;
+			return (0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2]) / 255.0f;
+		}//luminance
+
+		// Ruído de valor em 3D, 6 oitavas, em [0, 1]
+		static float fractal(glm::vec3 p){
+			float sum = 0.0f, amplitude = 0.5f;
+			for(int i = 0; i < 6; i++){
+				sum += amplitude * noise(p);
+				p *= 2.03f;
+				amplitude *= 0.5f;
+			}
+			return sum;
+		}//fractal
+
+		static float noise(const glm::vec3 &p){
+			glm::vec3 i = glm::floor(p), f = p - i;
+			glm::vec3 w = f * f * (3.0f - 2.0f * f);
+			int x = (int) i.x, y = (int) i.y, z = (int) i.z;
+			float c[8];
+			for(int k = 0; k < 8; k++)
+				c[k] = lattice(x + (k & 1), y + ((k >> 1) & 1), z + (k >> 2));
+			float x00 = c[0] + w.x * (c[1] - c[0]), x10 = c[2] + w.x * (c[3] - c[2]);
+			float x01 = c[4] + w.x * (c[5] - c[4]), x11 = c[6] + w.x * (c[7] - c[6]);
+			float y0 = x00 + w.y * (x10 - x00), y1 = x01 + w.y * (x11 - x01);
+			return y0 + w.z * (y1 - y0);
+		}//noise
+
+		static float lattice(int x, int y, int z){
+			unsigned int h = (unsigned int) x * 374761393u + (unsigned int) y * 668265263u + (unsigned int) z * 2147483647u;
+			h = (h ^ (h >> 13)) * 1274126177u;
+			return ((h ^ (h >> 16)) & 0xffff) / 65535.0f;
+		}//lattice
+};
+
+const glm::vec3 Terrain::center = glm::vec3(0.0f, 1.048727f, 0.0f);
+float Terrain::radius = 2.606874f;
+float Terrain::pixelError = 6.0f;
+int Terrain::maxLevel = 12;
+unsigned int Terrain::maxChunks = 160;
+unsigned int Terrain::capacity = 512;
+unsigned int Terrain::uploadLimit = 4;
+unsigned int Terrain::maxPending = 64;
+float Terrain::relief = 0.004f;
+float Terrain::roughness = 0.0015f;
+int Terrain::heightSize = 1024;
+bool Terrain::synchronous = false;
+
+#endif
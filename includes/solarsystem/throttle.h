@@ -0,0 +1,166 @@
+#ifndef THROTTLE_H
+#define THROTTLE_H
+
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "log.h"
+
+using namespace std;
+
+// Controle do ritmo da janela. Sob demanda, um frame só é desenhado quando o
+// hash do estado da cena (relógio, câmera, modos) muda ou quando a janela
+// pede (exposição, resize); nos outros o laço fica bloqueado esperando
+// eventos. O limite de frames dorme até o próximo frame em vez de girar no
+// vsync: sleep_for até perto do prazo, sonos curtos e yield no último
+// trecho, que o sleep_for sozinho costuma passar do ponto. O uso de CPU
+// (todas as threads, em % de um núcleo) e de GPU (soma dos passos do
+// Profiler) é mostrado a cada intervalo e no fim, nos dois modos.
+class FrameThrottle {
+	protected:
+		unsigned long long last; // hash do último frame desenhado
+		bool dirty;              // a janela pediu um redesenho
+		chrono::steady_clock::time_point deadline; // próximo frame com limite
+
+		// Intervalo do relatório
+		chrono::steady_clock::time_point since;
+		clock_t cpuSince;
+		double gpuSince;
+		unsigned long drawn, skipped;
+
+		// Desde o início, para o relatório final
+		chrono::steady_clock::time_point start;
+		clock_t cpuStart;
+		unsigned long drawnTotal, skippedTotal;
+
+	public:
+		bool onDemand;     // só desenha quando a cena muda
+		float maxFps;      // limite de frames (0 = sem limite)
+		float idleWait;    // espera máxima por eventos com a cena parada (s)
+		float reportEvery; // intervalo do relatório (s, 0 = só no fim)
+
+		FrameThrottle(){
+			last = 0;
+			dirty = true;
+			onDemand = false;
+			maxFps = 0.0f;
+			idleWait = 0.25f;
+			reportEvery = 10.0f;
+			drawn = skipped = drawnTotal = skippedTotal = 0;
+			gpuSince = 0.0;
+			since = start = deadline = chrono::steady_clock::now();
+			cpuSince = cpuStart = clock();
+		}//FrameThrottle
+
+		/** Acrescenta um valor ao hash (FNV-1a)
+			* @param h - Hash acumulado (começa em FNV_OFFSET)
+			* @param data - Bytes do valor
+			* @param size - Tamanho
+			*/
+		static void hash(unsigned long long &h, const void *data, size_t size){
+			const unsigned char *bytes = (const unsigned char*) data;
+			for(size_t i = 0; i < size; i++){
+				h ^= bytes[i];
+				h *= 1099511628211ULL;
+			}
+		}//hash
+
+		static unsigned long long seed(){
+			return 14695981039346656037ULL;
+		}//seed
+
+		// A janela precisa ser redesenhada mesmo sem mudança na cena
+		void invalidate(){
+			dirty = true;
+		}//invalidate
+
+		/** Decide se o frame pode ser pulado
+			* @param state - Hash do estado da cena depois da entrada
+			* @return true quando nada mudou desde o último frame desenhado
+			*/
+		bool idle(unsigned long long state){
+			if(not onDemand or dirty or state != last){
+				last = state;
+				dirty = false;
+				return false;
+			}
+			skipped++;
+			skippedTotal++;
+			return true;
+		}//idle
+
+		// Conta um frame desenhado e, com limite, dorme até o próximo
+		void frame(){
+			drawn++;
+			drawnTotal++;
+			if(maxFps <= 0.0f)
+				return;
+
+			chrono::steady_clock::duration period = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(1.0 / maxFps));
+			deadline += period;
+
+			// Atrasado mais de um frame: recomeça a contar daqui
+			chrono::steady_clock::time_point now = chrono::steady_clock::now();
+			if(deadline + period < now){
+				deadline = now;
+				return;
+			}
+			sleepUntil(deadline);
+		}//frame
+
+		/** Mostra o uso de CPU e GPU do intervalo, quando ele terminar
+			* @param gpuBusy - Profiler::gpuBusy
+			*/
+		void report(double gpuBusy){
+			double seconds = chrono::duration<double>(chrono::steady_clock::now() - since).count();
+			if(reportEvery <= 0.0f or seconds < reportEvery)
+				return;
+
+			double cpu = (double) (clock() - cpuSince) / CLOCKS_PER_SEC;
+			ostringstream x;
+			x << mode() << ": " << drawn / seconds << " frames/s desenhados, " << skipped << " pulados, CPU "
+			  << 100.0 * cpu / seconds << "%, GPU " << 0.1 * (gpuBusy - gpuSince) / seconds << "%";
+			Log::print(x.str());
+
+			since = chrono::steady_clock::now();
+			cpuSince = clock();
+			gpuSince = gpuBusy;
+			drawn = skipped = 0;
+		}//report
+
+		// Relatório da sessão inteira
+		void summary(double gpuBusy){
+			double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			double cpu = (double) (clock() - cpuStart) / CLOCKS_PER_SEC;
+			if(seconds <= 0.0)
+				return;
+			cout << mode() << ", " << seconds << " s: " << drawnTotal << " frames desenhados, " << skippedTotal
+				 << " pulados, CPU " << 100.0 * cpu / seconds << "%, GPU " << 0.1 * gpuBusy / seconds << "%" << endl;
+		}//summary
+
+		// Dorme até o prazo: sleep_for até 1 ms antes, passos de 100 us até
+		// faltar 200 us e yield no fim
+		static void sleepUntil(chrono::steady_clock::time_point when){
+			chrono::steady_clock::time_point now = chrono::steady_clock::now();
+			if(when - now > chrono::milliseconds(1))
+				this_thread::sleep_for(when - now - chrono::milliseconds(1));
+			while(when - chrono::steady_clock::now() > chrono::microseconds(200))
+				this_thread::sleep_for(chrono::microseconds(100));
+			while(chrono::steady_clock::now() < when)
+				this_thread::yield();
+		}//sleepUntil
+
+	protected:
+		string mode(){
+			string x = onDemand ? "sob demanda" : "contínuo";
+			if(maxFps > 0.0f)
+				x += ", limite de " + to_string((int) maxFps) + " frames/s";
+			return x;
+		}//mode
+};
+
+#endif
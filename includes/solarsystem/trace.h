@@ -0,0 +1,196 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Zonas de CPU gravadas no formato Trace Event (JSON) do Chrome, que abre em
+// chrome://tracing e no ui.perfetto.dev. Só existe quando compilado com a
+// opção SOLAR_TRACE do CMake; sem ela as macros não geram código.
+//
+//   TRACE_ZONE("nome");            zona até o fim do escopo
+//   TRACE_COUNTER("nome", valor);  contador
+//   TRACE_THREAD("nome");          nome da thread atual
+//   TRACE_SAVE("arquivo.json");    grava tudo que foi registrado
+
+#ifdef SOLAR_TRACE
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Eventos guardados por thread (~10 MB); depois disso os mais antigos são
+// sobrescritos e contados como descartados
+#ifndef TRACE_EVENTS
+#define TRACE_EVENTS (1 << 18)
+#endif
+
+// Evento guardado na memória até o TRACE_SAVE
+struct TraceEvent {
+	const char *name;  // sempre uma string literal
+	char phase;        // 'X' zona, 'C' contador
+	long long start;   // ns desde o início do programa
+	long long duration;
+	double value;
+};
+
+// Eventos de uma thread. Cada thread escreve só no seu buffer; a trava só
+// disputa com o save, que copia os eventos enquanto as threads de carga, do
+// terreno e das texturas virtuais ainda podem estar gravando.
+struct TraceBuffer {
+	unsigned int tid;
+	string name;
+	vector<TraceEvent> events;  // anel de TRACE_EVENTS
+	unsigned int next;          // posição do próximo evento quando o anel está cheio
+	unsigned long dropped;      // eventos sobrescritos
+	mutex lock;
+};
+
+class Trace {
+	public:
+		// Nanosegundos desde a primeira chamada
+		static long long now(){
+			static chrono::steady_clock::time_point origin = chrono::steady_clock::now();
+			return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - origin).count();
+		}//now
+
+		static void zone(const char *name, long long start, long long duration){
+			TraceEvent event = {name, 'X', start, duration, 0.0};
+			append(event);
+		}//zone
+
+		static void counter(const char *name, double value){
+			TraceEvent event = {name, 'C', now(), 0, value};
+			append(event);
+		}//counter
+
+		static void thread(const char *name){
+			TraceBuffer &b = buffer();
+			lock_guard<mutex> guard(b.lock);
+			b.name = name;
+		}//thread
+
+		// Grava todos os buffers num arquivo JSON
+		static void save(const char *path){
+			lock_guard<mutex> lock(registry());
+			ofstream file(path);
+			file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << endl;
+
+			bool first = true;
+			unsigned long dropped = 0;
+			vector<TraceBuffer*> &buffers = all();
+			for(unsigned int i = 0; i < buffers.size(); i++){
+				TraceBuffer *b = buffers[i];
+				string name;
+				vector<TraceEvent> events;
+				{
+					lock_guard<mutex> guard(b->lock);
+					name = b->name;
+					// do mais antigo ao mais novo
+					events.assign(b->events.begin() + b->next, b->events.end());
+					events.insert(events.end(), b->events.begin(), b->events.begin() + b->next);
+					dropped += b->dropped;
+				}
+				if(not name.empty()){
+					file << (first ? "" : ",\n") << "{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": " << b->tid
+						 << ", \"args\": {\"name\": \"" << name << "\"}}";
+					first = false;
+				}
+
+				for(unsigned int j = 0; j < events.size(); j++){
+					TraceEvent &e = events[j];
+					file << (first ? "" : ",\n");
+					first = false;
+
+					// o formato usa microssegundos
+					file << "{\"ph\": \"" << e.phase << "\", \"name\": \"" << e.name << "\", \"pid\": 1, \"tid\": " << b->tid
+						 << ", \"ts\": " << e.start / 1000.0;
+					if(e.phase == 'X')
+						file << ", \"dur\": " << e.duration / 1000.0 << "}";
+					else
+						file << ", \"args\": {\"value\": " << e.value << "}}";
+				}
+			}
+
+			file << "\n], \"otherData\": {\"dropped_events\": " << dropped << "}}" << endl;
+			if(dropped)
+				cout << "Trace: " << dropped << " eventos antigos descartados (" << TRACE_EVENTS << " por thread)" << endl;
+		}//save
+
+	private:
+		static void append(const TraceEvent &event){
+			TraceBuffer &b = buffer();
+			lock_guard<mutex> guard(b.lock);
+			if(b.events.size() < TRACE_EVENTS){
+				b.events.push_back(event);
+				return;
+			}
+			b.events[b.next] = event;
+			b.next = (b.next + 1) % TRACE_EVENTS;
+			b.dropped++;
+		}//append
+
+		static mutex &registry(){
+			static mutex m;
+			return m;
+		}//registry
+
+		static vector<TraceBuffer*> &all(){
+			static vector<TraceBuffer*> buffers;
+			return buffers;
+		}//all
+
+		// Buffer da thread atual, registrado no primeiro uso
+		static TraceBuffer &buffer(){
+			thread_local TraceBuffer *local = NULL;
+			if(local == NULL){
+				local = new TraceBuffer();
+				local->events.reserve(1 << 16);
+				local->next = 0;
+				local->dropped = 0;
+				lock_guard<mutex> lock(registry());
+				local->tid = all().size() + 1;
+				all().push_back(local);
+			}
+			return *local;
+		}//buffer
+};
+
+// Zona que dura até o fim do escopo
+class TraceZone {
+	protected:
+		const char *name;
+		long long start;
+
+	public:
+		TraceZone(const char *zone){
+			name = zone;
+			start = Trace::now();
+		}
+
+		~TraceZone(){
+			Trace::zone(name, start, Trace::now() - start);
+		}
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#define TRACE_ZONE(name)           TraceZone TRACE_CONCAT(trace_zone_, __LINE__)(name)
+#define TRACE_COUNTER(name, value) Trace::counter(name, value)
+#define TRACE_THREAD(name)         Trace::thread(name)
+#define TRACE_SAVE(path)           Trace::save(path)
+
+#else
+
+#define TRACE_ZONE(name)
+#define TRACE_COUNTER(name, value)
+#define TRACE_THREAD(name)
+#define TRACE_SAVE(path)
+
+#endif
+
+#endif
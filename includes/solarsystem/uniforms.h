@@ -0,0 +1,183 @@
+#ifndef UNIFORMS_H
+#define UNIFORMS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader_m.h>
+
+#include "glcaps.h"
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// Pontos de ligação dos blocos de uniforms, iguais em todos os shaders
+#define FRAME_BINDING  0
+#define OBJECT_BINDING 1
+
+// Bloco "Frame" (std140), o mesmo para todos os shaders
+struct FrameData {
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 viewProj;
+	glm::vec4 cameraPos;
+	glm::vec4 time; // x = tempo do mundo, y = deltaTime, z = tempo real
+};
+
+// Bloco "Object" (std140), um por desenho
+struct ObjectData {
+	glm::mat4 model;
+};
+
+// Anel de uniform buffers dividido em regiões, uma por frame em andamento.
+// Cada região é protegida por um fence: a CPU só escreve numa região depois
+// que a GPU terminou o frame que a usou. Com glBufferStorage o buffer fica
+// mapeado o tempo todo (persistente e coerente); sem ele cada escrita vira
+// um glBufferSubData na região livre.
+class UniformRing {
+	protected:
+		unsigned int UBO;
+		GLsizeiptr regionSize;   // bytes por frame
+		int frames;              // quantidade de regiões
+		int region;              // região do frame atual
+		GLintptr offset;         // próxima escrita dentro da região
+		GLint alignment;         // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+		char *mapped;            // ponteiro persistente (ou NULL)
+		vector<GLsync> fences;
+
+	public:
+		static bool persistent;    // o driver tem glBufferStorage
+		unsigned int stalls;       // vezes que a CPU esperou a GPU
+		unsigned int grows;        // vezes que o anel precisou crescer
+
+		// Verifica o suporte a mapeamento persistente, depois do glad
+		static void init(GLADloadproc load){
+			persistent = GLCaps::require(GLAD_GL_VERSION_4_4, "GL_ARB_buffer_storage", glad_glBufferStorage, load, "glBufferStorage");
+		}//init
+
+		/** Construtor do anel
+			* @param size - Bytes usados por frame
+			* @param count - Frames em andamento (triple buffering = 3)
+			*/
+		UniformRing(GLsizeiptr size, int count = 3){
+			glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+			frames = count;
+			region = 0;
+			offset = 0;
+			stalls = 0;
+			grows = 0;
+			UBO = 0;
+			mapped = NULL;
+			allocate(align(size));
+		}//UniformRing
+
+		// Começa um frame: espera a GPU liberar a região que vai ser reescrita
+		void begin(){
+			GLsync fence = fences[region];
+			if(fence){
+				GLenum status = glClientWaitSync(fence, 0, 0);
+				if(status == GL_TIMEOUT_EXPIRED){
+					stalls++;
+					while(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+				}
+				glDeleteSync(fence);
+				fences[region] = 0;
+			}
+			offset = 0;
+		}//begin
+
+		/** Escreve um bloco na região do frame e liga no ponto de ligação
+			* @param binding - Ponto de ligação (FRAME_BINDING, OBJECT_BINDING)
+			* @param data - Dados no layout std140
+			* @param size - Tamanho dos dados
+			*/
+		void push(GLuint binding, const void *data, GLsizeiptr size){
+			GLsizeiptr aligned = align(size);
+			if(offset + aligned > regionSize)
+				grow(regionSize * 2 > aligned ? regionSize * 2 : aligned * 2);
+
+			GLintptr position = region * regionSize + offset;
+			if(mapped)
+				memcpy(mapped + position, data, size);
+			else{
+				glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+				glBufferSubData(GL_UNIFORM_BUFFER, position, size, data);
+			}
+
+			glBindBufferRange(GL_UNIFORM_BUFFER, binding, UBO, position, size);
+			offset += aligned;
+		}//push
+
+		// Termina o frame: marca a região com um fence e passa para a próxima
+		void end(){
+			fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			region = (region + 1) % frames;
+		}//end
+
+		// Bytes usados no frame atual
+		GLintptr used(){
+			return offset;
+		}//used
+
+		// Liga os blocos "Frame" e "Object" de um shader aos pontos fixos
+		static void attach(Shader *shader){
+			unsigned int frame = glGetUniformBlockIndex(shader->ID, "Frame");
+			if(frame != GL_INVALID_INDEX)
+				glUniformBlockBinding(shader->ID, frame, FRAME_BINDING);
+
+			unsigned int object = glGetUniformBlockIndex(shader->ID, "Object");
+			if(object != GL_INVALID_INDEX)
+				glUniformBlockBinding(shader->ID, object, OBJECT_BINDING);
+		}//attach
+
+	private:
+		GLsizeiptr align(GLsizeiptr size){
+			return ((size + alignment - 1) / alignment) * alignment;
+		}//align
+
+		// Cria o buffer com todas as regiões
+		void allocate(GLsizeiptr size){
+			regionSize = size;
+			fences.assign(frames, (GLsync) 0);
+
+			glGenBuffers(1, &UBO);
+			glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+			if(persistent){
+				GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+				glBufferStorage(GL_UNIFORM_BUFFER, regionSize * frames, NULL, flags);
+				mapped = (char*) glMapBufferRange(GL_UNIFORM_BUFFER, 0, regionSize * frames, flags);
+			}
+			else
+				glBufferData(GL_UNIFORM_BUFFER, regionSize * frames, NULL, GL_STREAM_DRAW);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		}//allocate
+
+		// Troca por um buffer maior no meio do frame. Os desenhos já enviados
+		// continuam lendo o buffer antigo, que o driver só libera no fim deles.
+		void grow(GLsizeiptr size){
+			for(int i = 0; i < frames; i++)
+				if(fences[i])
+					glDeleteSync(fences[i]);
+
+			if(mapped){
+				glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+				glUnmapBuffer(GL_UNIFORM_BUFFER);
+				glBindBuffer(GL_UNIFORM_BUFFER, 0);
+				mapped = NULL;
+			}
+			glDeleteBuffers(1, &UBO);
+
+			allocate(align(size));
+			region = 0;
+			offset = 0;
+			grows++;
+		}//grow
+};
+
+bool UniformRing::persistent = false;
+
+#endif
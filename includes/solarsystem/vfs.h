@@ -0,0 +1,205 @@
+#ifndef VFS_H
+#define VFS_H
+
+#include <stb_image.h>
+#include "pack.h"
+
+#include <atomic>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Arquivos lidos pelo visualizador (modelos, materiais, texturas e shaders):
+// com um pacote montado (--pack) os caminhos dentro dele vêm do mapeamento, os
+// outros continuam vindo do disco. O caminho pedido é o de sempre
+// (FileSystem::getPath); a chave no pacote é ele sem a raiz do projeto. O
+// pacote só é trocado antes das threads começarem, então ler é seguro em
+// qualquer thread.
+class Vfs {
+	protected:
+		static Pack pack;
+		static string root;  // normalizada, com '/' no final (ou vazia)
+
+	public:
+		static atomic<unsigned long> packReads, looseReads;
+		static atomic<unsigned long long> packBytes, looseBytes;
+
+		/** Monta um pacote
+			* @param file - Pacote gerado pelo SolarPack
+			* @param base - Raiz do projeto (FileSystem::getPath("")): as chaves são relativas a ela
+			*/
+		static bool mount(const string &file, const string &base){
+			root = normalize(base);
+			if(not root.empty() and root[root.size() - 1] != '/')
+				root += '/';
+			return pack.open(file);
+		}//mount
+
+		static void unmount(){
+			pack.close();
+		}//unmount
+
+		static bool mounted(){
+			return pack.isOpen();
+		}//mounted
+
+		static unsigned int count(){
+			return pack.count();
+		}//count
+
+		// Caminho sem ".", "..", barras repetidas ou invertidas
+		static string normalize(const string &path){
+			string slashes = path;
+			for(unsigned int i = 0; i < slashes.size(); i++)
+				if(slashes[i] == '\\')
+					slashes[i] = '/';
+
+			vector<string> parts;
+			stringstream in(slashes);
+			string part;
+			while(getline(in, part, '/')){
+				if(part.empty() or part == ".")
+					continue;
+				if(part == ".." and not parts.empty() and parts.back() != "..")
+					parts.pop_back();
+				else
+					parts.push_back(part);
+			}
+
+			string x = not slashes.empty() and slashes[0] == '/' ? "/" : "";
+			for(unsigned int i = 0; i < parts.size(); i++)
+				x += (i ? "/" : "") + parts[i];
+			return x;
+		}//normalize
+
+		// Chave de um caminho no pacote
+		static string key(const string &path){
+			string x = normalize(path);
+			if(not root.empty() and x.compare(0, root.size(), root) == 0)
+				x = x.substr(root.size());
+			return x;
+		}//key
+
+		static const PackEntry *find(const string &path){
+			return pack.isOpen() ? pack.find(key(path)) : NULL;
+		}//find
+
+		static bool packed(const string &path){
+			return find(path) != NULL;
+		}//packed
+
+		/** Bytes de um arquivo do pacote sem cópia
+			* @param size - Tamanho
+			* @return NULL se o arquivo não está no pacote ou está comprimido
+			*/
+		static const unsigned char *map(const string &path, size_t &size){
+			const PackEntry *entry = find(path);
+			size = 0;
+			if(not entry or (entry->flags & PACK_LZ4))
+				return NULL;
+			size = entry->size;
+			packReads++;
+			packBytes += size;
+			return pack.data(*entry);
+		}//map
+
+		/** Conteúdo de um arquivo, do pacote ou do disco
+			* @param out - Substituído
+			* @return false se o arquivo não existe ou não pôde ser lido
+			*/
+		static bool read(const string &path, vector<unsigned char> &out){
+			out.clear();
+			const PackEntry *entry = find(path);
+			if(entry){
+				packReads++;
+				packBytes += entry->size;
+				return pack.read(*entry, out);
+			}
+
+			FILE *in = fopen(path.c_str(), "rb");
+			if(not in)
+				return false;
+			bool ok = fseek(in, 0, SEEK_END) == 0;
+			long size = ftell(in);
+			ok = ok and size >= 0 and fseek(in, 0, SEEK_SET) == 0;
+			if(ok and size > 0){
+				out.resize(size);
+				ok = fread(&out[0], 1, size, in) == (size_t) size;
+			}
+			fclose(in);
+			if(not ok)
+				out.clear();
+			else{
+				looseReads++;
+				looseBytes += size;
+			}
+			return ok;
+		}//read
+
+		static bool readText(const string &path, string &out){
+			vector<unsigned char> bytes;
+			if(not read(path, bytes))
+				return false;
+			out.assign(bytes.begin(), bytes.end());
+			return true;
+		}//readText
+
+		// Existe no pacote ou no disco
+		static bool exists(const string &path){
+			if(packed(path))
+				return true;
+			FILE *in = fopen(path.c_str(), "rb");
+			if(in)
+				fclose(in);
+			return in != NULL;
+		}//exists
+
+		// stbi_info, lendo só o cabeçalho quando a imagem está no disco
+		static bool imageInfo(const string &path, int &width, int &height, int &components){
+			size_t size;
+			const unsigned char *data = map(path, size);
+			if(data)
+				return stbi_info_from_memory(data, size, &width, &height, &components);
+			vector<unsigned char> bytes;
+			if(packed(path))
+				return read(path, bytes) and not bytes.empty() and stbi_info_from_memory(&bytes[0], bytes.size(), &width, &height, &components);
+			return stbi_info(path.c_str(), &width, &height, &components);
+		}//imageInfo
+
+		// stbi_load: do mapeamento, do pacote descomprimido ou do disco
+		static unsigned char *loadImage(const string &path, int &width, int &height, int &components, int desired){
+			size_t size;
+			const unsigned char *data = map(path, size);
+			if(data)
+				return stbi_load_from_memory(data, size, &width, &height, &components, desired);
+			vector<unsigned char> bytes;
+			if(packed(path)){
+				if(not read(path, bytes) or bytes.empty())
+					return NULL;
+				return stbi_load_from_memory(&bytes[0], bytes.size(), &width, &height, &components, desired);
+			}
+			looseReads++;
+			return stbi_load(path.c_str(), &width, &height, &components, desired);
+		}//loadImage
+
+		// Leituras do pacote e do disco (saída)
+		static string summary(){
+			stringstream x;
+			x.precision(1);
+			x << fixed << "Pacote: " << packReads << " leituras (" << packBytes / 1048576.0 << " MB), disco: "
+			  << looseReads << " leituras";
+			if(looseBytes)
+				x << " (" << looseBytes / 1048576.0 << " MB)";
+			return x.str();
+		}//summary
+};
+
+Pack Vfs::pack;
+string Vfs::root;
+atomic<unsigned long> Vfs::packReads(0), Vfs::looseReads(0);
+atomic<unsigned long long> Vfs::packBytes(0), Vfs::looseBytes(0);
+
+#endif
@@ -0,0 +1,771 @@
+#ifndef VIRTUALTEXTURE_H
+#define VIRTUALTEXTURE_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/shader_m.h>
+#include <stb_image.h>
+
+#include "glstate.h"
+#include "mipchain.h"
+#include "tempfile.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Páginas da pirâmide: 128x128 texels de imagem e 4 de borda de cada lado,
+// copiados das vizinhas, para o filtro bilinear não ver a página ao lado
+#define VT_TILE   128
+#define VT_BORDER 4
+#define VT_PAGE   (VT_TILE + 2 * VT_BORDER)
+
+// Tamanho de uma pirâmide de páginas
+struct PyramidInfo {
+	int width, height;   // imagem no nível 0
+	int pagesX, pagesY;  // páginas do nível 0 (potências de 2)
+	int levels;          // até o nível com uma página só
+};
+
+// Pirâmide de páginas em arquivo: ao lado da imagem fica um "<imagem>.vt"
+// com todos os níveis cortados em páginas RGBA já com borda, do nível 0 ao
+// último, cada nível linha a linha:
+//   "VT01", largura, altura, páginas em x, páginas em y, níveis (int32), páginas
+// Uma página é lida com um seek, sem decodificar nada. A grade de páginas é
+// arredondada para potências de 2 (a imagem ocupa o canto e o shader escala
+// a coordenada), então o nível l tem max(1, páginas >> l) páginas em cada
+// eixo, como os mips da tabela de páginas. Em x a imagem dá a volta
+// (equiretangular), em y a borda repete a última linha.
+class TilePyramid {
+	public:
+		static bool info(const string &image, PyramidInfo &x){
+			int components;
+			if(not Vfs::imageInfo(image, x.width, x.height, components))
+				return false;
+			x.pagesX = power((x.width + VT_TILE - 1) / VT_TILE);
+			x.pagesY = power((x.height + VT_TILE - 1) / VT_TILE);
+			x.levels = MipChain::levelCount(x.pagesX, x.pagesY);
+			return true;
+		}//info
+
+		static int pages(int count, int level){
+			return max(1, count >> level);
+		}//pages
+
+		static unsigned long pageBytes(){
+			return (unsigned long) VT_PAGE * VT_PAGE * 4;
+		}//pageBytes
+
+		// Posição da página no arquivo
+		static unsigned long offset(const PyramidInfo &x, int level, int px, int py){
+			unsigned long offset = 4 + 5 * sizeof(int);
+			for(int l = 0; l < level; l++)
+				offset += (unsigned long) pages(x.pagesX, l) * pages(x.pagesY, l) * pageBytes();
+			return offset + ((unsigned long) py * pages(x.pagesX, level) + px) * pageBytes();
+		}//offset
+
+		// Abre a pirâmide da imagem, se existir e bater com a imagem
+		static bool open(const string &image, PyramidInfo &x){
+			if(not info(image, x))
+				return false;
+			FILE *in = fopen((image + ".vt").c_str(), "rb");
+			if(not in)
+				return false;
+
+			char magic[4];
+			int header[5];
+			bool valid = fread(magic, 1, 4, in) == 4 and string(magic, 4) == "VT01" and fread(header, sizeof(int), 5, in) == 5
+						 and header[0] == x.width and header[1] == x.height and header[2] == x.pagesX and header[3] == x.pagesY
+						 and header[4] == x.levels;
+			valid = valid and fseek(in, 0, SEEK_END) == 0 and (unsigned long) ftell(in) == offset(x, x.levels, 0, 0);
+			fclose(in);
+			return valid;
+		}//open
+
+		/** Decodifica a imagem e grava a pirâmide (uma vez por imagem). A imagem
+			* fica na memória com os canais que tem (RGB em 3 bytes por texel) até o
+			* nível 1 estar pronto; os níveis seguintes só precisam do anterior
+			*/
+		static bool build(const string &image, PyramidInfo &x){
+			TRACE_ZONE("TilePyramid::build");
+			int components;
+			if(not info(image, x) or not Vfs::imageInfo(image, x.width, x.height, components))
+				return false;
+			// O stb_image recusa imagens com mais de 2 GB decodificados
+			int channels = components == 3 ? 3 : 4;
+			if((unsigned long long) x.width * x.height * channels > INT_MAX){
+				cout << "ERROR::VIRTUAL:: " << image << " tem " << x.width << "x" << x.height << " com " << channels
+					 << " canais: passa de 2 GB decodificada (limite do stb_image; RGB vai até 32768x16384, RGBA até 16384x16384)" << endl;
+				return false;
+			}
+			int width, height;
+			unsigned char *data = Vfs::loadImage(image, width, height, components, channels);
+			if(not data){
+				cout << "ERROR::VIRTUAL:: Não foi possível decodificar " << image << ": " << stbi_failure_reason() << endl;
+				return false;
+			}
+
+			// Grava num temporário e renomeia: uma leitura nunca vê o arquivo pela metade
+			string path = image + ".vt";
+			string temporary = TempFile::name(path);
+			FILE *out = fopen(temporary.c_str(), "wb");
+			if(not out){
+				stbi_image_free(data);
+				return false;
+			}
+			int header[5] = {x.width, x.height, x.pagesX, x.pagesY, x.levels};
+			bool ok = fwrite("VT01", 1, 4, out) == 4 and fwrite(header, sizeof(int), 5, out) == 5;
+
+			vector<unsigned char> page(pageBytes()), level;
+			for(int l = 0; l < x.levels and ok; l++){
+				int w = max(1, x.width >> l), h = max(1, x.height >> l);
+				const unsigned char *pixels = l == 0 ? data : &level[0];
+				for(int py = 0; py < pages(x.pagesY, l) and ok; py++)
+					for(int px = 0; px < pages(x.pagesX, l) and ok; px++){
+						cut(pixels, w, h, channels, px, py, page);
+						ok = fwrite(&page[0], 1, page.size(), out) == page.size();
+					}
+				if(l + 1 < x.levels)
+					level = MipChain::half(pixels, w, h, channels);
+				if(l == 0){
+					stbi_image_free(data);
+					data = NULL;
+				}
+			}
+			stbi_image_free(data);
+			fclose(out);
+
+			if(ok)
+				ok = TempFile::commit(temporary, path);
+			if(not ok)
+				remove(temporary.c_str());
+			return ok;
+		}//build
+
+		// Lê uma página já aberta
+		static bool read(FILE *in, const PyramidInfo &x, int level, int px, int py, vector<unsigned char> &page){
+			page.resize(pageBytes());
+			return fseek(in, offset(x, level, px, py), SEEK_SET) == 0 and fread(&page[0], 1, page.size(), in) == page.size();
+		}//read
+
+	protected:
+		static int power(int n){
+			int p = 1;
+			while(p < n)
+				p *= 2;
+			return p;
+		}//power
+
+		// Copia uma página do nível (largura w, altura h), com a borda, em RGBA
+		static void cut(const unsigned char *level, int w, int h, int channels, int px, int py, vector<unsigned char> &page){
+			for(int j = 0; j < VT_PAGE; j++){
+				int y = min(max(py * VT_TILE + j - VT_BORDER, 0), h - 1);
+				for(int i = 0; i < VT_PAGE; i++){
+					int x = ((px * VT_TILE + i - VT_BORDER) % w + w) % w;
+					unsigned char *texel = &page[(j * VT_PAGE + i) * 4];
+					memcpy(texel, &level[((unsigned long) y * w + x) * channels], channels);
+					if(channels == 3)
+						texel[3] = 255;
+				}
+			}
+		}//cut
+};
+
+// Pedido de página lido do buffer de feedback
+struct VirtualRequest {
+	int id;      // textura virtual
+	int level, x, y;
+};
+
+// Buffer de feedback: a cena com as texturas virtuais é desenhada de novo
+// em 1/scale da resolução, e cada pixel guarda a página que o shader
+// precisou (x, y, nível e a textura + 1, em RGBA16UI). A leitura passa por
+// dois pixel buffers: os pedidos de um frame são lidos no seguinte, sem
+// esperar a GPU (no modo síncrono, na hora).
+class VirtualFeedback {
+	protected:
+		unsigned int fbo, color, depth;
+		unsigned int pbo[2];
+		bool filled[2];
+		int index;
+		int previous;
+		int viewport[4];
+
+	public:
+		static int scale;
+		int width, height;
+
+		VirtualFeedback(){
+			fbo = color = depth = 0;
+			pbo[0] = pbo[1] = 0;
+			filled[0] = filled[1] = false;
+			index = 0;
+			width = height = 0;
+		}//VirtualFeedback
+
+		// Cria ou redimensiona para a tela
+		void create(int screenWidth, int screenHeight){
+			width = max(1, screenWidth / scale);
+			height = max(1, screenHeight / scale);
+			if(not fbo){
+				glGenFramebuffers(1, &fbo);
+				glGenRenderbuffers(1, &color);
+				glGenRenderbuffers(1, &depth);
+				glGenBuffers(2, pbo);
+			}
+			glBindRenderbuffer(GL_RENDERBUFFER, color);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA16UI, width, height);
+			glBindRenderbuffer(GL_RENDERBUFFER, depth);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, width, height);
+
+			GLint bound;
+			glGetIntegerv(GL_FRAMEBUFFER_BINDING, &bound);
+			glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+			if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+				cout << "ERROR::VIRTUAL:: Framebuffer de feedback incompleto" << endl;
+			glBindFramebuffer(GL_FRAMEBUFFER, bound);
+
+			for(int i = 0; i < 2; i++){
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[i]);
+				glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 8, NULL, GL_STREAM_READ);
+				filled[i] = false;
+			}
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		}//create
+
+		// Começa o passe (o teste de profundidade segue o modo atual)
+		void begin(){
+			glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+			glGetIntegerv(GL_VIEWPORT, viewport);
+			glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+			glViewport(0, 0, width, height);
+			GLuint zero[4] = {0, 0, 0, 0};
+			glClearBufferuiv(GL_COLOR, 0, zero);
+			glClear(GL_DEPTH_BUFFER_BIT);
+		}//begin
+
+		/** Termina o passe e devolve os pedidos de um frame atrás (sem repetição)
+			* @param immediate - Lê o deste frame, esperando a GPU
+			*/
+		void end(vector<VirtualRequest> &requests, bool immediate){
+			TRACE_ZONE("VirtualFeedback::end");
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[index]);
+			glReadPixels(0, 0, width, height, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, 0);
+			filled[index] = true;
+			glBindFramebuffer(GL_FRAMEBUFFER, previous);
+			glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+			requests.clear();
+			int read = immediate ? index : 1 - index;
+			index = 1 - index;
+			if(not filled[read]){
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+				return;
+			}
+
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[read]);
+			const unsigned short *p = (const unsigned short *) glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, width * height * 8, GL_MAP_READ_BIT);
+			if(p){
+				set<unsigned long long> seen;
+				for(int i = 0; i < width * height; i++, p += 4){
+					if(not p[3])
+						continue;
+					unsigned long long key = ((unsigned long long) p[3] << 48) | ((unsigned long long) p[2] << 32) | ((unsigned long long) p[1] << 16) | p[0];
+					if(not seen.insert(key).second)
+						continue;
+					VirtualRequest r = {p[3] - 1, p[2], p[0], p[1]};
+					requests.push_back(r);
+				}
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			}
+			filled[read] = false;
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		}//end
+};
+
+// Página carregada na textura física
+struct VirtualSlot {
+	int level, x, y;        // página (level -1 = livre)
+	unsigned long lastUse;  // último feedback que a pediu
+	bool pinned;            // a do último nível nunca sai
+};
+
+// Página lida pela thread, esperando o envio
+struct VirtualPage {
+	int level, x, y;
+	vector<unsigned char> pixels;
+};
+
+// Estado de uma textura virtual
+enum VirtualState {
+	VT_UNLOADED,   // nada foi pedido
+	VT_BUILDING,   // a thread está abrindo ou montando a pirâmide
+	VT_OPEN,       // pirâmide pronta, falta criar as texturas
+	VT_READY,      // desenhável
+	VT_FAILED      // sem pirâmide; o corpo continua com a textura comum
+};
+
+// Textura virtual para mapas maiores que o limite de textura da GPU
+// (32k x 16k e acima). O mapa fica numa pirâmide de páginas em disco
+// (TilePyramid) e só as páginas que o feedback pediu ficam numa textura
+// física de cacheSize x cacheSize, uma cache LRU: quando ela enche sai a
+// página usada há mais tempo, fora a do último nível, que fica sempre.
+// A tabela de páginas é uma textura com um mip por nível da pirâmide; cada
+// texel aponta para a página na textura física que cobre aquele pedaço: a
+// própria, se estiver carregada, ou o ancestral carregado mais próximo.
+// As páginas são lidas por threads e no máximo uploadLimit são enviadas por
+// frame, as mais grossas primeiro. O detalhe fica limitado pelo disco e não
+// pela memória de vídeo.
+class VirtualTexture {
+	protected:
+		string image;
+		PyramidInfo info;
+		atomic<int> state;
+		thread builder;
+
+		unsigned int pageTable, physical;
+		int slotsPerSide;
+		vector<VirtualSlot> slots;
+		map<unsigned long long, int> resident;         // página -> slot
+		vector<vector<unsigned char> > table;           // tabela de páginas na CPU, um nível por mip
+		vector<bool> dirty;
+		unsigned long feedbackFrame;
+
+		// Threads de leitura
+		vector<thread> workers;
+		mutex lock;
+		condition_variable wake;
+		deque<VirtualPage> pending;  // pilha: o pedido mais novo primeiro
+		deque<VirtualPage> done;
+		bool running;
+		set<unsigned long long> queued;
+
+		// Estatísticas: acumuladas e do último segundo
+		chrono::steady_clock::time_point second;
+		unsigned long secondHits, secondRequests, secondBytes;
+
+	public:
+		static int cacheSize;             // lado da textura física (texels)
+		static unsigned int uploadLimit;  // páginas enviadas por frame
+		static unsigned int maxPending;   // leituras na fila
+		static bool synchronous;          // lê e envia na hora (frames determinísticos)
+
+		unsigned long hits, requests;     // páginas pedidas pelo feedback e quantas estavam carregadas
+		unsigned long uploads, uploadBytes, evictions;
+		float hitRate;                    // último segundo
+		float uploadRate;                 // MB/s, último segundo
+
+		VirtualTexture(const string &file): state(VT_UNLOADED), running(false){
+			image = file;
+			pageTable = physical = 0;
+			slotsPerSide = 0;
+			feedbackFrame = 0;
+			hits = requests = uploads = uploadBytes = evictions = 0;
+			secondHits = secondRequests = secondBytes = 0;
+			hitRate = 1.0f;
+			uploadRate = 0.0f;
+			second = chrono::steady_clock::now();
+		}//VirtualTexture
+
+		~VirtualTexture(){
+			stop();
+			if(builder.joinable())
+				builder.join();
+		}//~VirtualTexture
+
+		// Abre ou monta a pirâmide numa thread
+		void request(){
+			if(state != VT_UNLOADED)
+				return;
+			state = VT_BUILDING;
+			if(synchronous)
+				prepare();
+			else
+				builder = thread([this]{
+					TRACE_THREAD("vt_build");
+					prepare();
+				});
+		}//request
+
+		/** Cria as texturas quando a pirâmide fica pronta (thread principal)
+			* @return true no frame em que ficou pronta ou falhou
+			*/
+		bool poll(){
+			if(state != VT_OPEN and not (state == VT_FAILED and builder.joinable()))
+				return false;
+			if(builder.joinable())
+				builder.join();
+			if(state == VT_FAILED)
+				return true;
+			createTextures();
+			state = VT_READY;
+			if(not synchronous)
+				start();
+			return true;
+		}//poll
+
+		bool ready(){
+			return state == VT_READY;
+		}//ready
+
+		VirtualState getState(){
+			return (VirtualState) state.load();
+		}//getState
+
+		const string &getImage(){
+			return image;
+		}//getImage
+
+		/** Liga a tabela e a textura física nas unidades 1 e 2
+			* @param shader - Shader de desenho ou de feedback, já em uso
+			* @param id - Índice da textura no feedback
+			*/
+		void bind(Shader *shader, int id){
+			GLState::bindTextureUnit(1, GL_TEXTURE_2D, pageTable);
+			GLState::bindTextureUnit(2, GL_TEXTURE_2D, physical);
+			shader->setInt("pageTable", 1);
+			shader->setInt("physical", 2);
+			shader->setVec4("vtPages", glm::vec4(info.pagesX, info.pagesY, info.levels, 0.0f));
+			shader->setVec4("vtImage", glm::vec4((float) info.width / (info.pagesX * VT_TILE), (float) info.height / (info.pagesY * VT_TILE), VT_TILE, VT_BORDER));
+			shader->setVec2("vtPhysical", glm::vec2(cacheSize, cacheSize));
+			shader->setFloat("vtId", id);
+		}//bind
+
+		// Pedidos do feedback para esta textura
+		void feedback(const vector<VirtualRequest> &pages){
+			TRACE_ZONE("VirtualTexture::feedback");
+			if(state != VT_READY)
+				return;
+			feedbackFrame++;
+
+			vector<VirtualRequest> missing;
+			for(unsigned int i = 0; i < pages.size(); i++){
+				const VirtualRequest &p = pages[i];
+				if(p.level < 0 or p.level >= info.levels or p.x >= TilePyramid::pages(info.pagesX, p.level) or p.y >= TilePyramid::pages(info.pagesY, p.level))
+					continue;
+				requests++;
+				secondRequests++;
+				if(resident.count(key(p.level, p.x, p.y))){
+					hits++;
+					secondHits++;
+				}
+				else
+					missing.push_back(p);
+
+				// A página e os ancestrais (a reserva do shader) ficam na cache
+				for(int l = p.level; l < info.levels; l++){
+					map<unsigned long long, int>::iterator it = resident.find(key(l, p.x >> (l - p.level), p.y >> (l - p.level)));
+					if(it != resident.end())
+						slots[it->second].lastUse = feedbackFrame;
+				}
+			}
+
+			// Dos níveis grossos para os finos; uma página sem o pai carregado pede o pai
+			sort(missing.begin(), missing.end(), [](const VirtualRequest &a, const VirtualRequest &b){ return a.level > b.level; });
+			for(unsigned int i = 0; i < missing.size(); i++){
+				int l = missing[i].level, x = missing[i].x, y = missing[i].y;
+				while(l + 1 < info.levels and not resident.count(key(l + 1, x >> 1, y >> 1))){
+					l++;
+					x >>= 1;
+					y >>= 1;
+				}
+				load(l, x, y);
+			}
+		}//feedback
+
+		// Envia as páginas lidas e a tabela que mudou (thread principal)
+		void update(){
+			TRACE_ZONE("VirtualTexture::update");
+			if(state != VT_READY)
+				return;
+
+			for(unsigned int n = 0; n < uploadLimit or synchronous; n++){
+				VirtualPage page;
+				{
+					unique_lock<mutex> guard(lock);
+					if(done.empty())
+						break;
+					page.level = done.front().level;
+					page.x = done.front().x;
+					page.y = done.front().y;
+					page.pixels.swap(done.front().pixels);
+					done.pop_front();
+				}
+				queued.erase(key(page.level, page.x, page.y));
+				if(not page.pixels.empty())
+					upload(page);
+			}
+
+			for(int l = 0; l < info.levels; l++)
+				if(dirty[l]){
+					GLState::bindTexture(GL_TEXTURE_2D, pageTable);
+					glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+					glTexSubImage2D(GL_TEXTURE_2D, l, 0, 0, TilePyramid::pages(info.pagesX, l), TilePyramid::pages(info.pagesY, l), GL_RGBA, GL_UNSIGNED_BYTE, &table[l][0]);
+					glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+					dirty[l] = false;
+				}
+
+			// Janela de um segundo
+			chrono::steady_clock::time_point now = chrono::steady_clock::now();
+			double seconds = chrono::duration<double>(now - second).count();
+			if(seconds >= 1.0){
+				hitRate = secondRequests ? (float) secondHits / secondRequests : 1.0f;
+				uploadRate = secondBytes / 1048576.0 / seconds;
+				secondHits = secondRequests = secondBytes = 0;
+				second = now;
+			}
+		}//update
+
+		// Acertos, envios e ocupação, para a tela
+		string status(){
+			char line[96];
+			snprintf(line, sizeof(line), "Textura virtual: %.0f%% acertos, %.1f MB/s, %u/%u páginas",
+					 100.0f * hitRate, uploadRate, (unsigned int) resident.size(), (unsigned int) slots.size());
+			return line;
+		}//status
+
+		// Totais da execução
+		string summary(){
+			char line[192];
+			snprintf(line, sizeof(line), "Textura virtual %s: %dx%d, %lu páginas pedidas (%.1f%% na cache), %lu enviadas (%.1f MB), %lu despejadas",
+					 image.c_str(), info.width, info.height, requests, requests ? 100.0 * hits / requests : 100.0,
+					 uploads, uploadBytes / 1048576.0, evictions);
+			return line;
+		}//summary
+
+		// Termina as threads e libera as texturas (com o contexto ainda ativo)
+		void destroy(){
+			stop();
+			if(builder.joinable())
+				builder.join();
+			if(pageTable){
+				GLState::deleteTexture(pageTable);
+				GLState::deleteTexture(physical);
+			}
+			pageTable = physical = 0;
+		}//destroy
+
+	protected:
+		static unsigned long long key(int level, int x, int y){
+			return ((unsigned long long) level << 48) | ((unsigned long long) x << 24) | (unsigned long long) y;
+		}//key
+
+		void prepare(){
+			if(TilePyramid::open(image, info) or TilePyramid::build(image, info))
+				state = VT_OPEN;
+			else
+				state = VT_FAILED;
+		}//prepare
+
+		void createTextures(){
+			// Tabela: um mip por nível, todos apontando para a última página
+			glGenTextures(1, &pageTable);
+			GLState::bindTexture(GL_TEXTURE_2D, pageTable);
+			table.resize(info.levels);
+			dirty.assign(info.levels, true);
+			for(int l = 0; l < info.levels; l++){
+				int w = TilePyramid::pages(info.pagesX, l), h = TilePyramid::pages(info.pagesY, l);
+				table[l].assign(w * h * 4, 0);
+				for(int i = 0; i < w * h; i++){
+					table[l][4 * i + 2] = info.levels - 1;
+					table[l][4 * i + 3] = 255;
+				}
+				glTexImage2D(GL_TEXTURE_2D, l, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+			}
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, info.levels - 1);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+			// Textura física, sem mips: o nível vem da tabela
+			glGenTextures(1, &physical);
+			GLState::bindTexture(GL_TEXTURE_2D, physical);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, cacheSize, cacheSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+			slotsPerSide = min(cacheSize / VT_PAGE, 255);
+			VirtualSlot empty = {-1, 0, 0, 0, false};
+			slots.assign(slotsPerSide * slotsPerSide, empty);
+
+			// A página do último nível, lida na hora e presa na cache
+			VirtualPage page = {info.levels - 1, 0, 0, vector<unsigned char>()};
+			FILE *in = fopen((image + ".vt").c_str(), "rb");
+			if(in){
+				TilePyramid::read(in, info, page.level, 0, 0, page.pixels);
+				fclose(in);
+			}
+			if(page.pixels.size() == TilePyramid::pageBytes())
+				upload(page);
+			if(resident.count(key(info.levels - 1, 0, 0)))
+				slots[resident[key(info.levels - 1, 0, 0)]].pinned = true;
+		}//createTextures
+
+		// Pede a leitura de uma página
+		void load(int level, int x, int y){
+			unsigned long long k = key(level, x, y);
+			if(resident.count(k) or queued.count(k))
+				return;
+
+			if(synchronous){
+				VirtualPage page = {level, x, y, vector<unsigned char>()};
+				FILE *in = fopen((image + ".vt").c_str(), "rb");
+				bool ok = in and TilePyramid::read(in, info, level, x, y, page.pixels);
+				if(in)
+					fclose(in);
+				if(ok)
+					upload(page);
+				return;
+			}
+
+			unique_lock<mutex> guard(lock);
+			// Fila cheia: os pedidos mais antigos provavelmente já saíram da tela
+			while(pending.size() >= maxPending){
+				queued.erase(key(pending.front().level, pending.front().x, pending.front().y));
+				pending.pop_front();
+			}
+			VirtualPage page = {level, x, y, vector<unsigned char>()};
+			pending.push_back(page);
+			queued.insert(k);
+			wake.notify_one();
+		}//load
+
+		// Põe a página num slot livre ou no usado há mais tempo
+		void upload(VirtualPage &page){
+			TRACE_ZONE("VirtualTexture::upload");
+			unsigned long long k = key(page.level, page.x, page.y);
+			if(resident.count(k))
+				return;
+
+			int slot = -1;
+			for(unsigned int i = 0; i < slots.size(); i++){
+				if(slots[i].level < 0){
+					slot = i;
+					break;
+				}
+				if(not slots[i].pinned and slots[i].lastUse < feedbackFrame and (slot < 0 or slots[i].lastUse < slots[slot].lastUse))
+					slot = i;
+			}
+			// Tudo em uso neste frame: a página espera o próximo pedido
+			if(slot < 0)
+				return;
+			if(slots[slot].level >= 0)
+				evict(slot);
+
+			int sx = slot % slotsPerSide, sy = slot / slotsPerSide;
+			GLState::bindTexture(GL_TEXTURE_2D, physical);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, sx * VT_PAGE, sy * VT_PAGE, VT_PAGE, VT_PAGE, GL_RGBA, GL_UNSIGNED_BYTE, &page.pixels[0]);
+			VirtualSlot s = {page.level, page.x, page.y, feedbackFrame, false};
+			slots[slot] = s;
+			resident[k] = slot;
+			uploads++;
+			uploadBytes += page.pixels.size();
+			secondBytes += page.pixels.size();
+
+			// A região da página, do nível dela até o 0, passa a apontar para
+			// ela onde apontava para um ancestral mais grosso
+			for(int l = page.level; l >= 0; l--)
+				region(page.level, page.x, page.y, l, [&](unsigned char *entry){
+					if(entry[2] > page.level){
+						entry[0] = sx;
+						entry[1] = sy;
+						entry[2] = page.level;
+					}
+				});
+		}//upload
+
+		// Tira a página do slot; a região dela volta para o que o pai aponta
+		void evict(int slot){
+			VirtualSlot &s = slots[slot];
+			resident.erase(key(s.level, s.x, s.y));
+			evictions++;
+
+			const unsigned char *parent = &table[s.level + 1][4 * ((s.y >> 1) * TilePyramid::pages(info.pagesX, s.level + 1) + (s.x >> 1))];
+			int sx = slot % slotsPerSide, sy = slot / slotsPerSide;
+			for(int l = s.level; l >= 0; l--)
+				region(s.level, s.x, s.y, l, [&](unsigned char *entry){
+					if(entry[0] == sx and entry[1] == sy and entry[2] == s.level)
+						memcpy(entry, parent, 3);
+				});
+			s.level = -1;
+		}//evict
+
+		// Aplica f a cada texel da tabela do nível l coberto pela página (level, x, y)
+		template<typename F> void region(int level, int x, int y, int l, F f){
+			int shift = level - l;
+			int w = TilePyramid::pages(info.pagesX, l), h = TilePyramid::pages(info.pagesY, l);
+			int x1 = min(w, (x + 1) << shift), y1 = min(h, (y + 1) << shift);
+			for(int j = y << shift; j < y1; j++)
+				for(int i = x << shift; i < x1; i++)
+					f(&table[l][4 * (j * w + i)]);
+			dirty[l] = true;
+		}//region
+
+		void start(){
+			running = true;
+			for(unsigned int i = 0; i < 2; i++)
+				workers.push_back(thread(&VirtualTexture::work, this));
+		}//start
+
+		void stop(){
+			{
+				unique_lock<mutex> guard(lock);
+				running = false;
+				pending.clear();
+			}
+			wake.notify_all();
+			for(unsigned int i = 0; i < workers.size(); i++)
+				workers[i].join();
+			workers.clear();
+		}//stop
+
+		// Thread de leitura: cada uma com o arquivo aberto
+		void work(){
+			TRACE_THREAD("vt_pages");
+			FILE *in = fopen((image + ".vt").c_str(), "rb");
+			unique_lock<mutex> guard(lock);
+			while(in){
+				wake.wait(guard, [this]{ return not pending.empty() or not running; });
+				if(not running)
+					break;
+
+				VirtualPage page = pending.back();
+				pending.pop_back();
+				guard.unlock();
+				// Uma leitura que falhou volta vazia e sai da fila sem envio
+				if(not TilePyramid::read(in, info, page.level, page.x, page.y, page.pixels))
+					page.pixels.clear();
+				guard.lock();
+				done.push_back(page);
+			}
+			if(in)
+				fclose(in);
+		}//work
+};
+
+int VirtualFeedback::scale = 8;
+int VirtualTexture::cacheSize = 4096;
+unsigned int VirtualTexture::uploadLimit = 8;
+unsigned int VirtualTexture::maxPending = 64;
+bool VirtualTexture::synchronous = false;
+
+#endif
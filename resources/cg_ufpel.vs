@@ -4,13 +4,34 @@ layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
 out vec2 TexCoords;
+out float flogz;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// dados da câmera, compartilhados por todos os shaders
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProj;
+    vec4 cameraPos;
+    vec4 time;
+};
+
+// dados de cada objeto desenhado
+layout (std140) uniform Object
+{
+    mat4 model;
+};
+
+uniform float logDepth; // coeficiente da profundidade logarítmica, 0 = desligada
 
 void main()
 {
     TexCoords = aTexCoords;    
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = viewProj * model * vec4(aPos, 1.0);
+
+    if (logDepth > 0.0)
+    {
+        flogz = 1.0 + gl_Position.w;
+        gl_Position.z = (log2(max(1e-6, flogz)) * logDepth - 1.0) * gl_Position.w;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,15 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+in float flogz;
+
+uniform sampler2D texture_diffuse1;
+uniform float logDepth;
+
+void main()
+{    
+    FragColor = texture(texture_diffuse1, TexCoords);
+    // profundidade logarítmica, para o GL 3.3 sem glClipControl
+    gl_FragDepth = log2(flogz) * logDepth * 0.5;
+}
\ No newline at end of file
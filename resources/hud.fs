@@ -0,0 +1,16 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+in vec4 Color;
+
+uniform sampler2D atlas;
+
+void main()
+{
+    // atlas de um canal: 1 no glifo, 0 fora
+    float coverage = texture(atlas, TexCoords).r;
+    if(coverage < 0.5)
+        discard;
+    FragColor = Color;
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#version 330 core
+layout (location = 0) in vec4 vertex; // posição em pixels (origem em cima à esquerda), uv
+layout (location = 1) in vec4 color;
+
+out vec2 TexCoords;
+out vec4 Color;
+
+uniform vec2 screen;
+
+void main()
+{
+    vec2 position = vertex.xy / screen * 2.0 - 1.0;
+    gl_Position = vec4(position.x, -position.y, 0.0, 1.0);
+    TexCoords = vertex.zw;
+    Color = color;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 5) in mat4 aModel; // matriz do desenho, do buffer de parâmetros (DrawArena)
+
+out vec2 TexCoords;
+out float flogz;
+
+// dados da câmera, compartilhados por todos os shaders
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProj;
+    vec4 cameraPos;
+    vec4 time;
+};
+
+uniform float logDepth; // coeficiente da profundidade logarítmica, 0 = desligada
+
+void main()
+{
+    TexCoords = aTexCoords;    
+    gl_Position = viewProj * aModel * vec4(aPos, 1.0);
+
+    if (logDepth > 0.0)
+    {
+        flogz = 1.0 + gl_Position.w;
+        gl_Position.z = (log2(max(1e-6, flogz)) * logDepth - 1.0) * gl_Position.w;
+    }
+}
\ No newline at end of file
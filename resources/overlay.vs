@@ -0,0 +1,9 @@
+#version 330 core
+uniform vec4 rect; // esquerda, baixo, direita, cima
+
+void main()
+{
+    // retângulo com 4 vértices em triangle strip, sem buffer de vértices
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    gl_Position = vec4(mix(rect.xy, rect.zw, corner), 0.0, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 Direction;
+
+uniform samplerCube skybox;
+uniform mat3 orientation;
+
+void main()
+{
+    FragColor = texture(skybox, orientation * normalize(Direction));
+}
\ No newline at end of file
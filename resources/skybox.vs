@@ -0,0 +1,14 @@
+#version 330 core
+out vec3 Direction;
+
+uniform mat4 inverseViewProjection;
+uniform float farPlane;
+
+void main()
+{
+    // triângulo que cobre a tela inteira, sem buffer de vértices
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+    vec4 world = inverseViewProjection * vec4(pos, 1.0, 1.0);
+    Direction = world.xyz / world.w;
+    gl_Position = vec4(pos, farPlane, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D texture_diffuse1;
+uniform float threshold;
+
+void main()
+{
+    vec4 color = texture(texture_diffuse1, TexCoords);
+    // estrelas abaixo do limite de magnitude são descartadas
+    float luminance = dot(color.rgb, vec3(0.2126, 0.7152, 0.0722));
+    if (luminance < threshold)
+        color.rgb = vec3(0.0);
+    FragColor = color;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+in float flogz;
+
+uniform sampler2D pageTable;  // por página: slot na textura física (rg) e nível carregado (b)
+uniform sampler2D physical;   // páginas carregadas, com borda
+uniform vec4 vtPages;         // páginas do nível 0 (xy), níveis (z)
+uniform vec4 vtImage;         // fração da grade ocupada pela imagem (xy), página (z), borda (w)
+uniform vec2 vtPhysical;      // tamanho da textura física
+uniform float logDepth;       // coeficiente da profundidade logarítmica, 0 = desligada
+
+void main()
+{
+    // coordenada na grade de páginas; as derivadas usam a coordenada sem o fract, sem salto na costura
+    vec2 uv = vec2(fract(TexCoords.x), clamp(TexCoords.y, 0.0, 0.99999)) * vtImage.xy;
+    vec2 dx = dFdx(TexCoords * vtImage.xy * vtPages.xy * vtImage.z);
+    vec2 dy = dFdy(TexCoords * vtImage.xy * vtPages.xy * vtImage.z);
+    float level = clamp(floor(0.5 * log2(max(dot(dx, dx), dot(dy, dy)))), 0.0, vtPages.z - 1.0);
+
+    // a tabela aponta para a página do nível pedido ou para o ancestral carregado
+    vec4 entry = floor(texelFetch(pageTable, ivec2(uv * vtPages.xy * exp2(-level)), int(level)) * 255.0 + 0.5);
+    vec2 inPage = fract(uv * vtPages.xy * exp2(-entry.b));
+    vec2 coord = entry.rg * (vtImage.z + 2.0 * vtImage.w) + vtImage.w + inPage * vtImage.z;
+    FragColor = textureLod(physical, coord / vtPhysical, 0.0);
+
+    // profundidade logarítmica, para o GL 3.3 sem glClipControl
+    gl_FragDepth = logDepth > 0.0 ? log2(flogz) * logDepth * 0.5 : gl_FragCoord.z;
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#version 330 core
+out uvec4 Request;
+
+in vec2 TexCoords;
+in float flogz;
+
+uniform vec4 vtPages;   // páginas do nível 0 (xy), níveis (z)
+uniform vec4 vtImage;   // fração da grade ocupada pela imagem (xy), página (z), borda (w)
+uniform float vtId;     // textura virtual
+uniform float vtBias;   // log2 da redução do buffer de feedback
+uniform float logDepth;
+
+void main()
+{
+    // o mesmo nível do virtual.fs, corrigido pela resolução menor
+    vec2 uv = vec2(fract(TexCoords.x), clamp(TexCoords.y, 0.0, 0.99999)) * vtImage.xy;
+    vec2 dx = dFdx(TexCoords * vtImage.xy * vtPages.xy * vtImage.z);
+    vec2 dy = dFdy(TexCoords * vtImage.xy * vtPages.xy * vtImage.z);
+    float level = clamp(floor(0.5 * log2(max(dot(dx, dx), dot(dy, dy))) - vtBias), 0.0, vtPages.z - 1.0);
+
+    uvec2 page = uvec2(uv * vtPages.xy * exp2(-level));
+    Request = uvec4(page, uint(level), uint(vtId) + 1u);
+
+    gl_FragDepth = logDepth > 0.0 ? log2(flogz) * logDepth * 0.5 : gl_FragCoord.z;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+# Compara dois relatórios JSON do Google Benchmark (--benchmark_out):
+# mostra a variação de cada benchmark e sai com erro se algum ficou mais
+# lento que o limite.
+#
+#   python3 src/Benchmarks/compare.py baseline.json atual.json [--threshold 10]
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        report = json.load(f)
+    times = {}
+    for b in report["benchmarks"]:
+        # com repetições usa a mediana; sem elas, a própria execução
+        if b.get("run_type") == "aggregate" and b.get("aggregate_name") != "median":
+            continue
+        if b.get("error_occurred"):
+            continue
+        name = b.get("run_name", b["name"])
+        times[name] = b["real_time"] * scale(b.get("time_unit", "ns"))
+    return times
+
+
+def scale(unit):
+    return {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}[unit]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compara relatórios do Google Benchmark")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="piora máxima em porcentagem (padrão 10)")
+    args = parser.parse_args()
+
+    base = load(args.baseline)
+    current = load(args.current)
+
+    slower = 0
+    width = max([len(n) for n in list(base) + list(current)] + [9])
+    print("%-*s %12s %12s %8s" % (width, "benchmark", "base (ns)", "atual (ns)", "delta"))
+    for name in current:
+        if name not in base:
+            print("%-*s %12s %12.1f %8s" % (width, name, "-", current[name], "novo"))
+            continue
+        delta = 100.0 * (current[name] - base[name]) / base[name]
+        mark = ""
+        if delta > args.threshold:
+            mark = "  <- mais lento"
+            slower += 1
+        print("%-*s %12.1f %12.1f %+7.1f%%%s" % (width, name, base[name], current[name], delta, mark))
+
+    for name in base:
+        if name not in current:
+            print("%-*s %12.1f %12s %8s" % (width, name, base[name], "-", "sumiu"))
+
+    if slower:
+        print("%d benchmark(s) mais de %.0f%% mais lentos" % (slower, args.threshold))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,287 @@
+// Microbenchmarks dos caminhos de carga e de desenho: conversão dos vértices
+// do Assimp, decodificação e envio das texturas, escrita de uniforms e o
+// FileSystem::getPath.
+// Os que usam OpenGL criam um contexto EGL sem janela (Offscreen) e são
+// pulados quando ele não existe.
+// Fica num arquivo só: os headers definem variáveis globais e estáticas.
+
+#include <benchmark/benchmark.h>
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/shader_m.h>
+#include <learnopengl/model.h>
+
+#include <solarsystem/offscreen.h>
+#include <solarsystem/uniforms.h>
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Texturas de três planetas, de 3000x1500 e 4096x2048
+static const char *textures[] = {
+    "resources/objects/Planets/earth",
+    "resources/objects/Planets/jupiter",
+    "resources/objects/Planets/mars"
+};
+
+// Contexto OpenGL compartilhado, criado no primeiro uso
+static bool context(){
+    static Offscreen offscreen;
+    static int ready = -1;
+    if(ready < 0){
+        ready = offscreen.create(64, 64);
+        if(ready)
+            UniformRing::init(Offscreen::loader());
+    }
+    return ready;
+}//context
+
+/** Malha do Assimp com todos os atributos que o Model lê
+    * @param count - Vértices (e triângulos)
+    */
+static aiMesh *makeMesh(unsigned int count){
+    aiMesh *mesh = new aiMesh();
+    mesh->mNumVertices = count;
+    mesh->mVertices = new aiVector3D[count];
+    mesh->mNormals = new aiVector3D[count];
+    mesh->mTangents = new aiVector3D[count];
+    mesh->mBitangents = new aiVector3D[count];
+    mesh->mTextureCoords[0] = new aiVector3D[count];
+    mesh->mNumUVComponents[0] = 2;
+    for(unsigned int i = 0; i < count; i++){
+        float x = (float) i / count;
+        mesh->mVertices[i] = aiVector3D(x, 1.0f - x, 0.5f);
+        mesh->mNormals[i] = aiVector3D(0.0f, 1.0f, 0.0f);
+        mesh->mTangents[i] = aiVector3D(1.0f, 0.0f, 0.0f);
+        mesh->mBitangents[i] = aiVector3D(0.0f, 0.0f, 1.0f);
+        mesh->mTextureCoords[0][i] = aiVector3D(x, x, 0.0f);
+    }
+
+    mesh->mNumFaces = count;
+    mesh->mFaces = new aiFace[count];
+    for(unsigned int i = 0; i < count; i++){
+        aiFace &face = mesh->mFaces[i];
+        face.mNumIndices = 3;
+        face.mIndices = new unsigned int[3];
+        face.mIndices[0] = i;
+        face.mIndices[1] = (i + 1) % count;
+        face.mIndices[2] = (i + 2) % count;
+    }
+    return mesh;
+}//makeMesh
+
+// Caminho de um recurso, chamado a cada carga de modelo, textura e shader
+static void BM_FileSystemGetPath(benchmark::State &state){
+    for(auto _ : state)
+        benchmark::DoNotOptimize(FileSystem::getPath("resources/objects/Planets/earth/earth.obj"));
+}//BM_FileSystemGetPath
+BENCHMARK(BM_FileSystemGetPath);
+
+// Model::processMesh: conversão dos vértices e índices do Assimp
+static void BM_ProcessVertices(benchmark::State &state){
+    aiMesh *mesh = makeMesh(state.range(0));
+
+    for(auto _ : state){
+        vector<Vertex> vertices;
+        vector<unsigned int> indices;
+        Model::processVertices(mesh, vertices, indices);
+        benchmark::DoNotOptimize(&vertices[0]);
+        benchmark::DoNotOptimize(&indices[0]);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    delete mesh;
+}//BM_ProcessVertices
+BENCHMARK(BM_ProcessVertices)->RangeMultiplier(4)->Range(1 << 10, 1 << 16);
+
+// MeshCook::cook numa grade de N x N quadrados com um vértice por canto, como o
+// Assimp entrega os modelos; o rótulo mostra o ACMR antes e depois
+static void BM_MeshCook(benchmark::State &state){
+    int n = state.range(0);
+    vector<Vertex> grid;
+    vector<unsigned int> corners;
+    for(int y = 0; y < n; y++)
+        for(int x = 0; x < n; x++){
+            const int quad[6][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 0}, {1, 1}, {0, 1}};
+            for(int k = 0; k < 6; k++){
+                Vertex v;
+                v.Position = glm::vec3(x + quad[k][0], 0.0f, y + quad[k][1]);
+                v.Normal = glm::vec3(0.0f, 1.0f, 0.0f);
+                v.TexCoords = glm::vec2(v.Position.x, v.Position.z) / (float) n;
+                v.Tangent = glm::vec3(1.0f, 0.0f, 0.0f);
+                v.Bitangent = glm::vec3(0.0f, 0.0f, 1.0f);
+                corners.push_back(grid.size());
+                grid.push_back(v);
+            }
+        }
+
+    vector<Vertex> vertices;
+    vector<unsigned int> indices;
+    for(auto _ : state){
+        vertices = grid;
+        indices = corners;
+        MeshCook::cook(vertices, indices);
+        benchmark::DoNotOptimize(&indices[0]);
+    }
+    state.SetItemsProcessed(state.iterations() * corners.size() / 3);
+    char label[64];
+    snprintf(label, sizeof(label), "ACMR %.2f -> %.2f", MeshCook::analyze(corners, grid.size()).acmr,
+             MeshCook::analyze(indices, vertices.size()).acmr);
+    state.SetLabel(label);
+}//BM_MeshCook
+BENCHMARK(BM_MeshCook)->RangeMultiplier(4)->Range(16, 256)->Unit(benchmark::kMillisecond);
+
+// Simplify::lods numa grade ondulada de N x N quadrados, já soldada; o rótulo
+// mostra os triângulos de cada nível
+static void BM_Simplify(benchmark::State &state){
+    int n = state.range(0);
+    vector<Vertex> vertices;
+    vector<unsigned int> grid;
+    for(int y = 0; y <= n; y++)
+        for(int x = 0; x <= n; x++){
+            Vertex v;
+            v.Position = glm::vec3(x, 2.0f * sin(x * 0.3f) * cos(y * 0.2f), y);
+            v.Normal = glm::vec3(0.0f, 1.0f, 0.0f);
+            v.TexCoords = glm::vec2(x, y) / (float) n;
+            v.Tangent = glm::vec3(1.0f, 0.0f, 0.0f);
+            v.Bitangent = glm::vec3(0.0f, 0.0f, 1.0f);
+            vertices.push_back(v);
+        }
+    for(int y = 0; y < n; y++)
+        for(int x = 0; x < n; x++){
+            unsigned int a = y * (n + 1) + x, b = a + 1, c = a + n + 1, d = c + 1;
+            unsigned int quad[6] = {a, c, b, b, c, d};
+            grid.insert(grid.end(), quad, quad + 6);
+        }
+
+    vector<unsigned int> indices;
+    vector<LodLevel> lods;
+    for(auto _ : state){
+        indices = grid;
+        Simplify::lods(vertices, indices, lods);
+        benchmark::DoNotOptimize(&indices[0]);
+    }
+    state.SetItemsProcessed(state.iterations() * grid.size() / 3);
+    string label;
+    for(unsigned int i = 0; i < lods.size(); i++)
+        label += (i ? " " : "") + to_string(lods[i].count / 3);
+    state.SetLabel(label);
+}//BM_Simplify
+BENCHMARK(BM_Simplify)->RangeMultiplier(2)->Range(32, 128)->Unit(benchmark::kMillisecond);
+
+// Decodificação do PNG, a parte de CPU do TextureFromFile
+static void BM_TextureDecode(benchmark::State &state){
+    string file = FileSystem::getPath(string(textures[state.range(0)]) + "/planet_Quom1200.png");
+    int width = 0, height = 0, components = 0;
+
+    for(auto _ : state){
+        unsigned char *data = stbi_load(file.c_str(), &width, &height, &components, 0);
+        if(not data){
+            state.SkipWithError("stbi_load falhou");
+            break;
+        }
+        stbi_image_free(data);
+    }
+    state.SetBytesProcessed(state.iterations() * (int64_t) width * height * components);
+    state.SetLabel(to_string(width) + "x" + to_string(height));
+}//BM_TextureDecode
+BENCHMARK(BM_TextureDecode)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+
+// TextureFromFile completo: decodificação, envio e mipmaps
+static void BM_TextureFromFile(benchmark::State &state){
+    if(not context()){
+        state.SkipWithError("sem contexto OpenGL (EGL)");
+        return;
+    }
+    string directory = FileSystem::getPath(textures[state.range(0)]);
+
+    for(auto _ : state){
+        unsigned int texture = TextureFromFile("planet_Quom1200.png", directory);
+        glFinish();
+        Residency::release(texture);
+    }
+}//BM_TextureFromFile
+BENCHMARK(BM_TextureFromFile)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+
+// Shader::setMat4: procura a posição pelo nome a cada chamada
+static void BM_ShaderSetMat4(benchmark::State &state){
+    if(not context()){
+        state.SkipWithError("sem contexto OpenGL (EGL)");
+        return;
+    }
+    Shader shader(FileSystem::getPath("resources/skybox.vs").c_str(), FileSystem::getPath("resources/skybox.fs").c_str());
+    shader.use();
+    glm::mat4 matrix(1.0f);
+
+    for(auto _ : state){
+        matrix[3][0] += 1.0f;
+        shader.setMat4("inverseViewProjection", matrix);
+    }
+    GLState::deleteProgram(shader.ID);
+}//BM_ShaderSetMat4
+BENCHMARK(BM_ShaderSetMat4);
+
+// Mesh::Draw de 64 malhas com a mesma textura, como as luas de um planeta; o
+// rótulo mostra as trocas de estado enviadas e as evitadas pelo GLState
+static void BM_MeshDraw(benchmark::State &state){
+    if(not context()){
+        state.SkipWithError("sem contexto OpenGL (EGL)");
+        return;
+    }
+    Shader shader(FileSystem::getPath("resources/cg_ufpel.vs").c_str(), FileSystem::getPath("resources/cg_ufpel.fs").c_str());
+    shader.use();
+    Texture texture;
+    texture.id = TextureFromFile("planet_Quom1200.png", FileSystem::getPath(textures[0]));
+    texture.type = "texture_diffuse";
+    vector<Vertex> vertices(3);
+    vertices[1].Position = glm::vec3(1.0f, 0.0f, 0.0f);
+    vertices[2].Position = glm::vec3(0.0f, 1.0f, 0.0f);
+    vector<unsigned int> indices;
+    for(unsigned int i = 0; i < 3; i++)
+        indices.push_back(i);
+    vector<Mesh> meshes;
+    for(int i = 0; i < 64; i++)
+        meshes.push_back(Mesh(vertices, indices, vector<Texture>(1, texture)));
+
+    GLState::frame();
+    for(auto _ : state){
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].Draw(shader);
+        glFinish();
+    }
+    state.SetItemsProcessed(state.iterations() * meshes.size());
+    char label[64];
+    snprintf(label, sizeof(label), "%.1f chamadas, %.1f evitadas por desenho", (double) GLState::issued / (state.iterations() * meshes.size()),
+             (double) GLState::elided / (state.iterations() * meshes.size()));
+    state.SetLabel(label);
+    Residency::release(texture.id);
+    GLState::deleteProgram(shader.ID);
+}//BM_MeshDraw
+BENCHMARK(BM_MeshDraw);
+
+// UniformRing::push: o bloco "Object" de cada desenho, 64 por frame
+static void BM_UniformRingPush(benchmark::State &state){
+    if(not context()){
+        state.SkipWithError("sem contexto OpenGL (EGL)");
+        return;
+    }
+    UniformRing ring(64 * sizeof(ObjectData));
+    ObjectData object = {glm::mat4(1.0f)};
+
+    for(auto _ : state){
+        ring.begin();
+        for(int i = 0; i < 64; i++){
+            object.model[3][0] = (float) i;
+            ring.push(OBJECT_BINDING, &object, sizeof(ObjectData));
+        }
+        ring.end();
+    }
+    state.SetItemsProcessed(state.iterations() * 64);
+    state.SetLabel(UniformRing::persistent ? "persistente" : "glBufferSubData");
+}//BM_UniformRingPush
+BENCHMARK(BM_UniformRingPush);
@@ -0,0 +1,77 @@
+// Microbenchmarks do núcleo da simulação (sem OpenGL): matrizes dos
+// planetas e das luas e o passo completo.
+// Os planetas e luas são copiados do catálogo até o número pedido.
+
+#include <benchmark/benchmark.h>
+
+#include <solarsystem/simulation.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// N planetas, repetindo o catálogo
+static void makePlanets(deque<Planet> &planets, unsigned int count){
+    vector<BodyInfo> info = planetCatalogue();
+    for(unsigned int i = 0; i < count; i++){
+        BodyInfo &b = info[i % info.size()];
+        Planet p(b.name, b.scale, b.orbit, b.rotation, b.distance);
+        p.setReal(b.realDiameter, b.realDistance);
+        planets.push_back(p);
+    }
+}//makePlanets
+
+// N luas, repetindo o catálogo, cada uma presa a um dos planetas
+static void makeMoons(deque<Moon> &moons, deque<Planet> &planets, unsigned int count){
+    vector<BodyInfo> info = moonCatalogue();
+    for(unsigned int i = 0; i < count; i++){
+        BodyInfo &b = info[i % info.size()];
+        Moon m(b.name, b.scale, b.orbit, b.rotation, b.distance, &planets[i % planets.size()]);
+        m.setReal(b.realDiameter, b.realDistance);
+        moons.push_back(m);
+    }
+}//makeMoons
+
+// Planet::render para N planetas
+static void BM_PlanetRender(benchmark::State &state){
+    deque<Planet> planets;
+    makePlanets(planets, state.range(0));
+
+    for(auto _ : state){
+        Simulation::tick(0.016f);
+        for(unsigned int i = 0; i < planets.size(); i++)
+            benchmark::DoNotOptimize(planets[i].render());
+    }
+    state.SetItemsProcessed(state.iterations() * planets.size());
+}//BM_PlanetRender
+BENCHMARK(BM_PlanetRender)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+// Moon::render para N luas (as posições dos planetas já calculadas)
+static void BM_MoonRender(benchmark::State &state){
+    deque<Planet> planets;
+    deque<Moon> moons;
+    makePlanets(planets, planetCatalogue().size());
+    makeMoons(moons, planets, state.range(0));
+    for(unsigned int i = 0; i < planets.size(); i++)
+        planets[i].render();
+
+    for(auto _ : state){
+        Simulation::tick(0.016f);
+        for(unsigned int i = 0; i < moons.size(); i++)
+            benchmark::DoNotOptimize(moons[i].render());
+    }
+    state.SetItemsProcessed(state.iterations() * moons.size());
+}//BM_MoonRender
+BENCHMARK(BM_MoonRender)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+// Um passo do sistema solar do catálogo, como no SolarSim
+static void BM_SimulationStep(benchmark::State &state){
+    Simulation simulation;
+
+    for(auto _ : state)
+        simulation.step(0.016f);
+    state.SetItemsProcessed(state.iterations() * (simulation.planets.size() + simulation.moons.size()));
+}//BM_SimulationStep
+BENCHMARK(BM_SimulationStep);
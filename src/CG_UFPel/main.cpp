@@ -13,32 +13,83 @@
 #include <solarsystem/sun.h>
 #include <solarsystem/planet.h>
 #include <solarsystem/moon.h>
-
+#include <solarsystem/simulation.h>
+#include <solarsystem/stressscene.h>
+#include <solarsystem/starbox.h>
+#include <solarsystem/depth.h>
+#include <solarsystem/uniforms.h>
+#include <solarsystem/profiler.h>
+#include <solarsystem/trace.h>
+#include <solarsystem/offscreen.h>
+#include <solarsystem/camerapath.h>
+#include <solarsystem/recorder.h>
+#include <solarsystem/inputlog.h>
+#include <solarsystem/benchmark.h>
+#include <solarsystem/throttle.h>
+#include <solarsystem/controls.h>
+#include <solarsystem/hud.h>
+#include <solarsystem/log.h>
+#include <solarsystem/asset.h>
+#include <solarsystem/terrain.h>
+#include <solarsystem/virtualtexture.h>
+#include <solarsystem/packio.h>
+#include <solarsystem/indirect.h>
+#include <solarsystem/glstate.h>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <sstream>
 #include <string>
 
 // Original functions of the project
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void refresh_callback(GLFWwindow* window);
 void processInput(GLFWwindow *window);
+void bindControls(); // Mapa de teclas das ações
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+void char_callback(GLFWwindow* window, unsigned int codepoint);
+void resize(int width, int height); // Ajusta a cena ao tamanho da janela
+void zoom(float offset); // Muda o campo de visão da câmera
+void applyInput(vector<InputEvent> events); // Eventos do replay
+void replayReport(unsigned long frames, double seconds); // Resultado do replay
+void latencyReport(); // Latência da entrada até o frame apresentado
 
 // Funções de Alocação de Modelos
 void allocate_sun(); // Sol
 void allocate_planets(); // Planetas
 void allocate_moons(); // Luas
 void allocate_ship(); // Nave
+void allocate_virtual(); // Texturas virtuais dos planetas (--virtual-texture)
+void allocate_arena(GLADloadproc load); // Malhas da cena sintética num buffer só (--submit)
+void loadAssets(); // Envia para a GPU os modelos que terminaram de carregar
+void startupReport(); // Tempo de inicialização e memória
 
 // Funções de renderização de Modelos
-void render_stars(Shader *ourShader, Model *stars); // Estrelas
+void render_stars(Shader *ourShader); // Estrelas
 void render_sun(Shader *ourShader); // Sol
 void render_planets(Shader *ourShader); // Planetas
 void render_moons(Shader *ourShader); // Luas
 void render_ship(Shader *ourShader); // Nave
+void render_terrain(Shader *ourShader); // Terreno do planeta próximo (modo 3)
+void render_virtual(int planet, const glm::mat4 &matrix, bool chunks, Shader *ourShader); // Planeta com textura virtual
+void render_feedback(); // Páginas pedidas pelas texturas virtuais
+void render_stress(Shader *ourShader); // Cena sintética (--scene)
+void setModel(glm::mat4 model); // Envia a matriz do objeto
+void setDetail(const glm::mat4 &model); // Tamanho na tela do corpo, para o streaming de mips
+void render_frame(Shader *ourShader, Shader *logShader, Shader *overlayShader); // Desenha um frame completo
 
 // Funções da Câmera
-void up_vision(Shader *ourShader); // Modo 1
-void pick_vision(Shader *ourShader); // Modo 2
-void ship_vision(Shader *ourShader); // Modo 3
+void up_vision(); // Modo 1
+void pick_vision(); // Modo 2
+void ship_vision(); // Modo 3
+glm::mat4 getProjection(); // Projeção da câmera
+void updateFrame(); // Envia os dados da câmera do frame
 glm::vec3 distance_vision(); // Distância da visão do planeta
 glm ::vec3 getMoonPosition(); // Posição da lua
 float getMoonScale(); // Scale da lua
@@ -47,27 +98,36 @@ glm::vec3 camPosition(); // Posição da Câmera
 void updateCameraOnShip(); // Atualiza a câmera da Nave
 glm::vec3 rightFromShip(); // Retorna o Right da nave
 glm::mat4 checkShip(); // Checa se a nave não está saindo do mundo
-
-// Função do Botão
-bool processButton(); // Apertou um botão
-void freeButton(); // Largou o botão
+float worldScale(); // Tamanho do mundo em relação à escala padrão
+void path_vision(CameraKey key); // Aplica uma chave do caminho da câmera
+double getTime(); // Relógio do frame (GLFW ou o do modo sem janela)
 
 // Função que inicializa as variaveis
 void initialize();
 
 // Funções pro funcionamento do jogo
 void pauseGame(); // Pausar o jogo
+void saveProfile(); // Grava o perfil dos passos
+void trueScale(); // Liga/desliga a escala real
+void record(); // Começa/termina a gravação de vídeo
 void passingTime(); // Processa o tempo
+unsigned long long sceneHash(); // Estado que muda a imagem
+void waitEvents(float seconds); // Bloqueia até um evento ou o tempo acabar
 
-// Funções que imprimem as informações
-void info();
-void info_mode_1();
-void info_mode_2();
-void info_mode_3();
+// Modo sem janela
+bool parseOptions(int argc, char **argv); // Lê a linha de comando
+int render_offscreen(Shader *ourShader, Shader *logShader, Shader *overlayShader); // Gera os frames do caminho
+
+// Informações do estado e dos comandos
+void info(); // Avisa no terminal a troca de modo
+string visionName(); // Nome do corpo observado no modo 2
+vector<string> commands(); // Comandos do modo atual
+void updateHud(); // Monta o texto da tela
 
 // settings
-const unsigned int SCR_WIDTH = 800;
-const unsigned int SCR_HEIGHT = 600;
+unsigned int SCR_WIDTH = 800;
+unsigned int SCR_HEIGHT = 600;
+const float Z_FAR = 1000.0f;
 
 // camera
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
@@ -109,101 +169,310 @@ Vision vision;
 
 // Struct da nave
 typedef struct{
-    vector<tuple<Model, glm::mat4>> ship;
+    LazyModel model;  // carregado na primeira vez que o modo 3 é pedido ou previsto
+    glm::mat4 matrix;
     float scale;
     float speed;
 }Ship;
 Ship ship;
+string shipLoading = "lazy"; // lazy, prefetch ou eager (--ship)
+
+// Terreno de perto no modo 3: planetas com terreno (--terrain), distância
+// em raios a partir da qual a esfera é trocada e o planeta desenhado no frame
+Terrain terrain;
+vector<string> terrainBodies = {"Mercury", "Venus", "Earth", "Mars"};
+float terrainRange = 6.0f;
+int terrainBody = -1;
+
+// Texturas virtuais (--virtual-texture CORPO=ARQUIVO): índice de cada
+// planeta em virtualTextures (-1 = textura comum) e os desenhos do frame,
+// repetidos no buffer de feedback
+typedef struct{
+    int planet;
+    glm::mat4 matrix;
+    bool terrain;  // desenhado pelos blocos do terreno
+}VirtualDraw;
+vector<pair<string, string> > virtualSpecs;
+vector<VirtualTexture*> virtualTextures;
+vector<int> planetVirtual;
+vector<VirtualDraw> virtualDraws;
+VirtualFeedback feedback;
+Shader *virtualShader;
+Shader *feedbackShader;
 
-// Botão 
-bool button;
+// Pacote de assets (--pack), gerado pelo SolarPack
+string packFile;
+
+// Inicialização: início do programa e memória residente antes da nave (kB)
+chrono::steady_clock::time_point launch = chrono::steady_clock::now();
+long startupRss = 0;
+
+// Fundo de estrelas
+StarBox *starBox;
+
+// Uniforms do frame e dos objetos
+FrameData frame;
+UniformRing *frameRing;
+UniformRing *objectRing;
+
+// Perfil do frame (tempo de CPU e GPU de cada passo)
+Profiler profiler;
+
+// Entrada por eventos: fila dos callbacks e mapa de ações
+Controls controls;
 
 // Modo de câmera
 int mode;
 
+// Texto na tela: estado, tempos e ajuda (tecla H)
+Hud hud;
+Shader *hudShader;
+bool help = false;
+double hudTime = 0.0;             // última vez que o texto foi montado
+double hudLast = 0.0;             // frame anterior
+float hudFrameMs = 0.0f;          // média móvel do tempo de frame
+unsigned long long hudState = 0;  // hash do estado mostrado
+
+// Renderização sem janela (--offscreen): contexto EGL, caminho da câmera e saída
+typedef struct{
+    bool enabled;
+    int frames;   // 0 = duração do caminho
+    float fps;    // frames por segundo do vídeo (passo fixo de tempo)
+    string path;  // arquivo do caminho, vazio = caminho padrão
+    string out;   // prefixo dos arquivos PPM, vazio = não grava
+    double time;  // relógio do frame
+}Headless;
+Headless headless = {false, 0, 30.0f, "", "frame_", 0.0};
+Offscreen offscreen;
+
+// Gravação assíncrona dos frames (tecla R ou --record)
+Recorder recorder;
+string recordSpec = "y4m:capture.y4m";
+int recordFps = 60;
+bool recordAtStart = false;
+
+// Gravação e replay da entrada com dt fixo (--record-input, --replay)
+InputLog input;
+
+// Renderização sob demanda e limite de frames (--on-demand, --max-fps)
+FrameThrottle throttle;
+
+// Cena sintética para testes de carga (--scene N:M:K)
+StressScene stress;
+unsigned int stressSize[3] = {0, 0, 0};
+
+// Envio da cena sintética (--submit): arena com multi-draw indireto, em laço ou Mesh::Draw
+DrawArena arena;
+string submitPath = "indirect";
+vector<int> arenaPlanets, arenaMoons;
+Shader *indirectShader;
+Shader *indirectLogShader;
+
+// Benchmark com roteiro de câmera (--benchmark)
+Benchmark bench;
+string benchmarkScenario;
+string benchmarkOut = "benchmark.json";
+unsigned int benchmarkWarmup = 120;
+
 // Função Main
-int main(){
-    // glfw: initialize and configure
-    // ------------------------------
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    #ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
-    #endif
-
-    // glfw window creation
-    // --------------------
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Solar System Simulator", NULL, NULL);
-    if (window == NULL)
-    {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetScrollCallback(window, scroll_callback);
-
-    // tell GLFW to capture our mouse
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
-    // glad: load all OpenGL function pointers
-    // ---------------------------------------
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-    {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        return -1;
+int main(int argc, char **argv){
+    TRACE_THREAD("main");
+
+    if(not parseOptions(argc, argv))
+        return 1;
+
+    // Sem janela: contexto EGL e framebuffer próprio no lugar do GLFW
+    GLFWwindow* window = NULL;
+    GLADloadproc loader = (GLADloadproc)glfwGetProcAddress;
+    if(headless.enabled){
+        if(not offscreen.create(SCR_WIDTH, SCR_HEIGHT))
+            return -1;
+        loader = Offscreen::loader();
+        Depth::output = offscreen.target();
     }
+    else{
+        // glfw: initialize and configure
+        // ------------------------------
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+        #ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
+        #endif
+
+        // glfw window creation
+        // --------------------
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Solar System Simulator", NULL, NULL);
+        if (window == NULL)
+        {
+            std::cout << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        glfwSetScrollCallback(window, scroll_callback);
+        glfwSetWindowRefreshCallback(window, refresh_callback);
+        glfwSetKeyCallback(window, key_callback);
+        glfwSetCharCallback(window, char_callback);
+
+        // tell GLFW to capture our mouse
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+        // glad: load all OpenGL function pointers
+        // ---------------------------------------
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+        {
+            std::cout << "Failed to initialize GLAD" << std::endl;
+            return -1;
+        }
+    }//else
 
     // configure global opengl state
     // -----------------------------
     glEnable(GL_DEPTH_TEST);
 
+    // Z invertido quando houver glClipControl, senão profundidade logarítmica
+    Depth::init(loader, SCR_WIDTH, SCR_HEIGHT);
+    Depth::setMode(DEPTH_REVERSED);
+
+    // Anéis de uniforms: câmera uma vez por frame, objetos com offset dinâmico
+    UniformRing::init(loader);
+    Recorder::init(loader);
+    UniformRing frame_ring(4 * sizeof(FrameData));
+    UniformRing object_ring(64 * sizeof(ObjectData));
+    frameRing = &frame_ring;
+    objectRing = &object_ring;
+
     // build and compile shaders
     // -------------------------
     Shader ourShader(FileSystem::getPath("resources/cg_ufpel.vs").c_str(), FileSystem::getPath("resources/cg_ufpel.fs").c_str());
+    Shader logShader(FileSystem::getPath("resources/cg_ufpel.vs").c_str(), FileSystem::getPath("resources/cg_ufpel_log.fs").c_str());
+    UniformRing::attach(&ourShader);
+    UniformRing::attach(&logShader);
+    Shader overlayShader(FileSystem::getPath("resources/overlay.vs").c_str(), FileSystem::getPath("resources/overlay.fs").c_str());
+
+    // Texturas virtuais: desenho e feedback
+    Shader virtual_shader(FileSystem::getPath("resources/cg_ufpel.vs").c_str(), FileSystem::getPath("resources/virtual.fs").c_str());
+    Shader feedback_shader(FileSystem::getPath("resources/cg_ufpel.vs").c_str(), FileSystem::getPath("resources/virtual_feedback.fs").c_str());
+    UniformRing::attach(&virtual_shader);
+    UniformRing::attach(&feedback_shader);
+    virtualShader = &virtual_shader;
+    feedbackShader = &feedback_shader;
+
+    // Cena sintética pela arena: a matriz vem de um atributo
+    Shader indirect_shader(FileSystem::getPath("resources/indirect.vs").c_str(), FileSystem::getPath("resources/cg_ufpel.fs").c_str());
+    Shader indirect_log_shader(FileSystem::getPath("resources/indirect.vs").c_str(), FileSystem::getPath("resources/cg_ufpel_log.fs").c_str());
+    UniformRing::attach(&indirect_shader);
+    UniformRing::attach(&indirect_log_shader);
+    indirectShader = &indirect_shader;
+    indirectLogShader = &indirect_log_shader;
+
+    // Texto na tela
+    Shader hud_shader(FileSystem::getPath("resources/hud.vs").c_str(), FileSystem::getPath("resources/hud.fs").c_str());
+    hudShader = &hud_shader;
+    hud.create();
 
     // Modelo das Estrelas
     Model stars(FileSystem::getPath("resources/objects/Stars/stars.obj"));
 
+    // Fundo de estrelas, renderizado uma vez em um cubemap
+    Shader captureShader(FileSystem::getPath("resources/stars_capture.vs").c_str(), FileSystem::getPath("resources/stars_capture.fs").c_str());
+    Shader skyShader(FileSystem::getPath("resources/skybox.vs").c_str(), FileSystem::getPath("resources/skybox.fs").c_str());
+    StarBox stars_box(&stars, &captureShader, &skyShader);
+    stars_box.setResolution(SCR_WIDTH, SCR_HEIGHT, camera.Zoom);
+    starBox = &stars_box;
+
     // Inicializa as variaveis
     initialize();
+    if(stress.bodies() and submitPath != "mesh")
+        allocate_arena(loader);
+    startupReport();
+
+    // Frames do caminho da câmera gravados em disco
+    if(headless.enabled){
+        if(recordAtStart and not recorder.start(recordSpec, SCR_WIDTH, SCR_HEIGHT, recordFps, RECORD_BLOCK))
+            return 1;
+
+        int result = render_offscreen(&ourShader, &logShader, &overlayShader);
+        terrain.clear();
+        Log::stop();
+        cout << Residency::summary() << endl;
+        if(Vfs::mounted())
+            cout << Vfs::summary() << endl;
+        cout << MeshCook::summary() << endl;
+        cout << Simplify::summary() << endl;
+        cout << GLState::summary() << endl;
+        for(unsigned int i = 0; i < virtualTextures.size(); i++){
+            cout << virtualTextures[i]->summary() << endl;
+            virtualTextures[i]->destroy();
+        }
+        TRACE_SAVE("trace.json");
+        offscreen.destroy();
+        return result;
+    }
+
+    if(recordAtStart)
+        record();
+
+    // O replay e o benchmark rodam o mais rápido possível, sem vsync
+    if(input.mode == INPUT_REPLAY or not benchmarkScenario.empty())
+        glfwSwapInterval(0);
+
+    // Sob demanda só na sessão interativa: gravações e medições querem todos os frames
+    if(input.mode != INPUT_LIVE or not benchmarkScenario.empty())
+        throttle.onDemand = false;
+    // O limite de frames dorme no lugar do vsync
+    if(throttle.maxFps > 0.0f)
+        glfwSwapInterval(0);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
     
     // render loop
     while (!glfwWindowShouldClose(window)){
         // per-frame time logic
         // --------------------
+        chrono::steady_clock::time_point frameStart = chrono::steady_clock::now();
         float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
+        deltaTime = input.step(currentFrame - lastFrame);
         lastFrame = currentFrame;
+        if(not benchmarkScenario.empty())
+            deltaTime = 1.0f / 60.0f;
+
+        // Eventos do replay neste frame
+        applyInput(input.begin(Planet::time));
+        if(input.finished())
+            break;
+
+        TRACE_ZONE("frame");
+        TRACE_COUNTER("deltaTime_ms", deltaTime * 1000.0f);
 
         // input
         // -----
-        processInput(window);
+        if(benchmarkScenario.empty())
+            processInput(window);
+        else
+            path_vision(bench.begin());
+
+        // Modelos que terminaram de carregar
+        loadAssets();
+
+        // Nada mudou: espera eventos em vez de redesenhar
+        if(not recorder.active() and throttle.idle(sceneHash())){
+            waitEvents(throttle.idleWait);
+            lastFrame = glfwGetTime(); // o tempo parado não vira deltaTime
+            throttle.report(profiler.gpuBusy);
+            continue;
+        }
+        profiler.frame();
 
         // render
         // ------
-        glClearColor(0.00f, 0.00f, 0.00f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        render_frame(&ourShader, &logShader, &overlayShader);
 
-        // don't forget to enable shader before setting uniforms
-        ourShader.use();
-
-        // Decide em qual modo de câmera está
-        switch(mode){
-            case 1: up_vision(&ourShader);   break;
-            case 2: pick_vision(&ourShader); break;
-            case 3: ship_vision(&ourShader); break;
-        }
-
-        // Chama as renderizações
-        render_stars(&ourShader, &stars);
-        render_sun(&ourShader);
-        render_planets(&ourShader);
-        render_moons(&ourShader);
+        // Leitura assíncrona do frame, se estiver gravando
+        recorder.capture(Depth::output);
 
         // Passando o tempo do jogo
         passingTime();
@@ -211,141 +480,516 @@ int main(){
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
         glfwSwapBuffers(window);
+        controls.presented(Controls::now());
         glfwPollEvents();
+        input.end();
+        throttle.frame();
+        throttle.report(profiler.gpuBusy);
+
+        // Tempo do frame inteiro, com a troca de buffers
+        float ms = chrono::duration<float, milli>(chrono::steady_clock::now() - frameStart).count();
+        if(not benchmarkScenario.empty() and bench.end(ms, profiler))
+            break;
+    }
+
+    // O que ficou no log sai antes dos relatórios
+    terrain.clear();
+    Log::stop();
+
+    if(not benchmarkScenario.empty())
+        bench.write(benchmarkOut, profiler, SCR_WIDTH, SCR_HEIGHT, Depth::name());
+    throttle.summary(profiler.gpuBusy);
+    latencyReport();
+    cout << Residency::summary() << endl;
+    if(Vfs::mounted())
+        cout << Vfs::summary() << endl;
+    cout << MeshCook::summary() << endl;
+    cout << Simplify::summary() << endl;
+    cout << GLState::summary() << endl;
+    for(unsigned int i = 0; i < virtualTextures.size(); i++){
+        cout << virtualTextures[i]->summary() << endl;
+        virtualTextures[i]->destroy();
     }
 
+    if(input.mode == INPUT_REPLAY)
+        replayReport(input.frame, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    input.stop(Planet::time);
+
+    // Grava o perfil da última janela de frames
+    saveProfile();
+    recorder.stop();
+    TRACE_SAVE("trace.json");
+
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
     glfwTerminate();
     return 0;
 }//main
 
-// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// Lê as opções da linha de comando
+bool parseOptions(int argc, char **argv){
+    for(int i = 1; i < argc; i++){
+        string arg = argv[i];
+        bool value = i + 1 < argc;
+
+        if(arg == "--offscreen")
+            headless.enabled = true;
+        else if(arg == "--frames" and value)
+            headless.frames = atoi(argv[++i]);
+        else if(arg == "--fps" and value)
+            headless.fps = atof(argv[++i]);
+        else if(arg == "--path" and value)
+            headless.path = argv[++i];
+        else if(arg == "--out" and value)
+            headless.out = argv[++i];
+        else if(arg == "--no-write")
+            headless.out = "";
+        else if(arg == "--size" and value)
+            sscanf(argv[++i], "%ux%u", &SCR_WIDTH, &SCR_HEIGHT);
+        else if(arg == "--record" and value){
+            recordSpec = argv[++i];
+            recordAtStart = true;
+        }
+        else if(arg == "--record-fps" and value)
+            recordFps = atoi(argv[++i]);
+        else if(arg == "--record-input" and value)
+            input.record(argv[++i]);
+        else if(arg == "--replay" and value){
+            if(not input.replay(argv[++i]))
+                return false;
+        }
+        else if(arg == "--dt" and value)
+            input.dt = atof(argv[++i]);
+        else if(arg == "--benchmark" and value)
+            benchmarkScenario = argv[++i];
+        else if(arg == "--warmup" and value)
+            benchmarkWarmup = atoi(argv[++i]);
+        else if(arg == "--benchmark-out" and value)
+            benchmarkOut = argv[++i];
+        else if(arg == "--on-demand")
+            throttle.onDemand = true;
+        else if(arg == "--max-fps" and value)
+            throttle.maxFps = atof(argv[++i]);
+        else if(arg == "--scene" and value)
+            sscanf(argv[++i], "%u:%u:%u", &stressSize[0], &stressSize[1], &stressSize[2]);
+        else if(arg == "--no-hud")
+            hud.visible = false;
+        else if(arg == "--ship" and value)
+            shipLoading = argv[++i];
+        else if(arg == "--vram-budget" and value)
+            Residency::budget = (unsigned long) (atof(argv[++i]) * 1048576.0);
+        else if(arg == "--no-mip-streaming")
+            Residency::streaming = false;
+        else if(arg == "--terrain" and value){
+            terrainBodies.clear();
+            stringstream list(argv[++i]);
+            string name;
+            while(getline(list, name, ','))
+                if(name != "none")
+                    terrainBodies.push_back(name);
+        }
+        else if(arg == "--terrain-error" and value)
+            Terrain::pixelError = atof(argv[++i]);
+        else if(arg == "--virtual-texture" and value){
+            string spec = argv[++i];
+            size_t equal = spec.find('=');
+            if(equal == string::npos){
+                cout << "--virtual-texture espera CORPO=ARQUIVO" << endl;
+                return false;
+            }
+            virtualSpecs.push_back(make_pair(spec.substr(0, equal), spec.substr(equal + 1)));
+        }
+        else if(arg == "--vt-cache" and value)
+            VirtualTexture::cacheSize = atoi(argv[++i]);
+        else if(arg == "--pack" and value)
+            packFile = argv[++i];
+        else if(arg == "--no-cook")
+            MeshCook::enabled = false;
+        else if(arg == "--lod-error" and value)
+            Simplify::pixelError = atof(argv[++i]);
+        else if(arg == "--submit" and value and (string(argv[i + 1]) == "indirect" or string(argv[i + 1]) == "loop" or
+                                                 string(argv[i + 1]) == "mesh"))
+            submitPath = argv[++i];
+        else{
+            cout << "uso: CG_UFPel [opções]" << endl;
+            cout << "  --offscreen     renderiza sem janela (EGL) seguindo um caminho de câmera" << endl;
+            cout << "  --path ARQUIVO  caminho da câmera (padrão: caminho embutido)" << endl;
+            cout << "  --frames N      número de frames (padrão: duração do caminho)" << endl;
+            cout << "  --fps F         frames por segundo do caminho (padrão 30)" << endl;
+            cout << "  --size LxA      resolução (padrão 800x600)" << endl;
+            cout << "  --out PREFIXO   prefixo dos frames PPM (padrão frame_)" << endl;
+            cout << "  --no-write      não grava os frames, só mede a vazão" << endl;
+            cout << "  --record SAIDA  grava vídeo: y4m:arquivo.y4m, ppm:prefixo ou pipe:arquivo.mp4 (ffmpeg)" << endl;
+            cout << "                  (na janela a tecla R começa/termina; padrão y4m:capture.y4m)" << endl;
+            cout << "  --record-fps F  frames por segundo do vídeo gravado (padrão 60)" << endl;
+            cout << "  --record-input ARQUIVO  grava teclas, scroll e resize com dt fixo" << endl;
+            cout << "  --replay ARQUIVO        repete uma entrada gravada (também com --offscreen)" << endl;
+            cout << "  --dt S                  passo fixo da gravação de entrada (padrão 1/60)" << endl;
+            cout << "  --benchmark CENARIO     tour, overview, planets, ship ou arquivo de caminho;" << endl;
+            cout << "                          mede --frames frames (padrão 600) sem vsync" << endl;
+            cout << "  --warmup N              frames de aquecimento do benchmark (padrão 120)" << endl;
+            cout << "  --benchmark-out ARQUIVO relatório JSON (padrão benchmark.json)" << endl;
+            cout << "  --on-demand             só redesenha quando a cena ou a câmera mudam" << endl;
+            cout << "  --max-fps F             limita os frames por segundo dormindo, sem vsync" << endl;
+            cout << "  --scene N:M:K           soma ao sistema N planetas com M luas cada e K asteroides" << endl;
+            cout << "  --no-hud                esconde o texto da tela" << endl;
+            cout << "  --ship lazy|prefetch|eager  carrega a nave no primeiro modo 3 (padrão), em" << endl;
+            cout << "                          segundo plano desde o início, ou antes do primeiro frame" << endl;
+            cout << "  --vram-budget MB        orçamento das texturas e malhas; o excesso é reduzido" << endl;
+            cout << "                          ou despejado na ordem do uso mais antigo (padrão: sem limite)" << endl;
+            cout << "  --no-mip-streaming      carrega as texturas inteiras, sem o nível pelo tamanho na tela" << endl;
+            cout << "  --terrain LISTA         planetas com terreno de perto no modo 3, separados por vírgula," << endl;
+            cout << "                          ou none (padrão Mercury,Venus,Earth,Mars)" << endl;
+            cout << "  --terrain-error PX      erro na tela que divide um bloco do terreno (padrão 6)" << endl;
+            cout << "  --virtual-texture CORPO=ARQUIVO  mapa do planeta como textura virtual, em páginas" << endl;
+            cout << "                          lidas do disco sob demanda (mapas de 32k e maiores)" << endl;
+            cout << "  --vt-cache PX           lado da textura de páginas carregadas (padrão 4096)" << endl;
+            cout << "  --pack ARQUIVO          lê modelos, texturas e shaders do pacote (SolarPack);" << endl;
+            cout << "                          o que não estiver nele vem do disco" << endl;
+            cout << "  --no-cook               usa as malhas como o Assimp entrega, sem soldar os vértices" << endl;
+            cout << "                          nem reordenar os triângulos" << endl;
+            cout << "  --lod-error PX          desvio na tela aceito ao simplificar a nave (padrão 1; 0 desenha" << endl;
+            cout << "                          sempre a malha cheia)" << endl;
+            cout << "  --submit indirect|loop|mesh  envio da cena sintética: um multi-draw indireto por" << endl;
+            cout << "                          material (padrão; em laço sem GL 4.3), um desenho por corpo" << endl;
+            cout << "                          na arena, ou o Mesh::Draw de cada modelo" << endl;
+            return false;
+        }
+    }
+
+    // Sem janela, no replay e no benchmark os mips são lidos na hora: os frames não dependem da thread
+    Residency::synchronous = headless.enabled or input.mode == INPUT_REPLAY or not benchmarkScenario.empty();
+    Terrain::synchronous = Residency::synchronous;
+    VirtualTexture::synchronous = Residency::synchronous;
+
+    // Assets do pacote; o que não estiver nele continua vindo do disco
+    if(not packFile.empty()){
+        if(not Vfs::mount(packFile, FileSystem::getPath(""))){
+            cout << "Pacote inválido: " << packFile << endl;
+            return false;
+        }
+        Model::ioSystem = &PackIOSystem::create;
+        cout << "Pacote " << packFile << ": " << Vfs::count() << " arquivos" << endl;
+    }
+
+    if(not benchmarkScenario.empty())
+        return bench.load(benchmarkScenario, benchmarkWarmup, headless.frames > 0 ? headless.frames : 600);
+    return true;
+}//parseOptions
+
+// Desenha um frame completo no framebuffer de saída
+void render_frame(Shader *ourShader, Shader *logShader, Shader *overlayShader){
+    Residency::frame();
+    GLState::frame();
+    frameRing->begin();
+    objectRing->begin();
+    Depth::begin();
+    glClearColor(0.00f, 0.00f, 0.00f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Shader dos objetos, de acordo com o modo de profundidade
+    Shader *shader = Depth::mode == DEPTH_LOGARITHMIC ? logShader : ourShader;
+
+    // don't forget to enable shader before setting uniforms
+    if(not virtualTextures.empty()){
+        virtualShader->use();
+        virtualShader->setFloat("logDepth", Depth::logarithmic(Z_FAR));
+        feedbackShader->use();
+        feedbackShader->setFloat("logDepth", Depth::logarithmic(Z_FAR));
+        virtualDraws.clear();
+    }
+    shader->use();
+    shader->setFloat("logDepth", Depth::logarithmic(Z_FAR));
+
+    // Decide em qual modo de câmera está
+    switch(mode){
+        case 1: up_vision();   break;
+        case 2: pick_vision(); break;
+        case 3: ship_vision(); break;
+    }
+    updateFrame();
+
+    // Chama as renderizações
+    profiler.begin("stars");
+    render_stars(shader);
+    profiler.end();
+
+    profiler.begin("sun");
+    render_sun(shader);
+    profiler.end();
+
+    terrainBody = -1;
+    if(mode == 3){
+        profiler.begin("terrain");
+        render_terrain(shader);
+        profiler.end();
+    }
+
+    profiler.begin("planets");
+    render_planets(shader);
+    profiler.end();
+
+    profiler.begin("moons");
+    render_moons(shader);
+    profiler.end();
+
+    if(stress.bodies())
+        render_stress(shader);
+
+    if(mode == 3){
+        profiler.begin("ship");
+        render_ship(shader);
+        profiler.end();
+    }
+
+    // Páginas que as texturas virtuais precisaram neste frame
+    if(not virtualDraws.empty()){
+        profiler.begin("vt_feedback");
+        render_feedback();
+        profiler.end();
+    }
+    for(unsigned int i = 0; i < virtualTextures.size(); i++)
+        virtualTextures[i]->update();
+
+    // Refaz o cubemap das estrelas, se foi invalidado
+    if(starBox->isDirty()){
+        profiler.begin("stars_capture");
+        starBox->update();
+        profiler.end();
+    }
+
+    // Barras do perfil
+    profiler.draw(overlayShader, hud, SCR_WIDTH, SCR_HEIGHT);
+
+    // Texto da tela, num draw call só
+    if(hud.visible){
+        updateHud();
+        hud.draw(hudShader, SCR_WIDTH, SCR_HEIGHT);
+    }
+
+    // Copia a cena para a saída (janela ou framebuffer sem janela)
+    Depth::end();
+    frameRing->end();
+    objectRing->end();
+
+    // Cargas de volta e orçamento de memória de vídeo
+    Residency::update();
+}//render_frame
+
+// Segue o caminho da câmera com passo fixo e grava cada frame em disco
+int render_offscreen(Shader *ourShader, Shader *logShader, Shader *overlayShader){
+    CameraPath path;
+    if(headless.path.empty())
+        path.builtin();
+    else if(not path.load(headless.path))
+        return 1;
+    if(path.uses(3))
+        ship.model.request();
+
+    // Com --replay a entrada gravada substitui o caminho da câmera
+    bool replaying = input.mode == INPUT_REPLAY;
+    int frames = headless.frames > 0 ? headless.frames : (int) (path.duration() * headless.fps);
+    if(replaying and headless.frames <= 0)
+        frames = INT_MAX;
+    deltaTime = replaying ? input.dt : 1.0f / headless.fps;
+
+    // Benchmark: aquecimento e medição com o roteiro do cenário
+    bool benchmarking = not benchmarkScenario.empty();
+    if(benchmarking){
+        frames = bench.total();
+        deltaTime = 1.0f / 60.0f;
+    }
+
+    double render = 0.0, write = 0.0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    int i;
+    for(i = 0; i < frames; i++){
+        TRACE_ZONE("frame");
+        profiler.frame();
+
+        headless.time = i * deltaTime;
+        if(replaying){
+            applyInput(input.begin(Planet::time));
+            if(input.finished())
+                break;
+            processInput(NULL);
+        }
+        else if(benchmarking)
+            path_vision(bench.begin());
+        else
+            path_vision(path.at(fmod(headless.time, path.duration())));
+
+        loadAssets();
+        chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+        render_frame(ourShader, logShader, overlayShader);
+        glFinish();
+        chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+
+        if(recorder.active())
+            recorder.capture(Depth::output);
+        else if(not headless.out.empty() and not benchmarking){
+            char name[32];
+            snprintf(name, sizeof(name), "%05d.ppm", i);
+            if(not offscreen.save(headless.out + name))
+                return 1;
+        }
+        chrono::steady_clock::time_point t2 = chrono::steady_clock::now();
+
+        render += chrono::duration<double>(t1 - t0).count();
+        write += chrono::duration<double>(t2 - t1).count();
+        if(benchmarking)
+            bench.end(chrono::duration<float, milli>(t2 - t0).count(), profiler);
+
+        passingTime();
+        input.end();
+    }
+    frames = i;
+
+    // Espera a gravação terminar, ela conta no tempo total
+    recorder.stop();
+
+    // Vazão para dimensionar os trabalhos de renderização
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if(replaying)
+        replayReport(frames, seconds);
+    if(benchmarking)
+        bench.write(benchmarkOut, profiler, SCR_WIDTH, SCR_HEIGHT, Depth::name());
+    cout << frames << " frames " << SCR_WIDTH << "x" << SCR_HEIGHT << " em " << seconds << " s: "
+         << frames / seconds << " frames/s (render " << 1000.0 * render / frames
+         << " ms/frame, gravação " << 1000.0 * write / frames << " ms/frame)" << endl;
+
+    saveProfile();
+    return 0;
+}//render_offscreen
+
+// Processa as ações do frame: os eventos da fila viram apertos (borda) e teclas seguradas
 void processInput(GLFWwindow *window){
+    TRACE_ZONE("processInput");
+
+    // Eventos do frame, gravados no log de entrada
+    vector<ControlEvent> events = controls.update();
+    for(unsigned int i = 0; i < events.size(); i++){
+        if(events[i].text)
+            input.character(events[i].code, Planet::time);
+        else
+            input.key(events[i].code, events[i].state, Planet::time);
+    }
+    if(events.empty() and controls.idle())
+        return;
+
+    // Qualquer ação pode mudar estado que o sceneHash não vê: o próximo frame é desenhado
+    throttle.invalidate();
+
     // Sair do programa
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS){
-        glfwSetWindowShouldClose(window, true);
+    if (controls.pressed(ACTION_QUIT)){
+        if(window)
+            glfwSetWindowShouldClose(window, true);
         return;
     }//if
 
+    // Troca o modo de profundidade
+    if (controls.pressed(ACTION_DEPTH)){
+        Depth::next();
+        Log::print("Profundidade: " + Depth::name());
+    }//if
+
+    // Mostra/esconde o perfil dos passos
+    if (controls.pressed(ACTION_PROFILER))
+        profiler.visible = not profiler.visible;
+
+    // Mostra/esconde a lista de comandos
+    if (controls.pressed(ACTION_HELP))
+        help = not help;
+
+    // Grava o perfil dos passos
+    if (controls.pressed(ACTION_SAVE_PROFILE))
+        saveProfile();
+
+    // Gravação de vídeo
+    if (controls.pressed(ACTION_RECORD))
+        record();
+
+    // Escala real
+    if (controls.pressed(ACTION_TRUE_SCALE))
+        trueScale();
+
     // Troca do tipo de câmera
-    if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS){
+    if (controls.pressed(ACTION_MODE_1)){
         mode = 1;
         info();
-        return;
     }//if
-    if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS){
+    if (controls.pressed(ACTION_MODE_2)){
         mode = 2;
         Planet::worldSpeed = 1;
         info();
-        return;
     }//if
-    if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS){
+    if (controls.pressed(ACTION_MODE_3)){
         mode = 3;
+        ship.model.request();
         info();
-        return;
     }//if
 
     // Comandos que funcionam no modo 1 e no modo 2
     if (mode == 1 or mode == 2){
         
         // Comando para pausar o jogo
-        if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS){
-            if(processButton())
-                return;
-
+        if (controls.pressed(ACTION_PAUSE))
             pauseGame();
-            return;
-        }//if
 
         // Acelera o mundo
-        if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS){
-            if(processButton())
-                return;
-
+        for(int i = controls.pressed(ACTION_FASTER); i > 0; i--){
             Planet::worldSpeed++;
             if(Planet::worldSpeed > 20)
                 Planet::worldSpeed = 20;
 
             if(mode == 2 and Planet::worldSpeed > 3)
                 Planet::worldSpeed = 3;
-
-            return;
-        }//if
+        }//for
         // Desacelera o mundo
-        if (glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS){
-            if(processButton())
-                return;
-
+        for(int i = controls.pressed(ACTION_SLOWER); i > 0; i--){
             Planet::worldSpeed--;
             if(Planet::worldSpeed < 1)
                 Planet::worldSpeed = 1;
-
-            return;
-        }//if
+        }//for
     }//if
 
     // Comandos do modo 2
     if (mode == 2){
 
         // Easter Egg - Terra Plana
-        if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS){
-            if(processButton())
-                return;
-
+        if (controls.pressed(ACTION_FLAT_EARTH))
             Planet::plane = not Planet::plane;
-            return;
-        }//if
 
         // Troca de Planetas
-        if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS){
-            if(processButton())
-                return;
-
+        for(int i = controls.pressed(ACTION_PREVIOUS_PLANET); i > 0; i--){
             vision.moon = -1;
             vision.planet--;
             if (vision.planet < 0)
                 vision.planet = 7;
-
-            return;
-        }//if
-        if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS){
-            if(processButton())
-                return;
-
+        }//for
+        for(int i = controls.pressed(ACTION_NEXT_PLANET); i > 0; i--){
             vision.moon = -1;
             vision.planet++;
             if (vision.planet > 7)
                 vision.planet = 0;
+        }//for
 
-            return;
-        }//if
-
-        // Se tiver luas, tem como trocar de planeta
-        if (get<0>(planets.planet[vision.planet]).getMoons() > 0){
-            //Troca de luas
-            if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS){
-                if(processButton())
-                    return;
-
+        // Se tiver luas, tem como trocar de lua
+        int qtMoons = get<0>(planets.planet[vision.planet]).getMoons();
+        if (qtMoons > 0){
+            for(int i = controls.pressed(ACTION_UP); i > 0; i--){
                 vision.moon++;
-                if (vision.moon >= (int) get<0>(planets.planet[vision.planet]).getMoons())
+                if (vision.moon >= qtMoons)
                     vision.moon = -1;
-
-                return;
-            }//if
-            if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS){
-                if(processButton())
-                    return;
-
+            }//for
+            for(int i = controls.pressed(ACTION_DOWN); i > 0; i--){
                 vision.moon--;
                 if (vision.moon == -2)
-                    vision.moon = get<0>(planets.planet[vision.planet]).getMoons() -1;
+                    vision.moon = qtMoons -1;
                 else if(vision.moon < 0)
                     vision.moon = -1;
-
-                return;
-            }//if
+            }//for
         }//if
     }//if
 
@@ -354,76 +998,188 @@ void processInput(GLFWwindow *window){
 
         Planet::worldSpeed = 1;
 
-        // Movimentação da Nave
-        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS){
-            get<1>(ship.ship[0]) = glm::rotate(get<1>(ship.ship[0]), glm::radians(90.0f) * -deltaTime, glm::vec3(0.0f, 1.0f, 0.0f));
+        // Movimentação da Nave, enquanto a tecla estiver segurada
+        if (controls.held(ACTION_YAW_RIGHT)){
+            ship.matrix = glm::rotate(ship.matrix, glm::radians(90.0f) * -deltaTime, glm::vec3(0.0f, 1.0f, 0.0f));
             updateCameraOnShip();
         }//if
-        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS){
-            get<1>(ship.ship[0]) = glm::rotate(get<1>(ship.ship[0]), glm::radians(90.0f) * deltaTime, glm::vec3(0.0f, 1.0f, 0.0f));
+        if (controls.held(ACTION_YAW_LEFT)){
+            ship.matrix = glm::rotate(ship.matrix, glm::radians(90.0f) * deltaTime, glm::vec3(0.0f, 1.0f, 0.0f));
             updateCameraOnShip();
         }//if
-        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS){
-            get<1>(ship.ship[0]) = glm::rotate(get<1>(ship.ship[0]), glm::radians(90.0f) * deltaTime, glm::vec3(1.0f, 0.0f, 0.0f));
+        if (controls.held(ACTION_PITCH_DOWN)){
+            ship.matrix = glm::rotate(ship.matrix, glm::radians(90.0f) * deltaTime, glm::vec3(1.0f, 0.0f, 0.0f));
             updateCameraOnShip();
         }//if
-        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS){
-            get<1>(ship.ship[0]) = glm::rotate(get<1>(ship.ship[0]), glm::radians(90.0f) * -deltaTime, glm::vec3(1.0f, 0.0f, 0.0f));
+        if (controls.held(ACTION_PITCH_UP)){
+            ship.matrix = glm::rotate(ship.matrix, glm::radians(90.0f) * -deltaTime, glm::vec3(1.0f, 0.0f, 0.0f));
             updateCameraOnShip();
         }//if
-        if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS){
-            get<1>(ship.ship[0]) = glm::rotate(get<1>(ship.ship[0]), glm::radians(90.0f) * -deltaTime, glm::vec3(0.0f, 0.0f, 1.0f));
+        if (controls.held(ACTION_ROLL_LEFT)){
+            ship.matrix = glm::rotate(ship.matrix, glm::radians(90.0f) * -deltaTime, glm::vec3(0.0f, 0.0f, 1.0f));
             updateCameraOnShip();
         }//if
-        if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS){
-            get<1>(ship.ship[0]) = glm::rotate(get<1>(ship.ship[0]), glm::radians(90.0f) * deltaTime, glm::vec3(0.0f, 0.0f, 1.0f));
+        if (controls.held(ACTION_ROLL_RIGHT)){
+            ship.matrix = glm::rotate(ship.matrix, glm::radians(90.0f) * deltaTime, glm::vec3(0.0f, 0.0f, 1.0f));
             updateCameraOnShip();
         }//if
 
         // Velocidade da Nave
-        if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS){
-            if(processButton())
-                return;
-
+        for(int i = controls.pressed(ACTION_UP); i > 0; i--){
             ship.speed++;
             if(ship.speed > 10)
                 ship.speed = 10;
-            return;
-        }//if
-        if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS){
-            if(processButton())
-                return;
-
+        }//for
+        for(int i = controls.pressed(ACTION_DOWN); i > 0; i--){
             ship.speed--;
             if(ship.speed < 3)
                 ship.speed = 3;
-            return;
-        }//if
+        }//for
     }//if
-
-    freeButton();
 }//processInput
 
+// Teclas e caracteres de cada ação
+void bindControls(){
+    controls.bindKey(GLFW_KEY_ESCAPE, ACTION_QUIT);
+    controls.bindKey(GLFW_KEY_Z, ACTION_DEPTH);
+    controls.bindKey(GLFW_KEY_O, ACTION_PROFILER);
+    controls.bindKey(GLFW_KEY_H, ACTION_HELP);
+    controls.bindKey(GLFW_KEY_F, ACTION_SAVE_PROFILE);
+    controls.bindKey(GLFW_KEY_R, ACTION_RECORD);
+    controls.bindKey(GLFW_KEY_V, ACTION_TRUE_SCALE);
+    controls.bindKey(GLFW_KEY_1, ACTION_MODE_1);
+    controls.bindKey(GLFW_KEY_2, ACTION_MODE_2);
+    controls.bindKey(GLFW_KEY_3, ACTION_MODE_3);
+    controls.bindKey(GLFW_KEY_P, ACTION_PAUSE);
+    controls.bindKey(GLFW_KEY_M, ACTION_FASTER);
+    controls.bindKey(GLFW_KEY_N, ACTION_SLOWER);
+    controls.bindChar('+', ACTION_FASTER);
+    controls.bindChar('-', ACTION_SLOWER);
+    controls.bindKey(GLFW_KEY_T, ACTION_FLAT_EARTH);
+    controls.bindKey(GLFW_KEY_LEFT, ACTION_PREVIOUS_PLANET);
+    controls.bindKey(GLFW_KEY_RIGHT, ACTION_NEXT_PLANET);
+    controls.bindKey(GLFW_KEY_UP, ACTION_UP);
+    controls.bindKey(GLFW_KEY_DOWN, ACTION_DOWN);
+    controls.bindKey(GLFW_KEY_A, ACTION_YAW_LEFT);
+    controls.bindKey(GLFW_KEY_D, ACTION_YAW_RIGHT);
+    controls.bindKey(GLFW_KEY_S, ACTION_PITCH_UP);
+    controls.bindKey(GLFW_KEY_W, ACTION_PITCH_DOWN);
+    controls.bindKey(GLFW_KEY_Q, ACTION_ROLL_LEFT);
+    controls.bindKey(GLFW_KEY_E, ACTION_ROLL_RIGHT);
+}//bindControls
+
+// glfw: tecla apertada ou solta; as repetições do sistema não viram eventos
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods){
+    if(input.mode == INPUT_REPLAY or action == GLFW_REPEAT)
+        return;
+    controls.key(key, action == GLFW_PRESS, Controls::now());
+}//key_callback
+
+// glfw: caractere digitado, já no layout do teclado
+void char_callback(GLFWwindow* window, unsigned int codepoint){
+    if(input.mode == INPUT_REPLAY)
+        return;
+    controls.character(codepoint, Controls::now());
+}//char_callback
+
+// Aplica os eventos gravados no frame atual: teclas e caracteres voltam para a fila
+void applyInput(vector<InputEvent> events){
+    if(not events.empty())
+        throttle.invalidate();
+    for(unsigned int i = 0; i < events.size(); i++){
+        if(events[i].type == 'k')
+            controls.key(events[i].a, events[i].b, Controls::now());
+        else if(events[i].type == 'c')
+            controls.character(events[i].a, Controls::now());
+        else if(events[i].type == 's')
+            zoom(events[i].value);
+        else if(events[i].type == 'r')
+            resize(events[i].a, events[i].b);
+    }
+}//applyInput
+
+// Frames por segundo do replay e se a simulação repetiu a gravação
+void replayReport(unsigned long frames, double seconds){
+    cout << "Replay: " << frames << " frames em " << seconds << " s: " << frames / seconds << " frames/s, dt "
+         << input.dt << ", " << input.mismatches << " eventos fora do tempo gravado" << endl;
+}//replayReport
+
+// Latência do evento de entrada até a troca de buffers do frame que o usou
+void latencyReport(){
+    if(controls.latency.empty())
+        return;
+    Stats x = Profiler::stats(controls.latency);
+    cout << "Latência da entrada: " << controls.latency.size() << " frames com eventos, p50 " << x.p50
+         << " ms, p95 " << x.p95 << " ms, máximo " << x.max << " ms";
+    if(controls.dropped())
+        cout << ", " << controls.dropped() << " eventos descartados";
+    cout << endl;
+}//latencyReport
+
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
 void framebuffer_size_callback(GLFWwindow* window, int width, int height){
+    input.resize(width, height, Planet::time);
+    resize(width, height);
+}//framebuffer_size_callback
+
+// Ajusta o viewport, a projeção e os framebuffers ao tamanho da janela
+void resize(int width, int height){
     // make sure the viewport matches the new window dimensions; note that width and 
     // height will be significantly larger than specified on retina displays.
     glViewport(0, 0, width, height);
-}//framebuffer_size_callback
+    if(width > 0 and height > 0){
+        SCR_WIDTH = width;
+        SCR_HEIGHT = height;
+    }
+
+    // O vídeo tem tamanho fixo: a gravação termina quando a janela muda
+    if(recorder.active()){
+        cout << "Janela redimensionada, gravação encerrada" << endl;
+        recorder.stop();
+    }
+
+    // Framebuffer com profundidade float
+    Depth::resize(width, height);
+
+    // O cubemap das estrelas acompanha a resolução da janela
+    starBox->setResolution(width, height, camera.Zoom);
+
+    // Feedback das texturas virtuais
+    if(not virtualTextures.empty())
+        feedback.create(SCR_WIDTH, SCR_HEIGHT);
+}//resize
+
+// glfw: a janela foi exposta e precisa ser redesenhada
+void refresh_callback(GLFWwindow* window){
+    throttle.invalidate();
+}//refresh_callback
 
 // glfw: whenever the mouse scroll wheel scrolls, this callback is called
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset){
-    
-    camera.ProcessMouseScroll(yoffset);
+    // No replay o scroll vem do log
+    if(input.mode == INPUT_REPLAY)
+        return;
+
+    input.scroll(yoffset, Planet::time);
+    zoom(yoffset);
 }//scroll_callback
 
+// Muda o campo de visão; o cubemap das estrelas acompanha, como no resize
+void zoom(float offset){
+    camera.ProcessMouseScroll(offset);
+    starBox->setResolution(SCR_WIDTH, SCR_HEIGHT, camera.Zoom);
+    throttle.invalidate();
+}//zoom
+
 // Aloca o Sol
 void allocate_sun(){
     star.qt = 0;
 
     // Sol
-    Model model_sun(FileSystem::getPath("resources/objects/Sun/sun.obj"));
-    Sun sun("Sun", 150000); // 109 vezes o tamanho da Terra
+    BodyInfo info = sunCatalogue();
+    Model model_sun(FileSystem::getPath(info.model));
+    Sun sun(info.name, info.scale);
+    sun.setReal(info.realDiameter);
     star.sun.push_back(tuple<Sun, Model>(sun, model_sun));
     star.qt++;
 }//alocate_sun
@@ -432,248 +1188,447 @@ void allocate_sun(){
 void allocate_planets(){
     planets.qt = 0;
 
-    // Mercury
-    Model mercury(FileSystem::getPath("resources/objects/Planets/mercury/mercury.obj"));
-    Planet planet_mercury("Mercury", 4879, 1, 0.5, 0.5);
-    planets.planet.push_back(tuple<Planet, Model>(planet_mercury, mercury));
-    planets.qt++;
-
-    // Venus
-    Model venus(FileSystem::getPath("resources/objects/Planets/venus/venus.obj"));
-    Planet planet_venus("Venus", 12103, 2, -1, 0.75);
-    planets.planet.push_back(tuple<Planet, Model>(planet_venus, venus));
-    planets.qt++;
-
-    // Earth
-    Model earth(FileSystem::getPath("resources/objects/Planets/earth/earth.obj"));
-    Planet planet_earth("Earth", 12756, 3, 1.5, 1);
-    planet_earth.setMoons(1);
-    planets.planet.push_back(tuple<Planet, Model>(planet_earth, earth));
-    planets.qt++;
-
-    // Mars
-    Model mars(FileSystem::getPath("resources/objects/Planets/mars/mars.obj"));
-    Planet planet_mars("Mars", 6792, 4, 2, 1.25);
-    planets.planet.push_back(tuple<Planet, Model>(planet_mars, mars));
-    planets.qt++;
-
-    // Jupiter
-    Model jupiter(FileSystem::getPath("resources/objects/Planets/jupiter/jupiter.obj"));
-    Planet planet_jupiter("Jupiter", 142984, 5, 2.5, 2.75);
-    planet_jupiter.setMoons(4);
-    planets.planet.push_back(tuple<Planet, Model>(planet_jupiter, jupiter));
-    planets.qt++;
-
-    // Saturn
-    Model saturn(FileSystem::getPath("resources/objects/Planets/saturn/saturn.obj"));
-    Planet planet_saturn("Saturn", 120573, 6, 3, 5.0);
-    planet_saturn.setMoons(1);
-    planets.planet.push_back(tuple<Planet, Model>(planet_saturn, saturn));
-    planets.qt++;
-
-    // Uranus
-    Model uranus(FileSystem::getPath("resources/objects/Planets/uranus/uranus.obj"));
-    Planet planet_uranus("Uranus", 51118, 7, 3.5, 6.25);
-    planet_uranus.setMoons(4);
-    planets.planet.push_back(tuple<Planet, Model>(planet_uranus, uranus));
-    planets.qt++;
-
-    // Neptune
-    Model neptune(FileSystem::getPath("resources/objects/Planets/neptune/neptune.obj"));
-    Planet planet_neptune("Neptune", 49528, 8, 4, 7.25);
-    planet_neptune.setMoons(1);
-    planets.planet.push_back(tuple<Planet, Model>(planet_neptune, neptune));
-    planets.qt++;
+    // Mercury, Venus, Earth, Mars, Jupiter, Saturn, Uranus e Neptune
+    vector<BodyInfo> info = planetCatalogue();
+    vector<BodyInfo> moon = moonCatalogue();
+    for(unsigned int i = 0; i < info.size(); i++){
+        Model model(FileSystem::getPath(info[i].model));
+        Planet planet(info[i].name, info[i].scale, info[i].orbit, info[i].rotation, info[i].distance);
+        planet.setReal(info[i].realDiameter, info[i].realDistance);
+        planet.setMoons(Simulation::countMoons(moon, i));
+        planets.planet.push_back(tuple<Planet, Model>(planet, model));
+        planets.qt++;
+    }
 }// allocate_planets
 
 // Aloca as luas
 void allocate_moons(){
     moons.qt = 0;
 
-    // Luas da Terra
-    Model moon_model(FileSystem::getPath("resources/objects/Moons/Earth/Moon/moon.obj"));
-    Moon moon("Moon", 12756/4, 1.0, Planet::days, 0.07, &get<0>(planets.planet[2]));
-    moons.moon.push_back(tuple<Moon, Model>(moon, moon_model));
-    moons.qt++;
-
-    //--------------------------------------------
-
-    // Luas de Jupiter
-    Model io_model(FileSystem::getPath("resources/objects/Moons/Jupiter/Io/io.obj"));
-    Moon io("Io", 142984/7, 1, 0.5, 0.6, &get<0>(planets.planet[4]));
-    moons.moon.push_back(tuple<Moon, Model>(io, io_model));
-    moons.qt++;
-
-    Model europa_model(FileSystem::getPath("resources/objects/Moons/Jupiter/Europa/europa.obj"));
-    Moon europa("Europa", 142984/7.5, 2, 1, 0.85, &get<0>(planets.planet[4]));
-    moons.moon.push_back(tuple<Moon, Model>(europa, europa_model));
-    moons.qt++;
-
-    Model ganymede_model(FileSystem::getPath("resources/objects/Moons/Jupiter/Ganymede/ganymede.obj"));
-    Moon ganymede("Ganymede", 142984/5, 3, 1.5, 1.1, &get<0>(planets.planet[4]));
-    moons.moon.push_back(tuple<Moon, Model>(ganymede, ganymede_model));
-    moons.qt++;
-
-    Model callisto_model(FileSystem::getPath("resources/objects/Moons/Jupiter/Callisto/callisto.obj"));
-    Moon callisto("Callisto", 142984/6, 4, 2, 1.35, &get<0>(planets.planet[4]));
-    moons.moon.push_back(tuple<Moon, Model>(callisto, callisto_model));
-    moons.qt++;
-
-    //-----------------------------------------------
-
-    // Lua de Saturno
-    Model titan_model(FileSystem::getPath("resources/objects/Moons/Saturn/Titan/titan.obj"));
-    Moon titan("Titan", 120573/4, 1, 0.5, 0.6, &get<0>(planets.planet[5]));
-    moons.moon.push_back(tuple<Moon, Model>(titan, titan_model));
-    moons.qt++;
-
-    //-----------------------------------------------
-
-    // Luas de Urano
-    Model ariel_model(FileSystem::getPath("resources/objects/Moons/Uranus/Ariel/ariel.obj"));
-    Moon ariel("Ariel", 51118/5, 1, 0.5, 0.3, &get<0>(planets.planet[6]));
-    moons.moon.push_back(tuple<Moon, Model>(ariel, ariel_model));
-    moons.qt++;
-
-    Model umbriel_model(FileSystem::getPath("resources/objects/Moons/Uranus/Umbriel/umbriel.obj"));
-    Moon umbriel("Umbriel", 51118/5, 2, 1.0, 0.4, &get<0>(planets.planet[6]));
-    moons.moon.push_back(tuple<Moon, Model>(umbriel, umbriel_model));
-    moons.qt++;
-
-    Model titania_model(FileSystem::getPath("resources/objects/Moons/Uranus/Titania/titania.obj"));
-    Moon titania("Titania", 51118/5, 3, 1.5, 0.5, &get<0>(planets.planet[6]));
-    moons.moon.push_back(tuple<Moon, Model>(titania, titania_model));
-    moons.qt++;
-
-    Model oberon_model(FileSystem::getPath("resources/objects/Moons/Uranus/Oberon/oberon.obj"));
-    Moon oberon("Oberon", 51118/5, 4, 2, 0.6, &get<0>(planets.planet[6]));
-    moons.moon.push_back(tuple<Moon, Model>(oberon, oberon_model));
-    moons.qt++;
-
-    //------------------------------------------------
-
-    // Luas de Netuno
-    Model triton_model(FileSystem::getPath("resources/objects/Moons/Neptune/Triton/triton.obj"));
-    Moon triton("Triton", 49528/4, 1, 0.5, 0.3, &get<0>(planets.planet[7]));
-    moons.moon.push_back(tuple<Moon, Model>(triton, triton_model));
-    moons.qt++;
+    // Luas da Terra, de Jupiter, de Saturno, de Urano e de Netuno
+    vector<BodyInfo> info = moonCatalogue();
+    for(unsigned int i = 0; i < info.size(); i++){
+        Model model(FileSystem::getPath(info[i].model));
+        Moon moon(info[i].name, info[i].scale, info[i].orbit, info[i].rotation, info[i].distance, &get<0>(planets.planet[info[i].parent]));
+        moon.setReal(info[i].realDiameter, info[i].realDistance);
+        moons.moon.push_back(tuple<Moon, Model>(moon, model));
+        moons.qt++;
+    }
 }//allocate_moons
 
 // Aloca a nave
 void allocate_ship(){
     glm::mat4 matrix;
 
-    // Inicializa a parte da nave
-    Model model_ship(FileSystem::getPath("resources/objects/Falcon/Millennium_Falcon.obj"));
+    // Inicializa a parte da nave; o modelo só é lido quando o modo 3 for usado
+    ship.model.setPath(FileSystem::getPath("resources/objects/Falcon/Millennium_Falcon.obj"));
     matrix = glm::translate(matrix, glm::vec3(0.0f, -0.02f, 2.9f));
     matrix = glm::rotate(matrix, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     matrix = glm::scale(matrix, 0.0001f * glm::vec3(1.0f, 1.0f, 1.0f));
-    ship.ship.push_back(tuple<Model,glm::mat4>(model_ship, matrix));
+    ship.matrix = matrix;
     ship.scale = 1/0.0001f;
+
+    // Roteiros que passam pelo modo 3 já começam a carregar a nave
+    bool predicted = (not benchmarkScenario.empty() and bench.uses(3)) or
+                     (input.mode == INPUT_REPLAY and input.presses(GLFW_KEY_3));
+    if(shipLoading == "eager")
+        ship.model.wait();
+    else if(shipLoading == "prefetch" or predicted)
+        ship.model.request();
 }//allocate_ship
 
+// Abre (ou monta, na primeira vez) a pirâmide de páginas de cada mapa virtual
+void allocate_virtual(){
+    planetVirtual.assign(planets.qt, -1);
+    for(unsigned int i = 0; i < virtualSpecs.size(); i++){
+        int planet = -1;
+        for(int j = 0; j < planets.qt; j++)
+            if(get<0>(planets.planet[j]).getName() == virtualSpecs[i].first)
+                planet = j;
+        if(planet < 0){
+            cout << "Textura virtual: corpo desconhecido " << virtualSpecs[i].first << endl;
+            continue;
+        }
+
+        planetVirtual[planet] = virtualTextures.size();
+        virtualTextures.push_back(new VirtualTexture(virtualSpecs[i].second));
+        virtualTextures.back()->request();
+    }
+    if(not virtualTextures.empty())
+        feedback.create(SCR_WIDTH, SCR_HEIGHT);
+}//allocate_virtual
+
+// Copia os modelos dos planetas e das luas para a arena da cena sintética
+void allocate_arena(GLADloadproc load){
+    DrawArena::init(load);
+    arena.indirect = submitPath == "indirect";
+    arena.create();
+    for(int i = 0; i < planets.qt; i++)
+        arenaPlanets.push_back(arena.add(get<1>(planets.planet[i])));
+    for(int i = 0; i < moons.qt; i++)
+        arenaMoons.push_back(arena.add(get<1>(moons.moon[i])));
+    cout << "Cena sintética: envio " << (DrawArena::multiDraw and arena.indirect ? "indireto (glMultiDrawElementsIndirect)" : "em laço (glDrawElementsBaseVertex)") << endl;
+}//allocate_arena
+
+// Envia para a GPU o que as threads terminaram de ler
+void loadAssets(){
+    for(unsigned int i = 0; i < virtualTextures.size(); i++)
+        if(virtualTextures[i]->poll())
+            Log::print("Textura virtual " + virtualTextures[i]->getImage() + (virtualTextures[i]->ready() ? ": pronta" : ": falha ao abrir, usando a textura comum"));
+
+    if(not ship.model.poll())
+        return;
+
+    if(ship.model.getState() == ASSET_FAILED){
+        Log::print("Nave: falha ao carregar, usando o substituto");
+        return;
+    }
+    long rss = 0, peak = 0;
+    Benchmark::residentMemory(rss, peak);
+    char line[160];
+    snprintf(line, sizeof(line), "Nave carregada em %.0f ms (leitura %.0f ms em outra thread, envio %.1f ms); memória residente %.1f -> %.1f MB",
+             ship.model.totalMs, ship.model.importMs, ship.model.uploadMs, startupRss / 1024.0, rss / 1024.0);
+    Log::print(line);
+}//loadAssets
+
+// Tempo do início do programa até o primeiro frame e memória residente
+void startupReport(){
+    long peak = 0;
+    Benchmark::residentMemory(startupRss, peak);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - launch).count();
+    const char *state[] = {"adiada", "carregando", "carregada", "falhou"};
+    cout << "Inicialização: " << ms << " ms, memória residente " << startupRss / 1024.0
+         << " MB (nave " << state[ship.model.getState()] << ")" << endl;
+    cout << MeshCook::summary() << endl;
+}//startupReport
+
 // Renderiza as estrelas
-void render_stars(Shader *ourShader, Model *stars){
+void render_stars(Shader *ourShader){
+    TRACE_ZONE("render_stars");
     glm::mat4 matrix;
-    matrix = glm::translate(matrix, glm::vec3(0.0f, 0.0f, 0.0f));
     if(mode == 1)
         matrix = glm::rotate(matrix, glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    matrix = glm::scale(matrix, 30.0f * glm::vec3(1.0f, 1.0f, 1.0f));
-    ourShader->setMat4("model", matrix);
-    stars->Draw(*ourShader);
+
+    // Desenha o cubemap já pronto e volta pro shader dos objetos
+    starBox->draw(frame.projection, frame.view, matrix);
+    ourShader->use();
 }//render_stars
 
 // Renderiza o Sol
 void render_sun(Shader *ourShader){
-    ourShader->setMat4("model", get<0>(star.sun[0]).render());
+    TRACE_ZONE("render_sun");
+    glm::mat4 matrix = get<0>(star.sun[0]).render();
+    setModel(matrix);
+    setDetail(matrix);
     get<1>(star.sun[0]).Draw(*ourShader);
+    Residency::detail = 0.0f;
 }//render_sun
 
 // Renderiza os Planetas
 void render_planets(Shader *ourShader){
+    TRACE_ZONE("render_planets");
     for(int i = 0; i < planets.qt; i++){
-        ourShader->setMat4("model", get<0>(planets.planet[i]).render());
+        // Desenhado pelo terreno neste frame
+        if(i == terrainBody)
+            continue;
+        glm::mat4 matrix = get<0>(planets.planet[i]).render();
+        if(planetVirtual[i] >= 0 and virtualTextures[planetVirtual[i]]->ready()){
+            render_virtual(i, matrix, false, ourShader);
+            continue;
+        }
+        setModel(matrix);
+        setDetail(matrix);
         get<1>(planets.planet[i]).Draw(*ourShader);
     }
+    Residency::detail = 0.0f;
 }//render_planets
 
 // Renderiza as luas
 void render_moons(Shader *ourShader){
+    TRACE_ZONE("render_moons");
     for(int i = 0; i < moons.qt; i++){
-        ourShader->setMat4("model", get<0>(moons.moon[i]).render());
+        glm::mat4 matrix = get<0>(moons.moon[i]).render();
+        setModel(matrix);
+        setDetail(matrix);
         get<1>(moons.moon[i]).Draw(*ourShader);
     }
+    Residency::detail = 0.0f;
 }//render_moons
 
+// Terreno do planeta com terreno mais próximo da câmera, quando ela está a
+// menos de terrainRange raios dele. Até as raízes chegarem das threads o
+// planeta continua sendo a esfera. Na escala real os planetas ficam pequenos
+// demais para a precisão de float em torno deles: sem terreno
+void render_terrain(Shader *ourShader){
+    TRACE_ZONE("render_terrain");
+    int nearest = -1;
+    float best = terrainRange;
+    for(int i = 0; i < planets.qt and not Sun::trueScale; i++){
+        Planet &planet = get<0>(planets.planet[i]);
+        if(find(terrainBodies.begin(), terrainBodies.end(), planet.getName()) == terrainBodies.end())
+            continue;
+        if(Planet::plane and planet.getName() == "Earth")
+            continue;
+        planet.render();
+        float distance = glm::length(planet.getPosition() - camera.Position) / (STRESS_SPHERE_RADIUS * planet.getSize());
+        if(distance < best and not get<1>(planets.planet[i]).textures_loaded.empty()){
+            best = distance;
+            nearest = i;
+        }
+    }
+
+    if(nearest < 0){
+        terrain.setBody(-1, "");
+        return;
+    }
+    Model &model = get<1>(planets.planet[nearest]);
+    terrain.setBody(nearest, model.directory + '/' + model.textures_loaded[0].path);
+
+    glm::mat4 matrix = get<0>(planets.planet[nearest]).render();
+    float pixels = (SCR_HEIGHT / 2.0f) / tan(glm::radians(camera.Zoom) / 2.0f);
+    if(not terrain.update(matrix, frame.viewProj, camera.Position, pixels))
+        return;
+    if(planetVirtual[nearest] >= 0 and virtualTextures[planetVirtual[nearest]]->ready())
+        render_virtual(nearest, matrix, true, ourShader);
+    else
+        terrain.draw(ourShader, objectRing, matrix, model.textures_loaded[0].id);
+    terrainBody = nearest;
+}//render_terrain
+
+// Desenha o planeta (a esfera ou os blocos do terreno) com a textura virtual
+// e guarda o desenho para repetir no feedback
+void render_virtual(int planet, const glm::mat4 &matrix, bool chunks, Shader *ourShader){
+    TRACE_ZONE("render_virtual");
+    int v = planetVirtual[planet];
+    virtualShader->use();
+    virtualTextures[v]->bind(virtualShader, v);
+    if(chunks)
+        terrain.draw(virtualShader, objectRing, matrix, 0);
+    else{
+        // O mapa comum não é amostrado: fica só com os mips grossos
+        setModel(matrix);
+        Residency::detail = 1.0f;
+        get<1>(planets.planet[planet]).Draw(*virtualShader);
+    }
+
+    VirtualDraw draw = {planet, matrix, chunks};
+    virtualDraws.push_back(draw);
+    ourShader->use();
+}//render_virtual
+
+// Repete os desenhos com textura virtual no buffer de feedback, em baixa
+// resolução, e entrega as páginas pedidas a cada textura
+void render_feedback(){
+    TRACE_ZONE("render_feedback");
+    feedback.begin();
+    feedbackShader->use();
+    feedbackShader->setFloat("vtBias", log2((float) VirtualFeedback::scale));
+    for(unsigned int i = 0; i < virtualDraws.size(); i++){
+        int v = planetVirtual[virtualDraws[i].planet];
+        virtualTextures[v]->bind(feedbackShader, v);
+        if(virtualDraws[i].terrain)
+            terrain.draw(feedbackShader, objectRing, virtualDraws[i].matrix, 0);
+        else{
+            setModel(virtualDraws[i].matrix);
+            get<1>(planets.planet[virtualDraws[i].planet]).Draw(*feedbackShader);
+        }
+    }
+
+    vector<VirtualRequest> requests;
+    feedback.end(requests, VirtualTexture::synchronous);
+    vector<vector<VirtualRequest> > pages(virtualTextures.size());
+    for(unsigned int i = 0; i < requests.size(); i++)
+        if(requests[i].id < (int) pages.size())
+            pages[requests[i].id].push_back(requests[i]);
+    for(unsigned int i = 0; i < virtualTextures.size(); i++)
+        virtualTextures[i]->feedback(pages[i]);
+}//render_feedback
+
+// Raio do corpo na tela (pixels): o streaming lê os mips até o nível que cobre
+// esse tamanho. Com a câmera dentro da esfera pede a resolução cheia
+void setDetail(const glm::mat4 &model){
+    float radius = STRESS_SPHERE_RADIUS * glm::length(glm::vec3(model[0]));
+    float distance = glm::length(glm::vec3(model[3]) - camera.Position);
+    if(distance <= radius)
+        Residency::detail = 0.0f;
+    else
+        Residency::detail = radius / distance * (SCR_HEIGHT / 2.0f) / tan(glm::radians(camera.Zoom) / 2.0f);
+}//setDetail
+
 // Renderiza a nave
 void render_ship(Shader *ourShader){
-    ourShader->setMat4("model", get<1>(ship.ship[0]));
-    get<0>(ship.ship[0]).Draw(*ourShader);
+    TRACE_ZONE("render_ship");
+
+    // Sem janela, no benchmark e no replay os frames não podem depender do
+    // tempo de carga: espera a nave
+    if(headless.enabled or input.mode == INPUT_REPLAY or not benchmarkScenario.empty())
+        ship.model.wait();
+
+    Model *model = ship.model.get();
+    if(model){
+        setModel(ship.matrix);
+        // Nível de detalhe de cada malha pelo tamanho na tela
+        float focal = (SCR_HEIGHT / 2.0f) / tan(glm::radians(camera.Zoom) / 2.0f);
+        model->selectLod(ship.matrix, camera.Position, focal, Simplify::pixelError);
+        model->Draw(*ourShader);
+        return;
+    }
+
+    // Substituto enquanto carrega: a Lua (cinza) do tamanho e no centro da nave
+    setModel(glm::scale(glm::translate(ship.matrix, glm::vec3(0.0f, 90.0f, 95.0f)), glm::vec3(110.0f)));
+    get<1>(moons.moon[0]).Draw(*ourShader);
 }//render_ship
 
+// Renderiza a cena sintética, com um passo do perfil para cada estágio
+void render_stress(Shader *ourShader){
+    TRACE_ZONE("render_stress");
+    profiler.begin("stress_transforms");
+    stress.transforms();
+    profiler.end();
+
+    profiler.begin("stress_cull");
+    stress.cull(frame.viewProj);
+    profiler.end();
+
+    // Planetas e luas com o modelo do catálogo, asteroides com o da Lua
+    profiler.begin("stress_submit");
+    stress.submit();
+    unsigned int n = stress.planets.size();
+    unsigned int m = stress.moons.size();
+    bool pooled = not arenaPlanets.empty();
+    for(unsigned int i = 0; i < stress.visible.size(); i++){
+        unsigned int body = stress.visible[i];
+        Model *model;
+        int id;
+        if(body < n){
+            model = &get<1>(planets.planet[body % planets.qt]);
+            id = pooled ? arenaPlanets[body % planets.qt] : -1;
+        }
+        else if(body < n + m){
+            model = &get<1>(moons.moon[(body - n) % moons.qt]);
+            id = pooled ? arenaMoons[(body - n) % moons.qt] : -1;
+        }
+        else{
+            model = &get<1>(moons.moon[0]);
+            id = pooled ? arenaMoons[0] : -1;
+        }
+
+        // Na arena o desenho só entra na fila; sai no flush, agrupado por material
+        if(id >= 0)
+            arena.draw(id, stress.stream[i]);
+        else{
+            setModel(stress.stream[i]);
+            model->Draw(*ourShader);
+        }
+    }
+    if(pooled){
+        Shader *batch = Depth::mode == DEPTH_LOGARITHMIC ? indirectLogShader : indirectShader;
+        batch->use();
+        batch->setFloat("logDepth", Depth::logarithmic(Z_FAR));
+        arena.flush(*batch);
+        ourShader->use();
+    }
+    profiler.end();
+}//render_stress
+
+// Envia a matriz do objeto pelo anel de uniforms
+void setModel(glm::mat4 model){
+    ObjectData object;
+    object.model = model;
+    objectRing->push(OBJECT_BINDING, &object, sizeof(ObjectData));
+}//setModel
+
 // Utiliza a câmera com visão total do sistema solar
-void up_vision(Shader *ourShader){
-    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.01f, 1000.0f);
-    camera.Position = glm::vec3(0.0f, 20.0f, 0.0f);
+void up_vision(){
+    camera.Position = glm::vec3(0.0f, 20.0f * worldScale(), 0.0f);
     camera.Front = glm::normalize(glm::vec3(0.0f, -3.0f, 0.0f));
     camera.Up = glm::normalize(glm::vec3(0.0f, 0.0f, 1.0f));
     camera.Right = glm::normalize(glm::vec3(1.0f, 0.0f, 0.0f));
-    glm::mat4 view = camera.GetViewMatrix();
-    
-    ourShader->setMat4("projection", projection);
-    ourShader->setMat4("view", view);    
 }//up_vision
 
 // Utiliza a câmera com visão dos objetos
-void pick_vision(Shader *ourShader){
+void pick_vision(){
     // Posição do objeto visualizado
     glm::vec3 objPos = get<0>(planets.planet[vision.planet]).getPosition();
 
     if(vision.moon >= 0)
         objPos = getMoonPosition();
 
-    // Criação da matriz de projeção
-    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.01f, 1000.0f);
-
     // Posição da câmera
     camera.Position = distance_vision() + objPos;
     camera.Front    = glm::normalize(objPos - camera.Position);
     camera.Right    = glm::normalize(glm::cross(camera.Front, camera.WorldUp));
     camera.Up       = glm::normalize(glm::cross(camera.Right, camera.Front));
-    
-    // View
-    glm::mat4 view = camera.GetViewMatrix();
-    
-    // Atualiza o Shader
-    ourShader->setMat4("projection", projection);
-    ourShader->setMat4("view", view);    
 }//pick_vision
 
 // Utiliza a câmera da nave
-void ship_vision(Shader *ourShader){
+void ship_vision(){
     
     // Movimenta a nave
-    get<1>(ship.ship[0]) = checkShip();
+    ship.matrix = checkShip();
 
     // Atualiza a câmera
-    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.01f, 1000.0f);
     updateCameraOnShip();
-    glm::mat4 view = camera.GetViewMatrix();
-    ourShader->setMat4("projection", projection);
-    ourShader->setMat4("view", view);
-    render_ship(ourShader);
 }//ship_vision
 
+// Aplica a chave do caminho: modos do teclado ou câmera livre (modo 0)
+void path_vision(CameraKey key){
+    if(key.mode != mode and key.mode == 2)
+        Planet::worldSpeed = 1;
+
+    mode = key.mode;
+    if(mode == 3)
+        ship.model.request();
+    vision.planet = key.planet;
+    vision.moon = key.moon;
+    if(vision.planet < 0 or vision.planet >= planets.qt)
+        vision.planet = 0;
+    if(vision.moon >= (int) get<0>(planets.planet[vision.planet]).getMoons())
+        vision.moon = -1;
+
+    if(mode != 0)
+        return;
+
+    // As coordenadas do caminho estão na escala padrão
+    camera.Position = key.position * worldScale();
+    camera.Front    = glm::normalize(key.target * worldScale() - camera.Position);
+    camera.Right    = glm::normalize(glm::cross(camera.Front, camera.WorldUp));
+    camera.Up       = glm::normalize(glm::cross(camera.Right, camera.Front));
+}//path_vision
+
+// Relógio do frame
+double getTime(){
+    return headless.enabled ? headless.time : glfwGetTime();
+}//getTime
+
+// Envia a câmera do frame, uma vez, para todos os shaders
+void updateFrame(){
+    frame.view       = camera.GetViewMatrix();
+    frame.projection = getProjection();
+    frame.viewProj   = frame.projection * frame.view;
+    frame.cameraPos  = glm::vec4(camera.Position, 1.0f);
+    frame.time       = glm::vec4(Planet::time, deltaTime, getTime(), 0.0f);
+    frameRing->push(FRAME_BINDING, &frame, sizeof(FrameData));
+}//updateFrame
+
+// Retorna a projeção da câmera
+glm::mat4 getProjection(){
+    // Na escala real as luas têm milésimos de UA, o near precisa acompanhar
+    float near = Sun::trueScale ? 0.0000001f : 0.01f;
+    return Depth::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, near, Z_FAR);
+}//getProjection
+
 // Retorna a distância para visualizar o objeto
 glm::vec3 distance_vision(){
     glm::vec3 x;
     float scale;
     if(vision.moon < 0)
-        scale = get<0>(planets.planet[vision.planet]).getScale();
+        scale = get<0>(planets.planet[vision.planet]).getSize();
     else
         scale = getMoonScale();
 
-    float aux = (1.5f * scale)/142984;
+    // Relativo ao tamanho desenhado, vale também na escala real
+    float aux = (1.5f * scale)/(142984 * 0.000001f);
     x = glm::vec3(-aux, aux, 0.0f);
     return x;
 }//distance_vision
@@ -698,11 +1653,11 @@ float getMoonScale(){
     float x;
 
     switch(vision.planet){
-        case 2: x = get<0>(moons.moon[0]).getScale();                break;
-        case 4: x = get<0>(moons.moon[1 + vision.moon]).getScale();  break;
-        case 5: x = get<0>(moons.moon[5]).getScale();                break;
-        case 6: x = get<0>(moons.moon[6 + vision.moon]).getScale();  break;
-        case 7: x = get<0>(moons.moon[10]).getScale();               break;
+        case 2: x = get<0>(moons.moon[0]).getSize();                break;
+        case 4: x = get<0>(moons.moon[1 + vision.moon]).getSize();  break;
+        case 5: x = get<0>(moons.moon[5]).getSize();                break;
+        case 6: x = get<0>(moons.moon[6 + vision.moon]).getSize();  break;
+        case 7: x = get<0>(moons.moon[10]).getSize();               break;
     }
 
     return x;
@@ -710,7 +1665,7 @@ float getMoonScale(){
 
 // Retorna a posição da nave
 glm::vec3 shipPosition(){
-    glm::mat4 matrix = get<1>(ship.ship[0]);
+    glm::mat4 matrix = ship.matrix;
     glm::vec3 position;
 
     position.x = matrix[3][0];
@@ -725,7 +1680,7 @@ glm::vec3 camPosition(){
     glm::mat4 aux;
     glm::vec3 dist;
 
-    aux = glm::translate(get<1>(ship.ship[0]), ship.scale * glm::vec3(0.0f, 0.020f, -0.11f));
+    aux = glm::translate(ship.matrix, ship.scale * glm::vec3(0.0f, 0.020f, -0.11f));
     dist.x = aux[3][0];
     dist.y = aux[3][1];
     dist.z = aux[3][2];
@@ -738,7 +1693,7 @@ glm::vec3 rightFromShip(){
     glm::mat4 aux;
     glm::vec3 dist;
 
-    aux = glm::translate(get<1>(ship.ship[0]), ship.scale * glm::vec3(1.0f, 0.0f, 0.0f));
+    aux = glm::translate(ship.matrix, ship.scale * glm::vec3(1.0f, 0.0f, 0.0f));
     dist.x = aux[3][0];
     dist.y = aux[3][1];
     dist.z = aux[3][2];
@@ -763,7 +1718,7 @@ glm::mat4 checkShip(){
     x = glm::vec3(0.0f, 0.0f, 1000.0f);
 
     // Movimenta a nave
-    aux = glm::translate(get<1>(ship.ship[0]), deltaTime * (x * ship.speed));
+    aux = glm::translate(ship.matrix, deltaTime * (x * ship.speed * worldScale()));
 
     // posição da nave
     x.x = aux[3][0];
@@ -771,34 +1726,31 @@ glm::mat4 checkShip(){
     x.z = aux[3][2];
 
     // Se tiver muito a cima ou muito abaixo, não pode movimentar
-    if(abs(x.y) > 2.0f)
-        return get<1>(ship.ship[0]);
+    if(abs(x.y) > 2.0f * worldScale())
+        return ship.matrix;
 
     // Se tiver uma distância muito grande do centro, não se movimenta
-    if(glm::length(x) > 8.0f)
-        return get<1>(ship.ship[0]);
+    if(glm::length(x) > 8.0f * worldScale())
+        return ship.matrix;
 
     // pode se movimentar
     return aux;
 }//checkShip
 
-// Aperta o botão
-bool processButton(){
-    if(button)
-        return true;
-
-    button = true;
-    return false;
-}//processButton
+// Retorna o tamanho do mundo em relação à escala padrão (órbita de Netuno)
+float worldScale(){
+    float outer = 0.0f;
+    for(int i = 0; i < planets.qt; i++)
+        outer = max(outer, get<0>(planets.planet[i]).getDistance() * Planet::UA);
+    outer = max(outer, stress.outer());
 
-// Abre o botão
-void freeButton(){
-    // botão não apertado
-    button = false;
-}//freeButton
+    return outer / 7.25f;
+}//worldScale
 
 // Inicializa as variaveis
 void initialize(){
+    TRACE_ZONE("initialize");
+
     // Aloca o sol
     allocate_sun();
     // Aloca os planetas
@@ -807,6 +1759,14 @@ void initialize(){
     allocate_moons();
     // Aloca a nave
     allocate_ship();
+    // Texturas virtuais
+    allocate_virtual();
+
+    // Cena sintética, desenhada junto com o sistema solar
+    if(stressSize[0] or stressSize[2]){
+        stress.generate(stressSize[0], stressSize[1], stressSize[2]);
+        cout << "Cena sintética: " << stress.bodies() << " corpos" << endl;
+    }
 
     // Inicializa os valores da struct Vision
     vision.planet = 0;
@@ -815,12 +1775,12 @@ void initialize(){
     // Modo da camêra
     mode = 1;
 
-    // Botão não apertado
-    button = false;
-
     // Velocidade da nave
     ship.speed = 3;
 
+    // Teclas das ações
+    bindControls();
+
     // Imprime as informações
     info();
 }//initialize
@@ -831,73 +1791,214 @@ void pauseGame(){
     Planet::pause = not Planet::pause;
 }//pauseGame
 
+// Grava o perfil dos passos (janela móvel em CSV, min/avg/p99 em JSON)
+void saveProfile(){
+    profiler.writeCSV("profiler.csv");
+    profiler.writeJSON("profiler.json");
+}//saveProfile
+
+// Liga/desliga os tamanhos e distâncias reais
+void trueScale(){
+    Sun::setTrueScale(not Sun::trueScale);
+}//trueScale
+
+// Começa/termina a gravação; na janela pula frames em vez de segurar o frame rate
+void record(){
+    if(recorder.active())
+        recorder.stop();
+    else
+        recorder.start(recordSpec, SCR_WIDTH, SCR_HEIGHT, recordFps, RECORD_DROP);
+}//record
+
 // Função para passar o tempo
 void passingTime(){
-    if (not Planet::pause)
-        Planet::time += deltaTime * Planet::worldSpeed; 
+    TRACE_ZONE("passingTime");
+    Simulation::tick(deltaTime);
 }//passingTime
 
-// Imprime as informações necessárias
+// Hash de tudo que muda a imagem: relógio, câmera, modos e tamanho
+unsigned long long sceneHash(){
+    unsigned long long h = FrameThrottle::seed();
+    FrameThrottle::hash(h, &Planet::time, sizeof(Planet::time));
+    FrameThrottle::hash(h, &Planet::plane, sizeof(Planet::plane));
+    FrameThrottle::hash(h, &Sun::trueScale, sizeof(Sun::trueScale));
+    FrameThrottle::hash(h, &Planet::pause, sizeof(Planet::pause));
+    FrameThrottle::hash(h, &Planet::worldSpeed, sizeof(Planet::worldSpeed));
+    FrameThrottle::hash(h, &ship.speed, sizeof(ship.speed));
+    FrameThrottle::hash(h, &mode, sizeof(mode));
+    FrameThrottle::hash(h, &vision, sizeof(vision));
+    FrameThrottle::hash(h, &camera.Position, sizeof(camera.Position));
+    FrameThrottle::hash(h, &camera.Front, sizeof(camera.Front));
+    FrameThrottle::hash(h, &camera.Up, sizeof(camera.Up));
+    FrameThrottle::hash(h, &camera.Zoom, sizeof(camera.Zoom));
+    FrameThrottle::hash(h, &ship.matrix, sizeof(glm::mat4));
+    AssetState shipState = ship.model.getState();
+    FrameThrottle::hash(h, &shipState, sizeof(shipState));
+    unsigned int terrainQueue = terrain.busy();
+    FrameThrottle::hash(h, &terrainQueue, sizeof(terrainQueue));
+    for(unsigned int i = 0; i < virtualTextures.size(); i++)
+        FrameThrottle::hash(h, &virtualTextures[i]->uploads, sizeof(virtualTextures[i]->uploads));
+    FrameThrottle::hash(h, &Depth::mode, sizeof(Depth::mode));
+    FrameThrottle::hash(h, &profiler.visible, sizeof(profiler.visible));
+    FrameThrottle::hash(h, &help, sizeof(help));
+    FrameThrottle::hash(h, &SCR_WIDTH, sizeof(SCR_WIDTH));
+    FrameThrottle::hash(h, &SCR_HEIGHT, sizeof(SCR_HEIGHT));
+    return h;
+}//sceneHash
+
+// Espera um evento da janela; o glfwWaitEventsTimeout só existe a partir do GLFW 3.2
+void waitEvents(float seconds){
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 2)
+    glfwWaitEventsTimeout(seconds);
+#else
+    // Sem timeout o glfwWaitEvents travaria com uma tecla segurada: dorme um
+    // décimo da espera e consulta, para responder rápido à entrada
+    FrameThrottle::sleepUntil(chrono::steady_clock::now() + chrono::milliseconds((int) (1000.0f * seconds / 10.0f)));
+    glfwPollEvents();
+#endif
+}//waitEvents
+
+// Avisa no terminal a troca de modo (os comandos ficam na tela, tecla H)
 void info(){
     switch(mode){
-        case 1: info_mode_1(); break;
-        case 2: info_mode_2(); break;
-        case 3: info_mode_3(); break;
+        case 1: Log::print("Modo 1: visão global"); break;
+        case 2: Log::print("Modo 2: " + visionName()); break;
+        case 3: Log::print("Modo 3: controle da nave"); break;
     }//switch
 }//info
 
-// Imprime as informações do modo 1
-void info_mode_1(){
-
-    for(int i = 0; i < 40; i++)
-        cout << endl;
-
-    cout << "---------- MODO 1 ----------" << endl;
-    cout << "------- VISÃO GLOBAL -------" << endl;
-    cout << "--------- COMANDOS ---------" << endl;
-    cout << "----------------------------" << endl;
-    cout << "-        PAUSA => P         " << endl;
-    cout << "- AUMENTAR A VELOCIDADE => M" << endl;
-    cout << "- DIMINUIR A VELOCIDADE => N" << endl;
-    cout << "----------------------------" << endl;
-    cout << "- TROCAR DE MODO => 1,2,3   " << endl;
-    cout << "- FECHAR APLICAÇÃO => ESC   " << endl;
-}//info_mode_1
-
-// Imprime as informações do modo 2
-void info_mode_2(){
-    for(int i = 0; i < 40; i++)
-        cout << endl;
-
-    cout << "---------- MODO 2 ------------" << endl;
-    cout << "----- VISÃO ESPECÍFICA -------" << endl;
-    cout << "--------- COMANDOS -----------" << endl;
-    cout << "------------------------------" << endl;
-    cout << "-        PAUSA => P           " << endl;
-    cout << "- AUMENTAR A VELOCIDADE => M  " << endl;
-    cout << "- DIMINUIR A VELOCIDADE => N  " << endl;
-    cout << "- TROCAR PLANETA => LEFT,RIGHT" << endl;
-    cout << "- TROCAR LUAS => UP, DOWN     " << endl;
-    cout << "------------------------------" << endl;
-    cout << "- TROCAR DE MODO => 1,2,3     " << endl;
-    cout << "- FECHAR APLICAÇÃO => ESC     " << endl;
-}//info_mode_2
-
-// Imprime as informações do modo 3
-void info_mode_3(){
-
-    for(int i = 0; i < 40; i++)
-        cout << endl;
-
-    cout << "---------- MODO 3 -------------" << endl;
-    cout << "----- CONTROLE DA NAVE --------" << endl;
-    cout << "--------- COMANDOS ------------" << endl;
-    cout << "-------------------------------" << endl;
-    cout << "- MOVIMENTAÇÃO => W,A,S,D      " << endl;
-    cout << "- ROTAÇÃO => Q,E               " << endl;
-    cout << "- AUMENTAR A VELOCIDADE => UP  " << endl;
-    cout << "- DIMINUIR A VELOCIDADE -> DOWN" << endl;
-    cout << "-------------------------------" << endl;
-    cout << "- TROCAR DE MODO -> 1,2,3      " << endl;
-    cout << "- FECHAR APLICAÇÃO -> ESC      " << endl;
-}//info_mode_3
\ No newline at end of file
+// Nome do planeta ou da lua observada no modo 2
+string visionName(){
+    if(vision.moon < 0)
+        return get<0>(planets.planet[vision.planet]).getName();
+
+    // As luas do catálogo estão agrupadas por planeta
+    vector<BodyInfo> info = moonCatalogue();
+    int n = 0;
+    for(unsigned int i = 0; i < info.size(); i++)
+        if(info[i].parent == vision.planet and n++ == vision.moon)
+            return info[i].name;
+    return "";
+}//visionName
+
+// Comandos do modo atual, mostrados na ajuda
+vector<string> commands(){
+    vector<string> x;
+    if(mode == 1 or mode == 2){
+        x.push_back("P      pausa");
+        x.push_back("M, +   aumenta a velocidade");
+        x.push_back("N, -   diminui a velocidade");
+    }
+    if(mode == 2){
+        x.push_back("<, >   troca de planeta");
+        x.push_back("^, v   troca de lua");
+        x.push_back("T      terra plana");
+    }
+    if(mode == 3){
+        x.push_back("W,A,S,D  movimentação");
+        x.push_back("Q, E   rotação");
+        x.push_back("^, v   velocidade da nave");
+    }
+    x.push_back("V      escala real");
+    x.push_back("R      grava vídeo");
+    x.push_back("O      perfil na tela");
+    x.push_back("F      grava o perfil");
+    x.push_back("Z      profundidade");
+    x.push_back("1,2,3  troca de modo");
+    x.push_back("H      esconde a ajuda");
+    x.push_back("ESC    fecha a aplicação");
+    return x;
+}//commands
+
+// Monta o texto da tela: estado em cima à esquerda, tempos em cima à
+// direita e a ajuda embaixo. Só é refeito quando o estado muda ou a cada
+// 250 ms (fps e tempos), e o Hud só reenvia o buffer se o texto mudou
+void updateHud(){
+    double now = Controls::now();
+    if(hudLast > 0.0)
+        hudFrameMs += 0.1f * (1000.0f * (float) (now - hudLast) - hudFrameMs);
+    hudLast = now;
+
+    unsigned long long h = FrameThrottle::seed();
+    bool recording = recorder.active();
+    AssetState shipState = ship.model.getState();
+    FrameThrottle::hash(h, &mode, sizeof(mode));
+    FrameThrottle::hash(h, &vision, sizeof(vision));
+    FrameThrottle::hash(h, &Planet::worldSpeed, sizeof(Planet::worldSpeed));
+    FrameThrottle::hash(h, &Planet::pause, sizeof(Planet::pause));
+    FrameThrottle::hash(h, &Sun::trueScale, sizeof(Sun::trueScale));
+    FrameThrottle::hash(h, &ship.speed, sizeof(ship.speed));
+    FrameThrottle::hash(h, &Depth::mode, sizeof(Depth::mode));
+    FrameThrottle::hash(h, &help, sizeof(help));
+    FrameThrottle::hash(h, &recording, sizeof(recording));
+    FrameThrottle::hash(h, &profiler.visible, sizeof(profiler.visible));
+    FrameThrottle::hash(h, &shipState, sizeof(shipState));
+    FrameThrottle::hash(h, &SCR_WIDTH, sizeof(SCR_WIDTH));
+    FrameThrottle::hash(h, &SCR_HEIGHT, sizeof(SCR_HEIGHT));
+    if(h == hudState and now - hudTime < 0.25)
+        return;
+    hudState = h;
+    hudTime = now;
+
+    glm::vec4 white(1.0f, 1.0f, 1.0f, 0.9f);
+    glm::vec4 grey(0.7f, 0.7f, 0.7f, 0.9f);
+    glm::vec4 yellow(1.0f, 0.85f, 0.4f, 0.9f);
+    char line[96];
+
+    hud.begin();
+
+    // Estado
+    switch(mode){
+        case 1: hud.text(0, 0, "Modo 1 - visão global", white, SCR_WIDTH, SCR_HEIGHT); break;
+        case 2: hud.text(0, 0, "Modo 2 - " + visionName(), white, SCR_WIDTH, SCR_HEIGHT); break;
+        case 3: hud.text(0, 0, ship.model.get() ? "Modo 3 - nave" : "Modo 3 - nave (carregando)", white, SCR_WIDTH, SCR_HEIGHT); break;
+    }//switch
+    if(mode == 3)
+        snprintf(line, sizeof(line), "Velocidade da nave: %.0f", ship.speed);
+    else
+        snprintf(line, sizeof(line), "Velocidade do mundo: %dx%s", Planet::worldSpeed, Planet::pause ? " (pausado)" : "");
+    hud.text(0, 1, line, grey, SCR_WIDTH, SCR_HEIGHT);
+    hud.text(0, 2, "Profundidade: " + Depth::name() + (Sun::trueScale ? ", escala real" : ""), grey, SCR_WIDTH, SCR_HEIGHT);
+    if(recording)
+        hud.text(0, 3, "Gravando", yellow, SCR_WIDTH, SCR_HEIGHT);
+    hud.text(0, 4, GLState::status(), grey, SCR_WIDTH, SCR_HEIGHT);
+    if(not arenaPlanets.empty())
+        hud.text(0, 5, arena.status(), grey, SCR_WIDTH, SCR_HEIGHT);
+
+    // Tempos: frame medido aqui e soma das médias dos passos do perfil
+    float cpu = 0.0f, gpu = 0.0f;
+    vector<string> names = profiler.names();
+    for(unsigned int i = 0; i < names.size(); i++){
+        cpu += profiler.cpuStats(names[i]).avg;
+        gpu += profiler.gpuStats(names[i]).avg;
+    }
+    snprintf(line, sizeof(line), "%.0f fps  %.2f ms", hudFrameMs > 0.0f ? 1000.0f / hudFrameMs : 0.0f, hudFrameMs);
+    hud.text(-(int) strlen(line), 0, line, white, SCR_WIDTH, SCR_HEIGHT);
+    snprintf(line, sizeof(line), "CPU %.2f ms  GPU %.2f ms", cpu, gpu);
+    hud.text(-(int) strlen(line), 1, line, grey, SCR_WIDTH, SCR_HEIGHT);
+    string memory = Residency::status();
+    hud.text(-(int) memory.size(), 2, memory, grey, SCR_WIDTH, SCR_HEIGHT);
+    if(terrainBody >= 0){
+        string blocks = get<0>(planets.planet[terrainBody]).getName() + " - " + terrain.status();
+        hud.text(-(int) blocks.size(), 3, blocks, grey, SCR_WIDTH, SCR_HEIGHT);
+    }
+    for(unsigned int i = 0; i < virtualTextures.size(); i++)
+        if(virtualTextures[i]->ready()){
+            string pages = virtualTextures[i]->status();
+            hud.text(-(int) pages.size(), 4 + i, pages, grey, SCR_WIDTH, SCR_HEIGHT);
+        }
+
+    // Passos do perfil, ao lado das barras
+    profiler.labels(hud, SCR_WIDTH, SCR_HEIGHT);
+
+    // Ajuda
+    if(help){
+        vector<string> x = commands();
+        for(unsigned int i = 0; i < x.size(); i++)
+            hud.text(0, (int) i - (int) x.size(), x[i], yellow, SCR_WIDTH, SCR_HEIGHT);
+    }
+    else
+        hud.text(0, -1, "H      comandos", grey, SCR_WIDTH, SCR_HEIGHT);
+
+    hud.end();
+}//updateHud
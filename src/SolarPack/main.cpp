@@ -0,0 +1,178 @@
+// Empacotador de assets: junta os arquivos de um ou mais diretórios num
+// pacote só (includes/solarsystem/pack.h), lido pelo visualizador com --pack.
+// Roda na raiz do projeto: os caminhos guardados são os relativos a ela
+// ("resources/objects/..."), os mesmos que o visualizador pede.
+
+#include <solarsystem/mipchain.h>
+#include <solarsystem/pack.h>
+#include <solarsystem/vfs.h>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Mostra as opções
+void usage(){
+    cout << "uso: SolarPack [opções] SAÍDA.pack DIRETÓRIO..." << endl;
+    cout << "     SolarPack --list PACOTE" << endl;
+    cout << "  --align N     alinhamento dos dados de cada arquivo (padrão 4096)" << endl;
+    cout << "  --store       não comprime nenhum arquivo" << endl;
+    cout << "  --mips        gera e inclui a cadeia de mips (.mips) de cada imagem" << endl;
+}//usage
+
+string extension(const string &file){
+    size_t dot = file.find_last_of('.');
+    if(dot == string::npos or file.find('/', dot) != string::npos)
+        return "";
+    string x = file.substr(dot + 1);
+    transform(x.begin(), x.end(), x.begin(), ::tolower);
+    return x;
+}//extension
+
+bool isImage(const string &file){
+    string x = extension(file);
+    return x == "png" or x == "jpg" or x == "jpeg" or x == "tga" or x == "bmp";
+}//isImage
+
+// Arquivos de um diretório e dos subdiretórios; temporários e caches que só
+// valem no disco (páginas das texturas virtuais) ficam de fora
+void collect(const string &path, vector<string> &files){
+    struct stat st;
+    if(stat(path.c_str(), &st) != 0)
+        return;
+    if(not S_ISDIR(st.st_mode)){
+        string x = extension(path);
+        if(x != "tmp" and x != "vt" and x != "pack")
+            files.push_back(path);
+        return;
+    }
+
+    DIR *dir = opendir(path.c_str());
+    if(not dir)
+        return;
+    for(struct dirent *entry = readdir(dir); entry; entry = readdir(dir)){
+        string name = entry->d_name;
+        if(name != "." and name != "..")
+            collect(path + "/" + name, files);
+    }
+    closedir(dir);
+}//collect
+
+// Lista as entradas de um pacote
+int list(const string &file){
+    Pack pack;
+    if(not pack.open(file)){
+        cerr << "Não é um pacote válido: " << file << endl;
+        return 1;
+    }
+
+    // Na ordem do arquivo
+    vector<const PackEntry*> entries = pack.entries();
+    sort(entries.begin(), entries.end(), [](const PackEntry *a, const PackEntry *b){ return a->offset < b->offset; });
+    uint64_t stored = 0, raw = 0;
+    for(unsigned int i = 0; i < entries.size(); i++){
+        const PackEntry &e = *entries[i];
+        printf("%12llu %12llu %s %s\n", (unsigned long long) e.rawSize, (unsigned long long) e.size,
+               e.flags & PACK_LZ4 ? "lz4" : "   ", pack.name(e).c_str());
+        stored += e.size;
+        raw += e.rawSize;
+    }
+    printf("%u arquivos, %.1f MB (%.1f MB guardados)\n", pack.count(), raw / 1048576.0, stored / 1048576.0);
+    return 0;
+}//list
+
+int main(int argc, char **argv){
+    string output;
+    vector<string> inputs;
+    unsigned int alignment = 4096;
+    bool store = false, mips = false;
+
+    for(int i = 1; i < argc; i++){
+        string arg = argv[i];
+        bool value = i + 1 < argc;
+
+        if(arg == "--list" and value)
+            return list(argv[++i]);
+        else if(arg == "--align" and value)
+            alignment = max(1, atoi(argv[++i]));
+        else if(arg == "--store")
+            store = true;
+        else if(arg == "--mips")
+            mips = true;
+        else if(arg.compare(0, 2, "--") == 0){
+            usage();
+            return arg == "--help" ? 0 : 1;
+        }
+        else if(output.empty())
+            output = arg;
+        else
+            inputs.push_back(arg);
+    }
+    if(output.empty() or inputs.empty()){
+        usage();
+        return 1;
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<string> files;
+    for(unsigned int i = 0; i < inputs.size(); i++)
+        collect(Vfs::normalize(inputs[i]), files);
+
+    // A cadeia de mips é gravada ao lado da imagem e entra no pacote sem compressão:
+    // o visualizador lê um nível direto do mapeamento
+    if(mips){
+        unsigned int built = 0;
+        for(unsigned int i = 0, n = files.size(); i < n; i++){
+            MipInfo info;
+            vector<vector<unsigned char> > levels;
+            if(not isImage(files[i]) or not MipChain::info(files[i], info))
+                continue;
+            if(find(files.begin(), files.end(), files[i] + ".mips") != files.end())
+                continue;
+            if(MipChain::read(files[i], info.levels - 1, info, levels)){
+                files.push_back(files[i] + ".mips");
+                built++;
+            }
+        }
+        cout << built << " cadeias de mips geradas" << endl;
+    }
+
+    // Em ordem de caminho: os arquivos de um modelo (obj, mtl, texturas) ficam vizinhos
+    sort(files.begin(), files.end());
+    files.erase(unique(files.begin(), files.end()), files.end());
+
+    PackWriter writer;
+    writer.alignment = alignment;
+    uint64_t raw = 0;
+    unsigned int compressed = 0;
+    for(unsigned int i = 0; i < files.size(); i++){
+        vector<unsigned char> bytes;
+        if(not Vfs::read(files[i], bytes)){
+            cerr << "Não foi possível ler " << files[i] << endl;
+            return 1;
+        }
+        // Imagens comprimidas não ganham nada; as cadeias de mips precisam ficar mapeáveis
+        string x = extension(files[i]);
+        bool compress = not store and x != "png" and x != "jpg" and x != "jpeg" and x != "mips";
+        compressed += writer.add(Vfs::normalize(files[i]), bytes, compress);
+        raw += bytes.size();
+    }
+
+    if(not writer.write(output)){
+        cerr << "Não foi possível gravar " << output << endl;
+        return 1;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("%s: %u arquivos (%u comprimidos), %.1f MB -> %.1f MB em %.1f s\n", output.c_str(), (unsigned int) files.size(),
+           compressed, raw / 1048576.0, writer.stored() / 1048576.0, seconds);
+    return 0;
+}//main
@@ -0,0 +1,195 @@
+// Simulador sem janela: avança o sistema solar N passos e grava o estado.
+// Não usa OpenGL nem GLFW, roda em servidores sem tela.
+
+#include <solarsystem/simulation.h>
+#include <solarsystem/stressscene.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// Mostra as opções
+void usage(){
+    cout << "uso: SolarSim [opções]" << endl;
+    cout << "  --steps N       passos da simulação (padrão 1000)" << endl;
+    cout << "  --dt S          segundos por passo (padrão 0.016)" << endl;
+    cout << "  --warp W        velocidade do mundo, como M/N no visualizador (padrão 5)" << endl;
+    cout << "  --true-scale    tamanhos e distâncias reais" << endl;
+    cout << "  --dump ARQUIVO  grava o estado em CSV ('-' para a saída padrão)" << endl;
+    cout << "  --every K       grava o estado a cada K passos (padrão: só no final)" << endl;
+    cout << "  --scene N:M:K   cena sintética: N planetas com M luas cada e K asteroides," << endl;
+    cout << "                  com o tempo de cada estágio (matrizes, culling, envio)" << endl;
+    cout << "  --sweep         mede a cena sintética de 10 a --sweep-max corpos (CSV na saída), com as" << endl;
+    cout << "                  M luas por planeta do --scene (padrão 4; N e K são ignorados)" << endl;
+    cout << "  --sweep-max B   maior cena do --sweep (padrão 1000000)" << endl;
+}//usage
+
+/** Roda a cena sintética e mostra o tempo médio de cada estágio
+    * @param scene - Cena já gerada
+    * @param steps - Passos
+    * @param dt - Segundos por passo
+    * @return tempos médios por passo (ms)
+    */
+StageTimes measure(StressScene &scene, unsigned long steps, float dt){
+    glm::mat4 viewProj = scene.overview(4.0f / 3.0f);
+    StageTimes total = {0.0, 0.0, 0.0};
+    for(unsigned long i = 0; i < steps; i++){
+        Simulation::tick(dt);
+        StageTimes t = scene.step(viewProj);
+        total.transforms += t.transforms;
+        total.cull += t.cull;
+        total.submit += t.submit;
+    }
+    total.transforms /= steps;
+    total.cull /= steps;
+    total.submit /= steps;
+    return total;
+}//measure
+
+// Uma cena sintética com --steps passos
+int runScene(unsigned int n, unsigned int m, unsigned int k, unsigned long steps, float dt){
+    StressScene scene;
+    scene.generate(n, m, k);
+    StageTimes t = measure(scene, max(steps, 1ul), dt);
+
+    double bodies = scene.bodies();
+    cerr << scene.planets.size() << " planetas, " << scene.moons.size() << " luas, " << scene.asteroids.size()
+         << " asteroides (" << scene.visible.size() << " visíveis), " << steps << " passos" << endl;
+    cerr << "  matrizes " << t.transforms << " ms (" << 1e6 * t.transforms / bodies << " ns/corpo)" << endl;
+    cerr << "  culling  " << t.cull << " ms (" << 1e6 * t.cull / bodies << " ns/corpo)" << endl;
+    cerr << "  envio    " << t.submit << " ms (" << 1e6 * t.submit / max(scene.visible.size(), (size_t) 1) << " ns/visível)" << endl;
+    return 0;
+}//runScene
+
+/** Mede cenas de 10 até o máximo de corpos, multiplicando por 10: metade
+    * asteroides, o resto planetas com M luas cada. Grava a tabela em CSV na
+    * saída padrão e mostra onde cada estágio deixou de escalar (custo por
+    * corpo 50% acima do melhor das cenas menores).
+    */
+int runSweep(unsigned int m, unsigned long largest, float dt){
+    const char *names[3] = {"matrizes", "culling", "envio"};
+    double best[3] = {1e30, 1e30, 1e30};
+    unsigned long breaks[3] = {0, 0, 0};
+
+    cout << "bodies,planets,moons,asteroids,visible,steps,transforms_ms,cull_ms,submit_ms,"
+            "transforms_ns_body,cull_ns_body,submit_ns_visible\n";
+    for(unsigned long target = 10; target <= largest; target *= 10){
+        unsigned int k = target / 2;
+        unsigned int n = max(1ul, (target - k) / (1 + m));
+        StressScene scene;
+        scene.generate(n, m, k);
+
+        unsigned long steps = max(3ul, 2000000ul / target);
+        StageTimes t = measure(scene, steps, dt);
+
+        double bodies = scene.bodies();
+        double shown = max(scene.visible.size(), (size_t) 1);
+        double cost[3] = {1e6 * t.transforms / bodies, 1e6 * t.cull / bodies, 1e6 * t.submit / shown};
+        cout << scene.bodies() << "," << n << "," << scene.moons.size() << "," << k << "," << scene.visible.size() << ","
+             << steps << "," << t.transforms << "," << t.cull << "," << t.submit << ","
+             << cost[0] << "," << cost[1] << "," << cost[2] << "\n";
+
+        for(int i = 0; i < 3; i++){
+            if(not breaks[i] and cost[i] > 1.5 * best[i])
+                breaks[i] = scene.bodies();
+            best[i] = min(best[i], cost[i]);
+        }
+    }
+
+    for(int i = 0; i < 3; i++){
+        if(breaks[i])
+            cerr << names[i] << ": deixa de escalar em " << breaks[i] << " corpos" << endl;
+        else
+            cerr << names[i] << ": escala até " << largest << " corpos" << endl;
+    }
+    return 0;
+}//runSweep
+
+int main(int argc, char **argv){
+    unsigned long steps = 1000;
+    float dt = 0.016f;
+    string dump;
+    unsigned long every = 0;
+    unsigned int scene[3] = {0, 0, 0};
+    bool sceneGiven = false;
+    bool sweep = false;
+    unsigned long sweepMax = 1000000;
+
+    for(int i = 1; i < argc; i++){
+        string arg = argv[i];
+        bool value = i + 1 < argc;
+
+        if(arg == "--steps" and value)
+            steps = strtoul(argv[++i], NULL, 10);
+        else if(arg == "--dt" and value)
+            dt = atof(argv[++i]);
+        else if(arg == "--warp" and value)
+            Planet::worldSpeed = atoi(argv[++i]);
+        else if(arg == "--true-scale")
+            Sun::setTrueScale(true);
+        else if(arg == "--dump" and value)
+            dump = argv[++i];
+        else if(arg == "--every" and value)
+            every = strtoul(argv[++i], NULL, 10);
+        else if(arg == "--scene" and value)
+            sceneGiven = sscanf(argv[++i], "%u:%u:%u", &scene[0], &scene[1], &scene[2]) >= 2;
+        else if(arg == "--sweep")
+            sweep = true;
+        else if(arg == "--sweep-max" and value)
+            sweepMax = strtoul(argv[++i], NULL, 10);
+        else{
+            usage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    // Cenas sintéticas no lugar do sistema solar
+    if(sweep)
+        return runSweep(sceneGiven ? scene[1] : 4, sweepMax, dt);
+    if(scene[0] or scene[2])
+        return runScene(scene[0], scene[1], scene[2], steps, dt);
+
+    Simulation simulation;
+
+    // Saída do estado
+    ofstream file;
+    ostream *out = NULL;
+    if(dump == "-")
+        out = &cout;
+    else if(not dump.empty()){
+        file.open(dump.c_str());
+        if(not file){
+            cerr << "ERROR::SOLARSIM:: Não foi possível abrir " << dump << endl;
+            return 1;
+        }
+        out = &file;
+    }
+    if(out)
+        *out << "step,time,body,x,y,z\n";
+
+    // Avança a simulação
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for(unsigned long i = 0; i < steps; i++){
+        simulation.step(dt);
+        if(out and every and simulation.steps % every == 0)
+            simulation.dump(*out);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if(out and (not every or steps % every != 0))
+        simulation.dump(*out);
+
+    // Vazão da simulação pura (sem a gravação, quando --every não é usado)
+    unsigned long bodies = simulation.planets.size() + simulation.moons.size();
+    cerr << steps << " passos, " << bodies << " corpos em " << seconds << " s: "
+         << steps / seconds << " passos/s, "
+         << (steps * bodies) / seconds << " corpos/s" << endl;
+
+    return 0;
+}//main
@@ -0,0 +1,46 @@
+#include <solarsystem/catalogue.h>
+#include <solarsystem/planet.h>
+
+// Sol
+BodyInfo sunCatalogue(){
+    BodyInfo sun = {"Sun", "resources/objects/Sun/sun.obj", 150000, 0, 0, 0, -1, 1392700, 0}; // 109 vezes o tamanho da Terra
+    return sun;
+}//sunCatalogue
+
+// Planetas
+vector<BodyInfo> planetCatalogue(){
+    BodyInfo planets[] = {
+        {"Mercury", "resources/objects/Planets/mercury/mercury.obj", 4879,   1, 0.5, 0.5,  -1, 4879,   0.387},
+        {"Venus",   "resources/objects/Planets/venus/venus.obj",     12103,  2, -1,  0.75, -1, 12104,  0.723},
+        {"Earth",   "resources/objects/Planets/earth/earth.obj",     12756,  3, 1.5, 1,    -1, 12756,  1.0},
+        {"Mars",    "resources/objects/Planets/mars/mars.obj",       6792,   4, 2,   1.25, -1, 6792,   1.524},
+        {"Jupiter", "resources/objects/Planets/jupiter/jupiter.obj", 142984, 5, 2.5, 2.75, -1, 142984, 5.203},
+        {"Saturn",  "resources/objects/Planets/saturn/saturn.obj",   120573, 6, 3,   5.0,  -1, 120536, 9.537},
+        {"Uranus",  "resources/objects/Planets/uranus/uranus.obj",   51118,  7, 3.5, 6.25, -1, 51118,  19.19},
+        {"Neptune", "resources/objects/Planets/neptune/neptune.obj", 49528,  8, 4,   7.25, -1, 49528,  30.07}
+    };
+    return vector<BodyInfo>(planets, planets + 8);
+}//planetCatalogue
+
+// Luas (distância real convertida de km para UA)
+vector<BodyInfo> moonCatalogue(){
+    BodyInfo moons[] = {
+        // Luas da Terra
+        {"Moon",     "resources/objects/Moons/Earth/Moon/moon.obj",           12756/4,     1.0, Planet::days, 0.07, 2, 3475, 384400  / Planet::KM},
+        // Luas de Jupiter
+        {"Io",       "resources/objects/Moons/Jupiter/Io/io.obj",             142984/7,    1,   0.5,          0.6,  4, 3643, 421700  / Planet::KM},
+        {"Europa",   "resources/objects/Moons/Jupiter/Europa/europa.obj",     142984/7.5,  2,   1,            0.85, 4, 3122, 671034  / Planet::KM},
+        {"Ganymede", "resources/objects/Moons/Jupiter/Ganymede/ganymede.obj", 142984/5,    3,   1.5,          1.1,  4, 5268, 1070412 / Planet::KM},
+        {"Callisto", "resources/objects/Moons/Jupiter/Callisto/callisto.obj", 142984/6,    4,   2,            1.35, 4, 4821, 1882709 / Planet::KM},
+        // Lua de Saturno
+        {"Titan",    "resources/objects/Moons/Saturn/Titan/titan.obj",        120573/4,    1,   0.5,          0.6,  5, 5150, 1221870 / Planet::KM},
+        // Luas de Urano
+        {"Ariel",    "resources/objects/Moons/Uranus/Ariel/ariel.obj",        51118/5,     1,   0.5,          0.3,  6, 1158, 191020  / Planet::KM},
+        {"Umbriel",  "resources/objects/Moons/Uranus/Umbriel/umbriel.obj",    51118/5,     2,   1.0,          0.4,  6, 1169, 266000  / Planet::KM},
+        {"Titania",  "resources/objects/Moons/Uranus/Titania/titania.obj",    51118/5,     3,   1.5,          0.5,  6, 1577, 435910  / Planet::KM},
+        {"Oberon",   "resources/objects/Moons/Uranus/Oberon/oberon.obj",      51118/5,     4,   2,            0.6,  6, 1523, 583520  / Planet::KM},
+        // Luas de Netuno
+        {"Triton",   "resources/objects/Moons/Neptune/Triton/triton.obj",     49528/4,     1,   0.5,          0.3,  7, 2707, 354759  / Planet::KM}
+    };
+    return vector<BodyInfo>(moons, moons + 11);
+}//moonCatalogue
@@ -0,0 +1,17 @@
+#include <solarsystem/sun.h>
+#include <solarsystem/planet.h>
+#include <solarsystem/moon.h>
+
+// Variaveis estáticas do núcleo da simulação
+
+float Sun::size = 0.000001;
+bool  Sun::trueScale = false;
+
+float Planet::UA    	 = 1;
+float Planet::days  	 = 5;
+float Planet::years 	 = 10;
+bool  Planet::plane 	 = false;
+int   Planet::worldSpeed = 5;
+bool  Planet::pause 	 = false;
+float Planet::time 		 = 0;
+float Planet::KM   		 = 149597870.7;